@@ -33,6 +33,8 @@
 #include "../ifcgeom/IfcGeomFilter.h"
 #include "../ifcgeom/IfcGeomRenderStyles.h"
 #include "../ifcgeom/Iterator.h"
+#include "../ifcgeom/Profiler.h"
+#include "../ifcparse/IfcSnapshot.h"
 #include "../ifcparse/utils.h"
 #include "../serializers/ColladaSerializer.h"
 #include "../serializers/GltfSerializer.h"
@@ -212,7 +214,7 @@ size_t read_filters_from_file(const std::string&, inclusion_filter&, inclusion_t
 void parse_filter(geom_filter&, const std::vector<std::string>&);
 std::vector<IfcGeom::filter_t> setup_filters(const std::vector<geom_filter>&, const std::string&);
 
-bool init_input_file(const std::string& filename, IfcParse::IfcFile*& ifc_file, bool no_progress, bool mmap);
+bool init_input_file(const std::string& filename, IfcParse::IfcFile*& ifc_file, bool no_progress, bool mmap, int parse_threads, const std::string& snapshot_filename);
 
 // from https://stackoverflow.com/questions/31696328/boost-program-options-using-zero-parameter-options-multiple-times
 struct verbosity_counter {
@@ -243,6 +245,11 @@ int IfcMain(int argc, char** argv) {
     path_t default_material_filename;
     path_t log_file;
     path_t cache_file;
+    path_t snapshot_file;
+    path_t geometry_cache_dir;
+    int geometry_cache_size;
+    path_t incremental_manifest_file;
+    path_t profile_file;
     std::string log_format;
     std::string geometry_kernel;
 
@@ -259,15 +266,25 @@ int IfcMain(int argc, char** argv) {
 #ifdef USE_MMAP
         ("mmap", "use memory-mapped file for input")
 #endif
-            ("input-file", new po::typed_value<path_t, char_t>(0), "input IFC file")("output-file", new po::typed_value<path_t, char_t>(0), "output geometry file")
+            ("input-file", new po::typed_value<path_t, char_t>(0), "input IFC file")("output-file", new po::typed_value<path_t, char_t>(0), "output geometry file")("snapshot", new po::typed_value<path_t, char_t>(&snapshot_file), "binary snapshot of the parsed input file, written after parsing. "
+                                                                                                                                                                                                      "On later runs the input file is read from the snapshot for as long as it is unchanged.")
+            ("geometry-cache", new po::typed_value<path_t, char_t>(&geometry_cache_dir), "directory of a geometry cache that is shared between runs. Triangulated representations that "
+                                                                                           "have been converted before with the same settings are read from the cache instead of converted again.")
+            ("geometry-cache-size", po::value<int>(&geometry_cache_size)->default_value(1024), "maximum size of the geometry cache in megabytes, the least recently used entries are removed. 0 does not limit the size.")
+            ("incremental", new po::typed_value<path_t, char_t>(&incremental_manifest_file), "manifest of the products converted in the previous run on a revision of the input file, which is "
+                                                                                                "replaced by the manifest of this run. Products that are unchanged are read from the geometry cache. Requires --geometry-cache.")
+            ("profile", new po::typed_value<path_t, char_t>(&profile_file), "write the time spent on mapping, conversion, boolean operations, triangulation and serialization "
+                                                                            "per IFC entity type, and the number of boolean operations processed in 2D and 3D, to the given file as JSON")
         // #ifdef WITH_HDF5
         //                 ("cache-file", new po::typed_value<path_t, char_t>(&cache_file), "geometry cache file")
         // #endif
         ;
 
+    int parse_threads;
+
     po::options_description ifc_options("IFC options");
     ifc_options.add_options()("calculate-quantities", "Calculate or fix the physical quantity definitions "
-                                                      "based on an interpretation of the geometry when exporting IFC");
+                                                      "based on an interpretation of the geometry when exporting IFC")("parse-threads", po::value<int>(&parse_threads)->default_value(1), "Number of parallel threads for parsing the input file, 0 uses the number of hardware threads.");
 
     int num_threads;
     std::string offset_str, rotation_str;
@@ -429,6 +446,10 @@ int IfcMain(int argc, char** argv) {
         Logger::Notice("Using " + std::to_string(num_threads) + " threads");
     }
 
+    if (parse_threads <= 0) {
+        parse_threads = std::thread::hardware_concurrency();
+    }
+
     if (vmap.count("log-format") == 1) {
         boost::to_lower(log_format);
         if (log_format == "plain") {
@@ -595,7 +616,7 @@ int IfcMain(int argc, char** argv) {
     if (output_extension == XML) {
         int exit_code = EXIT_FAILURE;
         try {
-            if (init_input_file(IfcUtil::path::to_utf8(input_filename), ifc_file, no_progress || quiet, mmap)) {
+            if (init_input_file(IfcUtil::path::to_utf8(input_filename), ifc_file, no_progress || quiet, mmap, parse_threads, IfcUtil::path::to_utf8(snapshot_file))) {
                 time_t start, end;
                 time(&start);
                 XmlSerializer s(ifc_file, IfcUtil::path::to_utf8(output_temp_filename));
@@ -615,7 +636,7 @@ int IfcMain(int argc, char** argv) {
     } else if (output_extension == IFC) {
         int exit_code = EXIT_FAILURE;
         try {
-            if (init_input_file(IfcUtil::path::to_utf8(input_filename), ifc_file, no_progress || quiet, mmap)) {
+            if (init_input_file(IfcUtil::path::to_utf8(input_filename), ifc_file, no_progress || quiet, mmap, parse_threads, IfcUtil::path::to_utf8(snapshot_file))) {
                 time_t start, end;
                 time(&start);
                 std::ofstream fs(output_filename.c_str());
@@ -623,7 +644,7 @@ int IfcMain(int argc, char** argv) {
                     if (vmap.count("calculate-quantities")) {
                         fix_quantities(*ifc_file, no_progress, quiet, stderr_progress);
                     }
-                    fs << *ifc_file;
+                    ifc_file->write(fs, num_threads);
                     exit_code = EXIT_SUCCESS;
                 } else {
                     Logger::Error("Unable to open output file for writing");
@@ -870,7 +891,7 @@ int IfcMain(int argc, char** argv) {
     time_t start, end;
     time(&start);
 
-    if (!init_input_file(IfcUtil::path::to_utf8(input_filename), ifc_file, no_progress || quiet, mmap)) {
+    if (!init_input_file(IfcUtil::path::to_utf8(input_filename), ifc_file, no_progress || quiet, mmap, parse_threads, IfcUtil::path::to_utf8(snapshot_file))) {
         write_log(!quiet);
         serializer.reset();
         IfcUtil::path::delete_file(IfcUtil::path::to_utf8(output_temp_filename)); /**< @todo Windows Unicode support */
@@ -883,7 +904,10 @@ int IfcMain(int argc, char** argv) {
         Logger::SetOutput(quiet ? nullptr : &cout_, vcounter.count > 1 ? &cout_ : &log_stream);
     }
 
-    if (is_tesselated && (center_model || center_model_geometry)) {
+    // Centering on the mesh vertices is done after conversion, on the elements
+    // retained by the iterator, see below. Centering on the placements only
+    // requires the placements to be mapped.
+    if (is_tesselated && center_model && !center_model_geometry) {
         std::vector<double> offset(3);
 
         IfcGeom::Iterator tmp_context_iterator(geometry_kernel, geometry_settings, ifc_file, filter_funcs, num_threads);
@@ -894,19 +918,7 @@ int IfcMain(int argc, char** argv) {
             Logger::Status("Computing bounds...");
         }
 
-        if (center_model_geometry) {
-            if (!tmp_context_iterator.initialize()) {
-                /// @todo It would be nice to know and print separate error prints for a case where we found no entities
-                /// and for a case we found no entities that satisfy our filtering criteria.
-                Logger::Notice("No geometrical elements found or none successfully converted");
-                serializer.reset();
-                IfcUtil::path::delete_file(IfcUtil::path::to_utf8(output_temp_filename));
-                write_log(!quiet);
-                return EXIT_FAILURE;
-            }
-        }
-
-        tmp_context_iterator.compute_bounds(center_model_geometry);
+        tmp_context_iterator.compute_bounds(false);
 
         time(&end);
         if (!quiet) {
@@ -934,9 +946,38 @@ int IfcMain(int argc, char** argv) {
         geometry_settings.get<ifcopenshell::geometry::settings::OutputDimensionality>().value = ifcopenshell::geometry::settings::CURVES;
     }
 
+    if (is_tesselated && center_model_geometry && geometry_settings.get<ifcopenshell::geometry::settings::StreamingWindow>().get() > 0) {
+        Logger::Notice("Streaming window setting ignored when centering on the model geometry");
+        geometry_settings.get<ifcopenshell::geometry::settings::StreamingWindow>().value = 0;
+    }
+
+    // Declared before the iterator, because the iterator writes to the cache until it is destroyed
+    std::unique_ptr<IfcGeom::GeometryCache> geometry_cache;
+    if (!elems_from_adaptor && is_tesselated && vmap.count("geometry-cache")) {
+        geometry_cache.reset(new IfcGeom::GeometryCache(IfcUtil::path::to_utf8(geometry_cache_dir), (uint64_t)(std::max)(geometry_cache_size, 0) * 1024 * 1024));
+    }
+
+    std::unique_ptr<IfcGeom::IncrementalManifest> incremental_manifest;
+    if (vmap.count("incremental")) {
+        if (!geometry_cache) {
+            Logger::Notice("Incremental conversion requires a geometry cache and triangulated output, all products are converted");
+        } else {
+            incremental_manifest.reset(new IfcGeom::IncrementalManifest);
+            if (!incremental_manifest->read(IfcUtil::path::to_utf8(incremental_manifest_file))) {
+                Logger::Notice("No manifest of a previous run at " + IfcUtil::path::to_utf8(incremental_manifest_file) + ", all products are converted");
+            }
+        }
+    }
+
+    if (vmap.count("profile")) {
+        IfcGeom::Profiler::enable(true);
+    }
+
     std::unique_ptr<IfcGeom::Iterator> context_iterator;
     if (!elems_from_adaptor) {
         context_iterator.reset(new IfcGeom::Iterator(geometry_kernel, geometry_settings, ifc_file, filter_funcs, num_threads));
+        context_iterator->set_geometry_cache(geometry_cache.get());
+        context_iterator->set_incremental_manifest(incremental_manifest.get());
     }
 
     // #if defined(WITH_HDF5) && defined(IFOPSH_WITH_OPENCASCADE)
@@ -962,6 +1003,38 @@ int IfcMain(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
+    if (context_iterator && is_tesselated && center_model_geometry) {
+        time_t start, end;
+        time(&start);
+        if (!quiet) {
+            Logger::Status("Computing bounds...");
+        }
+
+        // The elements are converted once and retained by the iterator, which is
+        // rewound after computing the bounds to serialize the translated elements.
+        context_iterator->compute_bounds(true);
+
+        time(&end);
+        if (!quiet) {
+            Logger::Status("Done ! Bounds computed in " + format_duration(start, end));
+        }
+
+        auto center = (context_iterator->bounds_min().ccomponents() + context_iterator->bounds_max().ccomponents()) * 0.5;
+
+        std::stringstream msg;
+        msg << std::setprecision(std::numeric_limits<double>::max_digits10) << "Using model offset (" << -center(0) << "," << -center(1) << "," << -center(2) << ")";
+        Logger::Notice(msg.str());
+
+        context_iterator->translate_elements(-center(0), -center(1), -center(2));
+        if (!context_iterator->rewind()) {
+            Logger::Error("Unable to revisit the converted elements after computing the bounds");
+            serializer.reset();
+            IfcUtil::path::delete_file(IfcUtil::path::to_utf8(output_temp_filename));
+            write_log(!quiet);
+            return EXIT_FAILURE;
+        }
+    }
+
     serializer->setFile(ifc_file);
 
 #ifdef IFOPSH_WITH_OPENCASCADE
@@ -1072,10 +1145,13 @@ int IfcMain(int argc, char** argv) {
 
         IfcGeom::Element* geom_object = elems_from_adaptor ? *elems_from_adaptor_it : context_iterator->get();
 
-        if (is_tesselated) {
-            serializer->write(static_cast<const IfcGeom::TriangulationElement*>(geom_object));
-        } else {
-            serializer->write(static_cast<const IfcGeom::BRepElement*>(geom_object));
+        {
+            IfcGeom::Profiler::scope profile(IfcGeom::Profiler::SERIALIZATION, geom_object->type());
+            if (is_tesselated) {
+                serializer->write(static_cast<const IfcGeom::TriangulationElement*>(geom_object));
+            } else {
+                serializer->write(static_cast<const IfcGeom::BRepElement*>(geom_object));
+            }
         }
 
         if (!no_progress) {
@@ -1131,9 +1207,35 @@ int IfcMain(int argc, char** argv) {
                        " objects)                                ");
     }
 
-    serializer->finalize();
-    // Make sure the dtor is explicitly run here (e.g. output files are closed before renaming them).
-    serializer.reset();
+    if (geometry_cache) {
+        Logger::Notice("Geometry cache: " + std::to_string(geometry_cache->hits()) + " representations read, " +
+                       std::to_string(geometry_cache->misses()) + " not found, " + std::to_string(geometry_cache->writes()) + " written");
+    }
+
+    if (incremental_manifest) {
+        Logger::Notice("Incremental conversion: " + std::to_string(incremental_manifest->reused()) + " of " +
+                       std::to_string(incremental_manifest->recorded()) + " recorded products reused from the previous run");
+        if (!incremental_manifest->write(IfcUtil::path::to_utf8(incremental_manifest_file))) {
+            Logger::Error("Unable to write incremental manifest to " + IfcUtil::path::to_utf8(incremental_manifest_file));
+        }
+    }
+
+    {
+        // Serializers that write the output at the end, such as SVG, do most of their work here
+        IfcGeom::Profiler::scope profile(IfcGeom::Profiler::SERIALIZATION, "finalize");
+        serializer->finalize();
+        // Make sure the dtor is explicitly run here (e.g. output files are closed before renaming them).
+        serializer.reset();
+    }
+
+    if (vmap.count("profile")) {
+        std::ofstream profile_fs(profile_file.c_str());
+        if (profile_fs) {
+            IfcGeom::Profiler::write_json(profile_fs);
+        } else {
+            Logger::Error("Unable to write profile to " + IfcUtil::path::to_utf8(profile_file));
+        }
+    }
 
     Logger::Message(Logger::LOG_PERF, "done file geometry conversion");
 
@@ -1202,7 +1304,7 @@ void write_log(bool header) {
 
 #include <boost/algorithm/string/predicate.hpp>
 
-bool init_input_file(const std::string& filename, IfcParse::IfcFile*& ifc_file, bool no_progress, bool mmap) {
+bool init_input_file(const std::string& filename, IfcParse::IfcFile*& ifc_file, bool no_progress, bool mmap, int parse_threads, const std::string& snapshot_filename) {
     time_t start, end;
 
     // Prevent IfcFile::Init() prints by setting output to null temporarily
@@ -1218,12 +1320,18 @@ bool init_input_file(const std::string& filename, IfcParse::IfcFile*& ifc_file,
     } else
 #endif
 
-    {
+    if (!snapshot_filename.empty()) {
+#ifdef USE_MMAP
+        ifc_file = IfcParse::IfcSnapshot::open(filename, snapshot_filename, mmap, (unsigned int)parse_threads);
+#else
+        ifc_file = IfcParse::IfcSnapshot::open(filename, snapshot_filename, (unsigned int)parse_threads);
+#endif
+    } else {
 #ifdef USE_MMAP
-        ifc_file = new IfcParse::IfcFile(filename, mmap);
+        ifc_file = new IfcParse::IfcFile(filename, mmap, (unsigned int)parse_threads);
 #else
         (void)mmap;
-        ifc_file = new IfcParse::IfcFile(filename);
+        ifc_file = new IfcParse::IfcFile(filename, (unsigned int)parse_threads);
 #endif
     }
 
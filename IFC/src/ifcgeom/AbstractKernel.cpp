@@ -4,6 +4,7 @@
 #include "../ifcgeom/ConversionSettings.h"
 #include "../ifcgeom/abstract_mapping.h"
 #include "../ifcgeom/function_item_evaluator.h"
+#include "../ifcgeom/Profiler.h"
 
 #ifdef IFOPSH_WITH_OPENCASCADE
 #include "../ifcgeom/kernels/opencascade/OpenCascadeKernel.h"
@@ -37,6 +38,8 @@ bool ifcopenshell::geometry::kernels::AbstractKernel::convert(const taxonomy::pt
 		return fn();
 	};
 	auto process_with_upgrade = [&]() {
+		// Operands are converted in nested scopes, so that boolean operations are profiled separately
+		IfcGeom::Profiler::scope profile(item->kind() == taxonomy::BOOLEAN_RESULT ? IfcGeom::Profiler::BOOLEAN : IfcGeom::Profiler::CONVERSION, item->instance);
 		try {
 			return dispatch_conversion<0>::dispatch(this, item->kind(), item, results);
 		} catch (const not_implemented_error&) {
@@ -99,6 +102,7 @@ public:
 			}
 #endif
 			bool success = false;
+			k->triangulated_output_only = triangulated_output_only;
 			try {
 				success = k->convert(item, rs);
 			} catch(...) {}
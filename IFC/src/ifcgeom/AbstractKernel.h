@@ -39,6 +39,10 @@ namespace ifcopenshell {
 		Settings settings_;
 	public:
 		bool propagate_exceptions = false;
+		// Set by the converter when the shapes of the current representation are only
+		// going to be triangulated, so that kernels can skip building a boundary
+		// representation for input that can be triangulated directly.
+		bool triangulated_output_only = false;
 			
 		AbstractKernel(const std::string& geometry_library, const Settings& settings)
 			: geometry_library_(geometry_library)
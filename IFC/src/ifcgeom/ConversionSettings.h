@@ -108,6 +108,12 @@ namespace ifcopenshell {
 				static constexpr double defaultvalue = 0.5;
 			};
 
+			struct ParallelMeshingFaces : public SettingBase<ParallelMeshingFaces, int> {
+				static constexpr const char* const name = "parallel-meshing-faces";
+				static constexpr const char* const description = "Mesh a shape and copy the triangulation of its faces on multiple threads when it has at least this many faces. Avoids a long single-threaded tail for large terrains and faceted breps. Faces are emitted in the same order as when meshing on a single thread. Meshing only runs in parallel when all other hardware threads are not used by the conversion threads, because the mesher occupies every core. The faces are always read in parallel on the threads that are not used. 0 disables parallel meshing.";
+				static constexpr int defaultvalue = 0;
+			};
+
 			struct ReorientShells : public SettingBase<ReorientShells, bool> {
 				static constexpr const char* const name = "reorient-shells";
 				static constexpr const char* const description = "Specifies whether to orient the faces of IfcConnectedFaceSets. "
@@ -175,6 +181,12 @@ namespace ifcopenshell {
 				static constexpr bool defaultvalue = false;
 			};
 
+			struct ParallelOpeningSubtraction : public SettingBase<ParallelOpeningSubtraction, int> {
+				static constexpr const char* const name = "parallel-opening-subtraction";
+				static constexpr const char* const description = "Subtract openings from an element on multiple threads. An element that consists of at least this many solids, and at least two, is cut per solid in parallel. Otherwise every solid is split between its openings into pieces that are cut in parallel and fused afterwards. Every solid or piece is only cut by the openings of which the bounding box overlaps it. Only the hardware threads that are not used by the conversion threads are used. 0 disables parallel subtraction.";
+				static constexpr int defaultvalue = 0;
+			};
+
 			struct BooleanAttempt2d : public SettingBase<BooleanAttempt2d, bool> {
 				static constexpr const char* const name = "boolean-attempt-2d";
 				static constexpr const char* const description = "Do not attempt to process boolean subtractions in 2D.";
@@ -192,6 +204,13 @@ namespace ifcopenshell {
 				static constexpr bool defaultvalue = true;
 			};
 
+			struct WeldTolerance : public SettingBase<WeldTolerance, double> {
+				static constexpr const char* const name = "weld-tolerance";
+				static constexpr const char* const description = "Distance in meters within which vertices of the same item are welded "
+					"when vertices are welded. The default of 0 only welds vertices with identical coordinates.";
+				static constexpr double defaultvalue = 0.;
+			};
+
 			struct UseWorldCoords : public SettingBase<UseWorldCoords, bool> {
 				static constexpr const char* const name = "use-world-coords";
 				static constexpr const char* const description = "Specifies whether to apply the local placements of building elements "
@@ -413,11 +432,41 @@ namespace ifcopenshell {
 				static constexpr TriangulationMethod defaultvalue = TRIANGLE_MESH;
 			};
 
+			struct DirectPolygonTriangulation : public SettingBase<DirectPolygonTriangulation, bool> {
+				static constexpr const char* const name = "direct-polygon-triangulation";
+				static constexpr const char* const description = "Triangulate the planar faces of faceted representation items (face sets and faceted breps) directly, without constructing an Open CASCADE boundary representation. Only applies when triangulated output is requested and the element is not subject to opening subtractions, layer sets or unified shapes. Items with non-planar or self-intersecting faces are converted as usual.";
+				static constexpr bool defaultvalue = false;
+			};
+
 			struct CgalEmitOriginalEdges : public SettingBase<CgalEmitOriginalEdges, bool> {
 				static constexpr const char* const name = "cgal-original-edges";
 				static constexpr const char* const description = "Try to emit original edge face boundary edges instead of recomputed ones based on face normal. Falls back to triangulated data in case of boolean operands and faces with holes.";
 				static constexpr bool defaultvalue = false;
 			};
+
+			struct OrderedOutput : public SettingBase<OrderedOutput, bool> {
+				static constexpr const char* const name = "ordered-output";
+				static constexpr const char* const description = "When converting on multiple threads, emit elements in the order in which their representations are found in the file, instead of in the order of completion. The most expensive representations are still converted first, but completed elements are held back until the ones before have finished.";
+				static constexpr bool defaultvalue = false;
+			};
+
+			struct StreamingWindow : public SettingBase<StreamingWindow, int> {
+				static constexpr const char* const name = "streaming-window";
+				static constexpr const char* const description = "Release converted elements as soon as the iterator has moved past them. When converting on multiple threads, conversion is suspended while this many converted elements are waiting to be consumed, so that memory use is bounded by the window rather than by the size of the model. 0 keeps all elements until the iterator is destroyed.";
+				static constexpr int defaultvalue = 0;
+			};
+
+			struct DeduplicateGeometry : public SettingBase<DeduplicateGeometry, bool> {
+				static constexpr const char* const name = "deduplicate-geometry";
+				static constexpr const char* const description = "Convert representations that are identical up to their placement only once, also when they are not shared by means of mapped items. The products are emitted as instances of a single geometry, with the placement of the representation items moved into the placement of the product. Does not apply to products with openings, world coordinates or layer sets.";
+				static constexpr bool defaultvalue = false;
+			};
+
+			struct NoCostOrdering : public SettingBase<NoCostOrdering, bool> {
+				static constexpr const char* const name = "no-cost-ordering";
+				static constexpr const char* const description = "When converting on multiple threads, convert the representations in the order in which they are found in the file, instead of the ones with the highest estimated cost first. An expensive representation found late may then keep a single thread busy after the others have run out of work.";
+				static constexpr bool defaultvalue = false;
+			};
 		}
 
 		template <typename settings_t>
@@ -510,7 +559,7 @@ namespace ifcopenshell {
 		};
 
 		class IFC_GEOM_API Settings : public SettingsContainer<
-                                          std::tuple<MesherLinearDeflection, MesherAngularDeflection, ReorientShells, LengthUnit, PlaneUnit, Precision, OutputDimensionality, LayersetFirst, DisableBooleanResult, NoWireIntersectionCheck, NoWireIntersectionTolerance, PrecisionFactor, DebugBooleanOperations, BooleanAttempt2d, SurfaceColour, WeldVertices, UseWorldCoords, UnifyShapes, UseMaterialNames, ConvertBackUnits, ContextIds, ContextTypes, ContextIdentifiers, IteratorOutput, DisableOpeningSubtractions, ApplyDefaultMaterials, DontEmitNormals, GenerateUvs, ApplyLayerSets, UseElementHierarchy, ValidateQuantities, EdgeArrows, BuildingLocalPlacement, SiteLocalPlacement, ForceSpaceTransparency, CircleSegments, KeepBoundingBoxes, ComputeCurvature, FunctionStepType, FunctionStepParam, NoParallelMapping, ModelOffset, ModelRotation, TriangulationType, CgalEmitOriginalEdges>
+                                          std::tuple<MesherLinearDeflection, MesherAngularDeflection, ParallelMeshingFaces, ReorientShells, LengthUnit, PlaneUnit, Precision, OutputDimensionality, LayersetFirst, DisableBooleanResult, NoWireIntersectionCheck, NoWireIntersectionTolerance, PrecisionFactor, DebugBooleanOperations, ParallelOpeningSubtraction, BooleanAttempt2d, SurfaceColour, WeldVertices, WeldTolerance, UseWorldCoords, UnifyShapes, UseMaterialNames, ConvertBackUnits, ContextIds, ContextTypes, ContextIdentifiers, IteratorOutput, DisableOpeningSubtractions, ApplyDefaultMaterials, DontEmitNormals, GenerateUvs, ApplyLayerSets, UseElementHierarchy, ValidateQuantities, EdgeArrows, BuildingLocalPlacement, SiteLocalPlacement, ForceSpaceTransparency, CircleSegments, KeepBoundingBoxes, ComputeCurvature, FunctionStepType, FunctionStepParam, NoParallelMapping, ModelOffset, ModelRotation, TriangulationType, DirectPolygonTriangulation, CgalEmitOriginalEdges, OrderedOutput, StreamingWindow, DeduplicateGeometry, NoCostOrdering>
 		>
 		{};
 }
@@ -1,6 +1,7 @@
 #include "Converter.h"
 
 #include "../ifcgeom/IfcGeomElement.h"
+#include "../ifcgeom/Profiler.h"
 
 using namespace ifcopenshell::geometry;
 
@@ -41,7 +42,23 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 	IfcGeom::Representation::BRep* shape;
 	IfcGeom::ConversionResults shapes;
 
-	if (!kernel_->convert(representation_node, shapes)) {
+	// Does the IfcElement have any IfcOpenings?
+	// Note that openings for IfcOpeningElements are not processed
+	auto openings = mapping_->find_openings(product);
+	const bool subtract_openings = !settings_.get<ifcopenshell::geometry::settings::DisableOpeningSubtractions>().get() && openings && openings->size();
+
+	// Without operations on the shapes after conversion, kernels can triangulate
+	// the items directly when only triangulated output is requested
+	kernel_->triangulated_output_only =
+		settings_.get<ifcopenshell::geometry::settings::DirectPolygonTriangulation>().get() &&
+		settings_.get<ifcopenshell::geometry::settings::IteratorOutput>().get() == ifcopenshell::geometry::settings::TRIANGULATED &&
+		!settings_.get<ifcopenshell::geometry::settings::ApplyLayerSets>().get() &&
+		!settings_.get<ifcopenshell::geometry::settings::UnifyShapes>().get() &&
+		!subtract_openings;
+
+	const bool converted = kernel_->convert(representation_node, shapes);
+	kernel_->triangulated_output_only = false;
+	if (!converted) {
 		return 0;
 	}
 
@@ -144,8 +161,10 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 	if (settings_.get<ifcopenshell::geometry::settings::ForceSpaceTransparency>().has() && product->declaration().is("IfcSpace")) {
 		for (auto& s : shapes) {
 			if (s.hasStyle()) {
-				// @todo the uglyness
-				const_cast<taxonomy::style*>(&*s.StylePtr())->transparency = settings_.get<ifcopenshell::geometry::settings::ForceSpaceTransparency>().get();
+				// The style is shared with other products, so the transparency is set on a copy
+				auto style = taxonomy::style::ptr(s.StylePtr()->clone_());
+				style->transparency = settings_.get<ifcopenshell::geometry::settings::ForceSpaceTransparency>().get();
+				s.setStyle(style);
 			}
 		}
 	}
@@ -165,11 +184,7 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 
 	const std::string product_type = product->declaration().name();
 
-	// Does the IfcElement have any IfcOpenings?
-	// Note that openings for IfcOpeningElements are not processed
-	auto openings = mapping_->find_openings(product);
-
-	if (!settings_.get<ifcopenshell::geometry::settings::DisableOpeningSubtractions>().get() && openings && openings->size()) {
+	if (subtract_openings) {
 		representation_id_builder << "-openings";
 		for (auto it = openings->begin(); it != openings->end(); ++it) {
 			representation_id_builder << "-" << (*it)->id();
@@ -200,6 +215,8 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 			if (opening_items.empty()) {
 				opened_shapes = shapes;
 			} else {
+				// Opening subtractions are profiled by the type of the product
+				IfcGeom::Profiler::scope profile(IfcGeom::Profiler::BOOLEAN, product);
 				kernel_->convert_openings(product, opening_items, shapes, *place, opened_shapes);
 			}
 		} catch (const std::exception& e) {
@@ -240,21 +257,8 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 
 	shape = new IfcGeom::Representation::BRep(settings_, product_type, representation_id_builder.str(), shapes);
 
-	std::string context_string = "";
-
 	// IfcShapeRepresentation.
-	const IfcUtil::IfcBaseEntity *representation = representation_node->instance->as<IfcUtil::IfcBaseEntity>();
-	auto representation_identifier = representation->get("RepresentationIdentifier");
-	if (!representation_identifier.isNull()) {
-		context_string = (std::string) representation_identifier;
-	}
-	else {
-		IfcUtil::IfcBaseClass *context = (IfcUtil::IfcBaseClass*)representation->get("ContextOfItems");
-		auto context_type = context->as<IfcUtil::IfcBaseEntity>()->get("ContextType");
-		if (!context_type.isNull()) {
-			context_string = (std::string)context_type;
-		}
-	}
+	const std::string context_string = Converter::context_string(representation_node->instance->as<IfcUtil::IfcBaseEntity>());
 
 	auto elem = new IfcGeom::BRepElement(
 		product->id(),
@@ -343,6 +347,24 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 	return elem;
 }
 
+std::string ifcopenshell::geometry::Converter::context_string(const IfcUtil::IfcBaseEntity* representation) {
+	std::string context_string = "";
+
+	auto representation_identifier = representation->get("RepresentationIdentifier");
+	if (!representation_identifier.isNull()) {
+		context_string = (std::string) representation_identifier;
+	}
+	else {
+		IfcUtil::IfcBaseClass *context = (IfcUtil::IfcBaseClass*)representation->get("ContextOfItems");
+		auto context_type = context->as<IfcUtil::IfcBaseEntity>()->get("ContextType");
+		if (!context_type.isNull()) {
+			context_string = (std::string)context_type;
+		}
+	}
+
+	return context_string;
+}
+
 IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_processed_representation(const IfcUtil::IfcBaseEntity* product, const taxonomy::matrix4::ptr& place, IfcGeom::BRepElement* brep) {
 
 	int parent_id = -1;
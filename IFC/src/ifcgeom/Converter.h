@@ -53,6 +53,9 @@ namespace ifcopenshell { namespace geometry {
 		IfcGeom::BRepElement* create_brep_for_processed_representation(const IfcUtil::IfcBaseEntity* product, const ifcopenshell::geometry::taxonomy::matrix4::ptr& place, IfcGeom::BRepElement*);
 
 		const ifcopenshell::geometry::Settings& settings() { return settings_; }
+
+		/// Returns the RepresentationIdentifier of representation, or the ContextType of its context when absent
+		static std::string context_string(const IfcUtil::IfcBaseEntity* representation);
 	};
 }}
 
@@ -0,0 +1,842 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "GeometryCache.h"
+
+#include "../ifcgeom/IfcGeomRenderStyles.h"
+#include "../ifcparse/IfcLogger.h"
+#include "../ifcparse/utils.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+using namespace ifcopenshell::geometry;
+
+namespace {
+
+	static_assert(sizeof(int) == sizeof(int32_t), "The geometry cache format assumes 32-bit integers");
+
+	const char entry_magic[8] = { 'I', 'F', 'C', 'G', 'E', 'O', 'C', '1' };
+	const uint32_t entry_version = 3;
+	const uint32_t entry_byte_order = 0x01020304;
+
+	const char* const entry_extension = ".bin";
+	const char* const temporary_extension = ".tmp";
+
+	// Settings that only affect how the iterator emits the elements or on how many
+	// threads they are created, and not the elements themselves
+	const char* const excluded_settings[] = { "ordered-output", "streaming-window", "no-parallel-mapping", "no-cost-ordering", "parallel-meshing-faces", "parallel-opening-subtraction", "debug" };
+
+	struct entry_header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byte_order;
+		uint64_t key;
+		// Digest of the serialization of what the key was computed from
+		uint64_t check;
+		uint32_t material_style_applied;
+		uint32_t num_materials;
+	};
+
+	FILE* open_file(const std::string& path, bool write) {
+#ifdef _MSC_VER
+		return _wfopen(IfcUtil::path::from_utf8(path).c_str(), write ? L"wb" : L"rb");
+#else
+		return fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+	}
+
+	class entry_writer {
+	private:
+		std::string buffer_;
+	public:
+		void write(const void* data, size_t size) {
+			buffer_.append((const char*)data, size);
+		}
+
+		template <typename T>
+		void value(const T& t) {
+			write(&t, sizeof(T));
+		}
+
+		template <typename T>
+		void column(const std::vector<T>& ts) {
+			value((uint64_t)ts.size());
+			write(ts.data(), ts.size() * sizeof(T));
+		}
+
+		void string(const std::string& s) {
+			value((uint64_t)s.size());
+			write(s.data(), s.size());
+		}
+
+		void colour(const taxonomy::colour& c) {
+			value((uint8_t)!!c);
+			if (c) {
+				value(c.r());
+				value(c.g());
+				value(c.b());
+			}
+		}
+
+		const std::string& buffer() const { return buffer_; }
+	};
+
+	// Reads the entry from a buffer, every read is checked against the size of the buffer
+	class entry_reader {
+	private:
+		const std::string& buffer_;
+		size_t offset_;
+	public:
+		explicit entry_reader(const std::string& buffer)
+			: buffer_(buffer)
+			, offset_(0)
+		{}
+
+		bool read(void* data, size_t size) {
+			if (size > buffer_.size() - offset_) {
+				return false;
+			}
+			memcpy(data, buffer_.data() + offset_, size);
+			offset_ += size;
+			return true;
+		}
+
+		template <typename T>
+		bool value(T& t) {
+			return read(&t, sizeof(T));
+		}
+
+		template <typename T>
+		bool column(std::vector<T>& ts) {
+			uint64_t n;
+			if (!value(n) || n > (buffer_.size() - offset_) / sizeof(T)) {
+				return false;
+			}
+			ts.resize(n);
+			return read(ts.data(), n * sizeof(T));
+		}
+
+		bool string(std::string& s) {
+			uint64_t n;
+			if (!value(n) || n > buffer_.size() - offset_) {
+				return false;
+			}
+			s.assign(buffer_.data() + offset_, n);
+			offset_ += n;
+			return true;
+		}
+
+		bool colour(taxonomy::colour& c) {
+			uint8_t has;
+			if (!value(has)) {
+				return false;
+			}
+			if (has) {
+				double r, g, b;
+				if (!value(r) || !value(g) || !value(b)) {
+					return false;
+				}
+				c.components() << r, g, b;
+			}
+			return true;
+		}
+
+		bool at_end() const { return offset_ == buffer_.size(); }
+	};
+
+	bool read_file(const std::string& path, std::string& buffer) {
+		FILE* f = open_file(path, false);
+		if (!f) {
+			return false;
+		}
+		bool success = fseek(f, 0, SEEK_END) == 0;
+		long size = success ? ftell(f) : -1;
+		success = size >= 0 && fseek(f, 0, SEEK_SET) == 0;
+		if (success) {
+			buffer.resize((size_t)size);
+			success = fread(&buffer[0], 1, buffer.size(), f) == buffer.size();
+		}
+		fclose(f);
+		return success;
+	}
+
+	bool is_function_item(taxonomy::kinds k) {
+		return k == taxonomy::FUNCTION_ITEM ||
+			k == taxonomy::FUNCTOR_ITEM ||
+			k == taxonomy::PIECEWISE_FUNCTION ||
+			k == taxonomy::GRADIENT_FUNCTION ||
+			k == taxonomy::CANT_FUNCTION ||
+			k == taxonomy::OFFSET_FUNCTION;
+	}
+
+	template <typename T>
+	bool hash_children(const taxonomy::item::ptr& item, size_t& h, std::vector<int>& item_ids);
+
+	// Combines the hash of item with the placements and styles of the items it
+	// consists of, which are not part of the hashes of all kinds of items, and
+	// collects the ids of their instances. Returns false when a function item is
+	// encountered, because the hashes of function items do not depend on the function.
+	bool hash_item(const taxonomy::item::ptr& item, size_t& h, std::vector<int>& item_ids) {
+		if (!item) {
+			boost::hash_combine(h, size_t(0));
+			return true;
+		}
+
+		if (is_function_item(item->kind())) {
+			return false;
+		}
+
+		boost::hash_combine(h, item->hash());
+
+		if (item->instance) {
+			if (auto inst = item->instance->as<IfcUtil::IfcBaseEntity>()) {
+				item_ids.push_back(inst->id());
+			}
+		}
+
+		if (auto gi = std::dynamic_pointer_cast<taxonomy::geom_item>(item)) {
+			boost::hash_combine(h, gi->matrix ? gi->matrix->hash_components() : size_t(0));
+			boost::hash_combine(h, IfcGeom::GeometryCache::hash(gi->surface_style));
+		}
+
+		switch (item->kind()) {
+		case taxonomy::COLLECTION:
+		case taxonomy::BOOLEAN_RESULT:
+			return hash_children<taxonomy::geom_item>(item, h, item_ids);
+		case taxonomy::LOFT:
+			return hash_children<taxonomy::geom_item>(item, h, item_ids) &&
+				hash_item(std::static_pointer_cast<taxonomy::loft>(item)->axis, h, item_ids);
+		case taxonomy::SOLID:
+			return hash_children<taxonomy::shell>(item, h, item_ids);
+		case taxonomy::SHELL:
+			return hash_children<taxonomy::face>(item, h, item_ids);
+		case taxonomy::FACE:
+			return hash_children<taxonomy::loop>(item, h, item_ids) &&
+				hash_item(std::static_pointer_cast<taxonomy::face>(item)->basis, h, item_ids);
+		case taxonomy::LOOP:
+			return hash_children<taxonomy::edge>(item, h, item_ids);
+		case taxonomy::EDGE:
+			return hash_item(std::static_pointer_cast<taxonomy::edge>(item)->basis, h, item_ids);
+		case taxonomy::OFFSET_CURVE:
+			return hash_item(std::static_pointer_cast<taxonomy::offset_curve>(item)->basis, h, item_ids);
+		case taxonomy::EXTRUSION:
+		case taxonomy::REVOLVE:
+			return hash_item(std::static_pointer_cast<taxonomy::sweep>(item)->basis, h, item_ids);
+		case taxonomy::SWEEP_ALONG_CURVE: {
+			auto sweep = std::static_pointer_cast<taxonomy::sweep_along_curve>(item);
+			return hash_item(sweep->basis, h, item_ids) &&
+				hash_item(sweep->surface, h, item_ids) &&
+				hash_item(sweep->curve, h, item_ids);
+		}
+		default:
+			return true;
+		}
+	}
+
+	template <typename T>
+	bool hash_children(const taxonomy::item::ptr& item, size_t& h, std::vector<int>& item_ids) {
+		auto collection = std::static_pointer_cast<taxonomy::collection_base<T>>(item);
+		for (auto& c : collection->children) {
+			if (!hash_item(c, h, item_ids)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename T>
+	void append(std::string& data, const T& t) {
+		data.append((const char*)&t, sizeof(T));
+	}
+
+	// The hashes of the taxonomy only cover the components of points, directions
+	// and placements by a hash, the serialization has their exact values
+	template <typename T>
+	void serialize_components(const taxonomy::eigen_base<T>& e, std::string& data) {
+		append(data, (uint8_t)!!e.components_);
+		if (e.components_) {
+			data.append((const char*)e.components_->data(), e.components_->size() * sizeof(typename T::Scalar));
+		}
+	}
+
+	void serialize_style(const taxonomy::style::ptr& style, std::string& data) {
+		append(data, (uint8_t)!!style);
+		if (style) {
+			append(data, (uint64_t)style->name.size());
+			data += style->name;
+			serialize_components(style->diffuse, data);
+			serialize_components(style->surface, data);
+			serialize_components(style->specular, data);
+			append(data, style->specularity);
+			append(data, style->transparency);
+			append(data, (uint8_t)style->use_surface_color);
+		}
+	}
+
+	void serialize_trim(const boost::variant<boost::blank, taxonomy::point3::ptr, double>& v, std::string& data) {
+		append(data, (uint8_t)v.which());
+		if (auto p = boost::get<taxonomy::point3::ptr>(&v)) {
+			append(data, (uint8_t)!!*p);
+			if (*p) {
+				serialize_components(**p, data);
+			}
+		} else if (auto d = boost::get<double>(&v)) {
+			append(data, *d);
+		}
+	}
+
+	template <typename T>
+	bool serialize_children(const taxonomy::item::ptr& item, std::string& data);
+
+	// Follows the same items as hash_item(), next to their hashes the values
+	// that the hashes do not cover exactly are appended.
+	bool serialize_item(const taxonomy::item::ptr& item, std::string& data) {
+		if (!item) {
+			append(data, uint32_t(-1));
+			return true;
+		}
+
+		if (is_function_item(item->kind())) {
+			return false;
+		}
+
+		append(data, (uint32_t)item->kind());
+		append(data, (uint64_t)item->hash());
+		append(data, (uint8_t)(item->orientation ? *item->orientation ? 2 : 1 : 0));
+
+		if (auto gi = std::dynamic_pointer_cast<taxonomy::geom_item>(item)) {
+			append(data, (uint8_t)!!gi->matrix);
+			if (gi->matrix) {
+				serialize_components(*gi->matrix, data);
+			}
+			serialize_style(gi->surface_style, data);
+		}
+
+		switch (item->kind()) {
+		case taxonomy::POINT3:
+			serialize_components(*std::static_pointer_cast<taxonomy::point3>(item), data);
+			return true;
+		case taxonomy::DIRECTION3:
+			serialize_components(*std::static_pointer_cast<taxonomy::direction3>(item), data);
+			return true;
+		case taxonomy::MATRIX4:
+			serialize_components(*std::static_pointer_cast<taxonomy::matrix4>(item), data);
+			return true;
+		case taxonomy::COLOUR:
+			serialize_components(*std::static_pointer_cast<taxonomy::colour>(item), data);
+			return true;
+		case taxonomy::STYLE:
+			serialize_style(std::static_pointer_cast<taxonomy::style>(item), data);
+			return true;
+		case taxonomy::CIRCLE:
+			append(data, std::static_pointer_cast<taxonomy::circle>(item)->radius);
+			return true;
+		case taxonomy::ELLIPSE: {
+			auto e = std::static_pointer_cast<taxonomy::ellipse>(item);
+			append(data, e->radius);
+			append(data, e->radius2);
+			return true;
+		}
+		case taxonomy::COLLECTION:
+		case taxonomy::BOOLEAN_RESULT:
+			return serialize_children<taxonomy::geom_item>(item, data);
+		case taxonomy::LOFT:
+			return serialize_children<taxonomy::geom_item>(item, data) &&
+				serialize_item(std::static_pointer_cast<taxonomy::loft>(item)->axis, data);
+		case taxonomy::SOLID:
+			return serialize_children<taxonomy::shell>(item, data);
+		case taxonomy::SHELL:
+			return serialize_children<taxonomy::face>(item, data);
+		case taxonomy::FACE:
+			return serialize_children<taxonomy::loop>(item, data) &&
+				serialize_item(std::static_pointer_cast<taxonomy::face>(item)->basis, data);
+		case taxonomy::LOOP:
+			return serialize_children<taxonomy::edge>(item, data);
+		case taxonomy::EDGE: {
+			auto e = std::static_pointer_cast<taxonomy::edge>(item);
+			serialize_trim(e->start, data);
+			serialize_trim(e->end, data);
+			return serialize_item(e->basis, data);
+		}
+		case taxonomy::OFFSET_CURVE:
+			return serialize_item(std::static_pointer_cast<taxonomy::offset_curve>(item)->basis, data);
+		case taxonomy::EXTRUSION: {
+			auto e = std::static_pointer_cast<taxonomy::extrusion>(item);
+			append(data, (uint8_t)!!e->direction);
+			if (e->direction) {
+				serialize_components(*e->direction, data);
+			}
+			append(data, e->depth);
+			return serialize_item(e->basis, data);
+		}
+		case taxonomy::REVOLVE: {
+			auto r = std::static_pointer_cast<taxonomy::revolve>(item);
+			append(data, (uint8_t)!!r->axis_origin);
+			if (r->axis_origin) {
+				serialize_components(*r->axis_origin, data);
+			}
+			append(data, (uint8_t)!!r->direction);
+			if (r->direction) {
+				serialize_components(*r->direction, data);
+			}
+			append(data, (uint8_t)!!r->angle);
+			append(data, r->angle.get_value_or(0.));
+			return serialize_item(r->basis, data);
+		}
+		case taxonomy::SWEEP_ALONG_CURVE: {
+			auto sweep = std::static_pointer_cast<taxonomy::sweep_along_curve>(item);
+			return serialize_item(sweep->basis, data) &&
+				serialize_item(sweep->surface, data) &&
+				serialize_item(sweep->curve, data);
+		}
+		default:
+			return true;
+		}
+	}
+
+	template <typename T>
+	bool serialize_children(const taxonomy::item::ptr& item, std::string& data) {
+		auto collection = std::static_pointer_cast<taxonomy::collection_base<T>>(item);
+		append(data, (uint64_t)collection->children.size());
+		for (auto& c : collection->children) {
+			if (!serialize_item(c, data)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	struct setting_hasher : public boost::static_visitor<size_t> {
+		template <typename T>
+		size_t operator()(const T& t) const {
+			if constexpr (std::is_enum_v<T>) {
+				return boost::hash<int>{}((int)t);
+			} else {
+				return boost::hash<T>{}(t);
+			}
+		}
+	};
+}
+
+IfcGeom::GeometryCache::GeometryCache(const std::string& directory, uint64_t max_size)
+	: directory_(directory)
+	, max_size_(max_size)
+{
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(IfcUtil::path::from_utf8(directory_), ec);
+	if (ec) {
+		Logger::Error("Unable to create geometry cache directory '" + directory_ + "'");
+		return;
+	}
+
+	const std::string lock_path = (boost::filesystem::path(IfcUtil::path::from_utf8(directory_)) / "lock").string();
+	{
+		// The lock file needs to exist before it can be locked
+		std::ofstream lock_file(lock_path, std::ios_base::app);
+	}
+
+	try {
+		lock_.reset(new boost::interprocess::file_lock(lock_path.c_str()));
+		if (!lock_->try_lock()) {
+			lock_.reset();
+		}
+	} catch (const boost::interprocess::interprocess_exception&) {
+		lock_.reset();
+	}
+
+	if (lock_) {
+		remove_temporary_files_();
+	} else {
+		Logger::Notice("Geometry cache '" + directory_ + "' is in use by another process, it is used read-only");
+	}
+}
+
+IfcGeom::GeometryCache::~GeometryCache() {
+	evict();
+	if (lock_) {
+		lock_->unlock();
+	}
+}
+
+std::string IfcGeom::GeometryCache::path_(key_type key) const {
+	std::ostringstream oss;
+	oss << std::hex << std::setw(16) << std::setfill('0') << key << entry_extension;
+	return (boost::filesystem::path(IfcUtil::path::from_utf8(directory_)) / oss.str()).string();
+}
+
+IfcGeom::Representation::Triangulation* IfcGeom::GeometryCache::read(
+	key_type key,
+	key_type check,
+	const Settings& settings,
+	const std::string& entity,
+	const std::string& id,
+	const std::string& material_id,
+	const std::vector<int>& item_ids)
+{
+	const std::string path = path_(key);
+
+	std::string buffer;
+	if (!read_file(path, buffer)) {
+		++misses_;
+		return nullptr;
+	}
+
+	entry_reader r(buffer);
+	entry_header header;
+
+	std::vector<double> verts, normals, uvs;
+	std::vector<int> faces, edges, material_ids, item_indices, edge_item_indices;
+	std::vector<taxonomy::style::ptr> materials;
+
+	bool valid = r.value(header) &&
+		memcmp(header.magic, entry_magic, sizeof(entry_magic)) == 0 &&
+		header.version == entry_version &&
+		header.byte_order == entry_byte_order &&
+		header.key == key;
+
+	if (valid && header.check != check) {
+		// The key of other geometry collides with the key
+		++misses_;
+		return nullptr;
+	}
+
+	for (uint32_t i = 0; valid && i < header.num_materials; ++i) {
+		auto s = taxonomy::make<taxonomy::style>();
+		uint8_t use_surface_color;
+		valid = r.string(s->name) &&
+			r.colour(s->diffuse) &&
+			r.colour(s->surface) &&
+			r.colour(s->specular) &&
+			r.value(s->specularity) &&
+			r.value(s->transparency) &&
+			r.value(use_surface_color);
+		if (valid) {
+			s->use_surface_color = !!use_surface_color;
+			materials.push_back(intern_style_(s, entity));
+		}
+	}
+
+	valid = valid &&
+		r.column(verts) &&
+		r.column(faces) &&
+		r.column(edges) &&
+		r.column(normals) &&
+		r.column(uvs) &&
+		r.column(material_ids) &&
+		r.column(item_indices) &&
+		r.column(edge_item_indices) &&
+		r.at_end();
+
+	auto to_item_ids = [&item_ids](std::vector<int>& indices) {
+		for (auto& i : indices) {
+			if (i < 0 || i >= (int)item_ids.size()) {
+				return false;
+			}
+			i = item_ids[i];
+		}
+		return true;
+	};
+
+	auto valid_indices = [](const std::vector<int>& indices, size_t size) {
+		return std::all_of(indices.begin(), indices.end(), [size](int i) { return i >= 0 && (size_t)i < size; });
+	};
+
+	valid = valid &&
+		verts.size() % 3 == 0 &&
+		faces.size() % 3 == 0 &&
+		edges.size() % 2 == 0 &&
+		valid_indices(faces, verts.size() / 3) &&
+		valid_indices(edges, verts.size() / 3) &&
+		std::all_of(material_ids.begin(), material_ids.end(), [&materials](int i) { return i >= -1 && i < (int)materials.size(); }) &&
+		to_item_ids(item_indices) &&
+		to_item_ids(edge_item_indices);
+
+	if (!valid) {
+		Logger::Warning("Ignoring invalid geometry cache entry '" + path + "'");
+		++misses_;
+		return nullptr;
+	}
+
+	// Mark the entry as recently used
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time(IfcUtil::path::from_utf8(path), std::time(nullptr), ec);
+
+	++hits_;
+
+	return new IfcGeom::Representation::Triangulation(
+		settings, entity, header.material_style_applied ? material_id : id,
+		verts, faces, edges, normals, uvs,
+		material_ids, materials,
+		item_indices, edge_item_indices
+	);
+}
+
+bool IfcGeom::GeometryCache::write(
+	key_type key,
+	key_type check,
+	const IfcGeom::Representation::Triangulation& triangulation,
+	const std::vector<int>& item_ids,
+	bool material_style_applied)
+{
+	if (!lock_) {
+		return false;
+	}
+
+	// Polyhedral faces are not stored
+	if (!triangulation.polyhedral_faces_without_holes().empty() || !triangulation.polyhedral_faces_with_holes().empty()) {
+		return false;
+	}
+
+	std::unordered_map<int, int> item_indices;
+	for (size_t i = 0; i < item_ids.size(); ++i) {
+		item_indices.insert({ item_ids[i], (int)i });
+	}
+
+	// Item ids are stored as indices into item_ids, so that the entry can be read
+	// for a representation with the same structure but other instance ids.
+	bool valid = true;
+	auto to_item_indices = [&item_indices, &valid](const std::vector<int>& ids) {
+		std::vector<int> indices;
+		indices.reserve(ids.size());
+		for (auto& i : ids) {
+			auto it = item_indices.find(i);
+			if (it == item_indices.end()) {
+				valid = false;
+				break;
+			}
+			indices.push_back(it->second);
+		}
+		return indices;
+	};
+
+	auto faces_item_indices = to_item_indices(triangulation.item_ids());
+	auto edges_item_indices = to_item_indices(triangulation.edges_item_ids());
+	if (!valid) {
+		return false;
+	}
+
+	entry_header header;
+	memcpy(header.magic, entry_magic, sizeof(entry_magic));
+	header.version = entry_version;
+	header.byte_order = entry_byte_order;
+	header.key = key;
+	header.check = check;
+	header.material_style_applied = material_style_applied ? 1 : 0;
+	header.num_materials = (uint32_t)triangulation.materials().size();
+
+	entry_writer w;
+	w.value(header);
+	for (auto& s : triangulation.materials()) {
+		w.string(s->name);
+		w.colour(s->diffuse);
+		w.colour(s->surface);
+		w.colour(s->specular);
+		w.value(s->specularity);
+		w.value(s->transparency);
+		w.value((uint8_t)s->use_surface_color);
+	}
+	w.column(triangulation.verts());
+	w.column(triangulation.faces());
+	w.column(triangulation.edges());
+	w.column(triangulation.normals());
+	w.column(triangulation.uvs());
+	w.column(triangulation.material_ids());
+	w.column(faces_item_indices);
+	w.column(edges_item_indices);
+
+	const std::string path = path_(key);
+	const std::string temp_path = path + "." + std::to_string(temporary_counter_++) + temporary_extension;
+
+	FILE* f = open_file(temp_path, true);
+	if (!f) {
+		return false;
+	}
+	const std::string& buffer = w.buffer();
+	bool success = fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+	success = fclose(f) == 0 && success;
+	if (!success || !IfcUtil::path::rename_file(temp_path, path)) {
+		IfcUtil::path::delete_file(temp_path);
+		return false;
+	}
+
+	++writes_;
+
+	if (max_size_ && (bytes_written_ += buffer.size()) > max_size_ / 8) {
+		evict();
+	}
+
+	return true;
+}
+
+void IfcGeom::GeometryCache::evict() {
+	if (!lock_ || !max_size_) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lk(evict_mutex_);
+	bytes_written_ = 0;
+
+	struct entry {
+		std::time_t time;
+		uint64_t size;
+		boost::filesystem::path path;
+	};
+
+	std::vector<entry> entries;
+	uint64_t total_size = 0;
+
+	boost::system::error_code ec;
+	for (boost::filesystem::directory_iterator it(IfcUtil::path::from_utf8(directory_), ec), end; !ec && it != end; it.increment(ec)) {
+		if (it->path().extension() != entry_extension) {
+			continue;
+		}
+		boost::system::error_code ec2;
+		entry e{ boost::filesystem::last_write_time(it->path(), ec2), 0, it->path() };
+		if (!ec2) {
+			e.size = boost::filesystem::file_size(it->path(), ec2);
+		}
+		if (!ec2) {
+			total_size += e.size;
+			entries.push_back(e);
+		}
+	}
+
+	if (total_size <= max_size_) {
+		return;
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) {
+		return a.time < b.time;
+	});
+
+	size_t num_removed = 0;
+	for (auto& e : entries) {
+		if (total_size <= max_size_) {
+			break;
+		}
+		boost::system::error_code ec2;
+		if (boost::filesystem::remove(e.path, ec2)) {
+			total_size -= e.size;
+			++num_removed;
+		}
+	}
+
+	Logger::Notice("Removed " + std::to_string(num_removed) + " least recently used entries from geometry cache '" + directory_ + "'");
+}
+
+void IfcGeom::GeometryCache::remove_temporary_files_() {
+	boost::system::error_code ec;
+	for (boost::filesystem::directory_iterator it(IfcUtil::path::from_utf8(directory_), ec), end; !ec && it != end; it.increment(ec)) {
+		if (it->path().extension() == temporary_extension) {
+			boost::system::error_code ec2;
+			boost::filesystem::remove(it->path(), ec2);
+		}
+	}
+}
+
+taxonomy::style::ptr IfcGeom::GeometryCache::intern_style_(const taxonomy::style::ptr& style, const std::string& entity) {
+	const size_t h = hash(style);
+
+	// Default materials are compared by pointer, reuse the default material when it is equal
+	const auto& default_style = IfcGeom::get_default_style(entity);
+	if (default_style && hash(default_style) == h) {
+		return default_style;
+	}
+
+	std::lock_guard<std::mutex> lk(styles_mutex_);
+	auto it = styles_.find(h);
+	if (it != styles_.end()) {
+		return it->second;
+	}
+	styles_.insert({ h, style });
+	return style;
+}
+
+boost::optional<size_t> IfcGeom::GeometryCache::hash(const taxonomy::ptr& item, std::vector<int>& item_ids) {
+	size_t h = 0;
+	if (!hash_item(item, h, item_ids)) {
+		return boost::none;
+	}
+
+	// Keep the first occurrence of the instances that are used by multiple items
+	std::vector<int> unique_ids;
+	std::unordered_map<int, int> seen;
+	for (auto& i : item_ids) {
+		if (seen.insert({ i, 0 }).second) {
+			unique_ids.push_back(i);
+		}
+	}
+	item_ids.swap(unique_ids);
+
+	return h;
+}
+
+size_t IfcGeom::GeometryCache::hash(const taxonomy::style::ptr& style) {
+	if (!style) {
+		return 0;
+	}
+	size_t h = style->hash();
+	boost::hash_combine(h, style->use_surface_color);
+	return h;
+}
+
+size_t IfcGeom::GeometryCache::hash(const Settings& settings) {
+	size_t h = boost::hash<uint32_t>{}(entry_version);
+	for (auto& name : settings.setting_names()) {
+		if (std::find(std::begin(excluded_settings), std::end(excluded_settings), name) != std::end(excluded_settings)) {
+			continue;
+		}
+		Settings::value_variant_t value;
+		try {
+			value = settings.get(name);
+		} catch (const std::exception&) {
+			// Settings without a default value that are not set
+			continue;
+		}
+		boost::hash_combine(h, name);
+		boost::hash_combine(h, value.which());
+		boost::hash_combine(h, boost::apply_visitor(setting_hasher{}, value));
+	}
+	return h;
+}
+
+bool IfcGeom::GeometryCache::serialize(const taxonomy::ptr& item, std::string& data) {
+	return serialize_item(item, data);
+}
+
+IfcGeom::GeometryCache::key_type IfcGeom::GeometryCache::digest(const std::string& data) {
+	// 64-bit FNV-1a, which shares nothing with the boost::hash_combine() the keys are built with
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (unsigned char c : data) {
+		h ^= c;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
@@ -0,0 +1,168 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Stores triangulated geometry on disk, keyed by a hash of the taxonomy it was *
+ * created from, so that it can be reused by later runs and other files         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef GEOMETRYCACHE_H
+#define GEOMETRYCACHE_H
+
+#include "../ifcgeom/ifc_geom_api.h"
+#include "../ifcgeom/taxonomy.h"
+#include "../ifcgeom/ConversionSettings.h"
+#include "../ifcgeom/IfcGeomRepresentation.h"
+
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace boost {
+	namespace interprocess {
+		class file_lock;
+	}
+}
+
+namespace IfcGeom {
+
+	/// A cache of triangulations in a directory on disk. Entries are keyed by a
+	/// hash of the taxonomy of a representation, combined by the caller with
+	/// everything else that determines the triangulation, such as the settings,
+	/// the material and the openings of the product. Geometry that is unchanged
+	/// in a new revision of a model, or that is identical in another model, is
+	/// then read from the cache instead of being converted again.
+	///
+	/// Any number of processes can read from the same directory. The first
+	/// process to open the directory also writes to it, the others use it
+	/// read-only until it is closed. Entries are written to a temporary file
+	/// that is renamed, so that readers never see an entry that is partially
+	/// written. Reading an entry marks it as recently used and the writer removes
+	/// the least recently used entries when the entries exceed the maximum size.
+	///
+	/// Entries are tied to the byte order and the library that wrote them and
+	/// are not meant to be exchanged.
+	class IFC_GEOM_API GeometryCache {
+	public:
+		typedef uint64_t key_type;
+
+		/// Opens the cache in directory, which is created when it does not exist.
+		/// The entries are kept under max_size bytes, 0 does not limit the size.
+		GeometryCache(const std::string& directory, uint64_t max_size);
+		~GeometryCache();
+
+		const std::string& directory() const { return directory_; }
+
+		/// Whether entries are written, false when the directory is used by another process
+		bool writable() const { return !!lock_; }
+
+		/// Reads the entry for key, returns null when there is no valid entry or
+		/// when the entry was written with another check, see digest(). The item
+		/// ids of the entry are indices into item_ids, as returned by hash() for
+		/// the representation that is read. The triangulation is identified by
+		/// material_id when the material of the product was applied to it when it
+		/// was written and by id otherwise.
+		IfcGeom::Representation::Triangulation* read(
+			key_type key,
+			key_type check,
+			const ifcopenshell::geometry::Settings& settings,
+			const std::string& entity,
+			const std::string& id,
+			const std::string& material_id,
+			const std::vector<int>& item_ids);
+
+		/// Writes the entry for key with check, returns false when the cache is
+		/// read-only or the triangulation cannot be stored.
+		bool write(
+			key_type key,
+			key_type check,
+			const IfcGeom::Representation::Triangulation& triangulation,
+			const std::vector<int>& item_ids,
+			bool material_style_applied);
+
+		/// Removes the least recently used entries until the entries no longer
+		/// exceed the maximum size. Does nothing when the cache is read-only.
+		void evict();
+
+		size_t hits() const { return hits_; }
+		size_t misses() const { return misses_; }
+		size_t writes() const { return writes_; }
+
+		/// Returns a hash of item and the items it consists of, including their
+		/// placements and styles, and appends the ids of the instances of the items
+		/// to item_ids. Returns none for items that cannot be identified by their
+		/// hash, which is the case for items that contain function items.
+		static boost::optional<size_t> hash(const ifcopenshell::geometry::taxonomy::ptr& item, std::vector<int>& item_ids);
+
+		/// Returns a hash of the style, or 0 for a null style
+		static size_t hash(const ifcopenshell::geometry::taxonomy::style::ptr& style);
+
+		/// Returns a hash of the settings that affect the geometry
+		static size_t hash(const ifcopenshell::geometry::Settings& settings);
+
+		/// Appends a canonical serialization of item and the items it consists of
+		/// to data: their kinds and hashes, and the exact coordinates, placements
+		/// and styles the hashes are derived from. Returns false for items that
+		/// cannot be identified by their hash, as hash() does.
+		static bool serialize(const ifcopenshell::geometry::taxonomy::ptr& item, std::string& data);
+
+		/// Returns a digest of data, computed independently of the hashes of the
+		/// taxonomy. Entries store the digest of the serialization of what their
+		/// key was computed from, so that an entry of which the key collides with
+		/// the key of other geometry is not read.
+		static key_type digest(const std::string& data);
+
+	private:
+		std::string directory_;
+		uint64_t max_size_;
+
+		std::unique_ptr<boost::interprocess::file_lock> lock_;
+
+		std::atomic<size_t> hits_{ 0 };
+		std::atomic<size_t> misses_{ 0 };
+		std::atomic<size_t> writes_{ 0 };
+
+		// Bytes written since the last eviction
+		std::atomic<uint64_t> bytes_written_{ 0 };
+		std::atomic<size_t> temporary_counter_{ 0 };
+		std::mutex evict_mutex_;
+
+		// Equal materials of the entries that are read share a single style
+		std::mutex styles_mutex_;
+		std::map<size_t, ifcopenshell::geometry::taxonomy::style::ptr> styles_;
+
+		std::string path_(key_type key) const;
+		ifcopenshell::geometry::taxonomy::style::ptr intern_style_(const ifcopenshell::geometry::taxonomy::style::ptr& style, const std::string& entity);
+		void remove_temporary_files_();
+
+		GeometryCache(const GeometryCache&);
+		GeometryCache& operator=(const GeometryCache&);
+	};
+
+}
+
+#endif
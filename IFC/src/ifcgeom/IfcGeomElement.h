@@ -48,6 +48,13 @@ namespace IfcGeom {
 			static ifcopenshell::geometry::taxonomy::matrix4::ptr iden = ifcopenshell::geometry::taxonomy::make<ifcopenshell::geometry::taxonomy::matrix4>();
 			return iden;
 		}
+		/// Prepends a translation to the matrix. The matrix is replaced rather than
+		/// modified, because it may be shared with other elements.
+		void translate(double dx, double dy, double dz) {
+			Eigen::Matrix4d m = data()->ccomponents();
+			m.topRows<3>() += Eigen::Vector3d(dx, dy, dz) * m.row(3);
+			matrix_ = ifcopenshell::geometry::taxonomy::make<ifcopenshell::geometry::taxonomy::matrix4>(m);
+		}
 	};
 
 	class Element {
@@ -95,6 +102,7 @@ namespace IfcGeom {
 		const std::string& context() const { return _context; }
 		const std::string& unique_id() const { return _unique_id; }
 		const Transformation& transformation() const { return _transformation; }
+		Transformation& transformation() { return _transformation; }
         const IfcUtil::IfcBaseEntity* product() const { return product_; }
 		const std::vector<const IfcGeom::Element*>& parents() const { return _parents; }
 		void SetParents(std::vector<const IfcGeom::Element*>& newparents) { _parents = newparents; }
@@ -19,6 +19,10 @@
 
 #include "IfcGeomRepresentation.h"
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
 #ifdef IFOPSH_WITH_OPENCASCADE
 #include "../ifcparse/IfcLogger.h"
 #include "../ifcgeom/kernels/opencascade/OpenCascadeConversionResult.h"
@@ -323,7 +327,7 @@ bool IfcGeom::Representation::BRep::calculate_projected_surface_area(const ifcop
 
 IfcGeom::Representation::Triangulation::Triangulation(const BRep& shape_model)
 	: Representation(shape_model.settings(), shape_model.entity(), shape_model.id())
-	, weld_offset_(0)
+	, num_welds_(0)
 {
 	for (IfcGeom::ConversionResults::const_iterator iit = shape_model.begin(); iit != shape_model.end(); ++iit) {
 		
@@ -387,6 +391,104 @@ std::vector<double> IfcGeom::Representation::Triangulation::box_project_uvs(cons
 	return uvs;
 }
 
+namespace {
+	// The cell of a coordinate in the grid of welded vertices. Cells are twice
+	// the tolerance wide, so that a vertex within the tolerance is in the same
+	// cell or in the neighbouring cell on the nearest side along every axis.
+	// Without a tolerance the cell is the coordinate itself, so that only
+	// identical coordinates share a cell.
+	int64_t weld_cell(double v, double tolerance) {
+		if (tolerance > 0.) {
+			return (int64_t) std::floor(v / (2. * tolerance));
+		}
+		// Negative zero is welded with zero
+		if (v == 0.) {
+			v = 0.;
+		}
+		int64_t bits;
+		memcpy(&bits, &v, sizeof(double));
+		return bits;
+	}
+
+	// The neighbouring cell along an axis that is nearest to v
+	int64_t weld_neighbour(double v, double tolerance, int64_t cell) {
+		return v - (double) cell * 2. * tolerance < tolerance ? cell - 1 : cell + 1;
+	}
+
+	size_t weld_hash(int item_id, int material_index, int64_t x, int64_t y, int64_t z) {
+		uint64_t h = (uint64_t) (uint32_t) item_id * 0x9E3779B97F4A7C15ULL ^ (uint64_t) (uint32_t) material_index;
+		for (uint64_t c : { (uint64_t) x, (uint64_t) y, (uint64_t) z }) {
+			h = (h ^ c) * 0xFF51AFD7ED558CCDULL;
+			h ^= h >> 32;
+		}
+		return (size_t) h;
+	}
+}
+
+int IfcGeom::Representation::Triangulation::findWeld_(int item_id, int material_index, double X, double Y, double Z, double tolerance) const {
+	if (weld_slots_.empty()) {
+		return -1;
+	}
+
+	const size_t mask = weld_slots_.size() - 1;
+	const int64_t cx = weld_cell(X, tolerance), cy = weld_cell(Y, tolerance), cz = weld_cell(Z, tolerance);
+
+	if (tolerance <= 0.) {
+		for (size_t i = weld_hash(item_id, material_index, cx, cy, cz) & mask; weld_slots_[i].vertex != -1; i = (i + 1) & mask) {
+			const auto& slot = weld_slots_[i];
+			const double* v = &verts_[3 * (size_t) slot.vertex];
+			if (slot.item_id == item_id && slot.material_index == material_index && v[0] == X && v[1] == Y && v[2] == Z) {
+				return slot.vertex;
+			}
+		}
+		return -1;
+	}
+
+	const int64_t xs[2] = { cx, weld_neighbour(X, tolerance, cx) };
+	const int64_t ys[2] = { cy, weld_neighbour(Y, tolerance, cy) };
+	const int64_t zs[2] = { cz, weld_neighbour(Z, tolerance, cz) };
+	const double tolerance_squared = tolerance * tolerance;
+	for (int j = 0; j < 8; ++j) {
+		const int64_t nx = xs[j & 1], ny = ys[(j >> 1) & 1], nz = zs[j >> 2];
+		for (size_t i = weld_hash(item_id, material_index, nx, ny, nz) & mask; weld_slots_[i].vertex != -1; i = (i + 1) & mask) {
+			const auto& slot = weld_slots_[i];
+			if (slot.item_id != item_id || slot.material_index != material_index) {
+				continue;
+			}
+			const double* v = &verts_[3 * (size_t) slot.vertex];
+			const double ex = v[0] - X, ey = v[1] - Y, ez = v[2] - Z;
+			if (ex * ex + ey * ey + ez * ez <= tolerance_squared) {
+				return slot.vertex;
+			}
+		}
+	}
+	return -1;
+}
+
+void IfcGeom::Representation::Triangulation::insertWeld_(int item_id, int material_index, int vertex, double tolerance) {
+	// Grows the table by a factor of two when it is more than half full
+	if (weld_slots_.size() < 2 * (num_welds_ + 1)) {
+		std::vector<WeldSlot> slots;
+		slots.swap(weld_slots_);
+		weld_slots_.assign((std::max)(slots.size() * 2, (size_t) 64), WeldSlot{ -1, 0, 0 });
+		num_welds_ = 0;
+		for (auto& slot : slots) {
+			if (slot.vertex != -1) {
+				insertWeld_(slot.item_id, slot.material_index, slot.vertex, tolerance);
+			}
+		}
+	}
+
+	const size_t mask = weld_slots_.size() - 1;
+	const double* v = &verts_[3 * (size_t) vertex];
+	size_t i = weld_hash(item_id, material_index, weld_cell(v[0], tolerance), weld_cell(v[1], tolerance), weld_cell(v[2], tolerance)) & mask;
+	while (weld_slots_[i].vertex != -1) {
+		i = (i + 1) & mask;
+	}
+	weld_slots_[i] = WeldSlot{ vertex, item_id, material_index };
+	++num_welds_;
+}
+
 int IfcGeom::Representation::Triangulation::addVertex(int item_id, int material_index, double pX, double pY, double pZ) {
 	const bool convert = settings().get<ifcopenshell::geometry::settings::ConvertBackUnits>().get();
 	auto unit_magnitude = settings().get<ifcopenshell::geometry::settings::LengthUnit>().get();
@@ -394,19 +496,78 @@ int IfcGeom::Representation::Triangulation::addVertex(int item_id, int material_
 	const double Y = convert ? (pY /unit_magnitude) : pY;
 	const double Z = convert ? (pZ /unit_magnitude) : pZ;
 	int i = (int)verts_.size() / 3;
-	if (settings().get<ifcopenshell::geometry::settings::WeldVertices>().get()) {
-		const VertexKey key = std::make_tuple(item_id, material_index, X, Y, Z);
-		typename VertexKeyMap::const_iterator it = welds.find(key);
-		if (it != welds.end()) return it->second;
-		i = (int)(welds.size() + weld_offset_);
-		welds[key] = i;
+	const bool weld = settings().get<ifcopenshell::geometry::settings::WeldVertices>().get();
+	double tolerance = 0.;
+	if (weld) {
+		tolerance = settings().get<ifcopenshell::geometry::settings::WeldTolerance>().get();
+		if (convert) {
+			tolerance /= unit_magnitude;
+		}
+		const int existing = findWeld_(item_id, material_index, X, Y, Z, tolerance);
+		if (existing != -1) {
+			return existing;
+		}
 	}
 	verts_.push_back(X);
 	verts_.push_back(Y);
 	verts_.push_back(Z);
+	if (weld) {
+		insertWeld_(item_id, material_index, i, tolerance);
+	}
 	return i;
 }
 
+void IfcGeom::Representation::Triangulation::addVertices(int item_id, int material_index, const std::vector<double>& xyz, std::vector<int>& indices) {
+	const bool convert = settings().get<ifcopenshell::geometry::settings::ConvertBackUnits>().get();
+	const double unit_magnitude = settings().get<ifcopenshell::geometry::settings::LengthUnit>().get();
+	const bool weld = settings().get<ifcopenshell::geometry::settings::WeldVertices>().get();
+	double tolerance = settings().get<ifcopenshell::geometry::settings::WeldTolerance>().get();
+	if (convert) {
+		tolerance /= unit_magnitude;
+	}
+
+	const size_t n = xyz.size() / 3;
+	indices.resize(n);
+	verts_.reserve(verts_.size() + xyz.size());
+	if (weld && weld_slots_.size() < 2 * (num_welds_ + n)) {
+		// Grows the table once for all vertices instead of repeatedly while they are added
+		std::vector<WeldSlot> slots;
+		slots.swap(weld_slots_);
+		size_t size = 64;
+		while (size < 2 * (num_welds_ + n)) {
+			size *= 2;
+		}
+		weld_slots_.assign(size, WeldSlot{ -1, 0, 0 });
+		num_welds_ = 0;
+		for (auto& slot : slots) {
+			if (slot.vertex != -1) {
+				insertWeld_(slot.item_id, slot.material_index, slot.vertex, tolerance);
+			}
+		}
+	}
+
+	for (size_t j = 0; j < n; ++j) {
+		const double X = convert ? (xyz[3 * j + 0] / unit_magnitude) : xyz[3 * j + 0];
+		const double Y = convert ? (xyz[3 * j + 1] / unit_magnitude) : xyz[3 * j + 1];
+		const double Z = convert ? (xyz[3 * j + 2] / unit_magnitude) : xyz[3 * j + 2];
+		if (weld) {
+			const int existing = findWeld_(item_id, material_index, X, Y, Z, tolerance);
+			if (existing != -1) {
+				indices[j] = existing;
+				continue;
+			}
+		}
+		const int i = (int)verts_.size() / 3;
+		verts_.push_back(X);
+		verts_.push_back(Y);
+		verts_.push_back(Z);
+		if (weld) {
+			insertWeld_(item_id, material_index, i, tolerance);
+		}
+		indices[j] = i;
+	}
+}
+
 void IfcGeom::Representation::Triangulation::registerEdgeCount(int n1, int n2, std::map<std::pair<int, int>, int>& edgecount) {
 	const Edge e = Edge((std::min)(n1, n2), (std::max)(n1, n2));
 	edgecount[e] ++;
@@ -98,11 +98,15 @@ namespace IfcGeom {
 
 		class Triangulation : public Representation {
 		private:
-			// A tuple of <item, material, x, y, z> to store as a key in a map.
-			typedef typename std::tuple<int, int, double, double, double> VertexKey;
-			typedef std::map<VertexKey, int> VertexKeyMap;
 			typedef std::pair<int, int> Edge;
 
+			// A slot in the hash table of welded vertices, -1 when it is empty
+			struct WeldSlot {
+				int vertex;
+				int item_id;
+				int material_index;
+			};
+
 			std::vector<double> verts_;
 
 			// @nb only one of these is populated based on settings, we didn't want to go
@@ -118,14 +122,19 @@ namespace IfcGeom {
 			std::vector<ifcopenshell::geometry::taxonomy::style::ptr> materials_;
 			std::vector<int> item_ids_;
 			std::vector<int> edges_item_ids_;
-			size_t weld_offset_;
-			VertexKeyMap welds;
+			// Open addressing hash table of the vertices that can be welded, keyed by
+			// item, material and position, see addVertex()
+			std::vector<WeldSlot> weld_slots_;
+			size_t num_welds_;
 
 			Triangulation(const ifcopenshell::geometry::Settings& settings, const std::string& entity,  const std::string& id)
 				: Representation(settings, entity, id)
-				, weld_offset_(0)
+				, num_welds_(0)
 				{}
 
+			int findWeld_(int item_id, int material_index, double X, double Y, double Z, double tolerance) const;
+			void insertWeld_(int item_id, int material_index, int vertex, double tolerance);
+
 		public:
 			const std::vector<double>& verts() const { return verts_; }
 			const std::vector<int>& faces() const { return faces_; }
@@ -166,6 +175,7 @@ namespace IfcGeom {
 				, materials_(materials)
 				, item_ids_(item_ids)
 				, edges_item_ids_(edges_item_ids)
+				, num_welds_(0)
 			{}
 
 			virtual ~Triangulation() {}
@@ -179,6 +189,19 @@ namespace IfcGeom {
 			/// Welds vertices that belong to different faces
 			int addVertex(int item_index, int material_index, double X, double Y, double Z);
 
+			/// Adds the vertices of which the coordinates are in xyz, welded as by
+			/// addVertex(), and stores their indices in indices
+			void addVertices(int item_index, int material_index, const std::vector<double>& xyz, std::vector<int>& indices);
+
+			/// Moves all vertices by the same offset
+			void translate(double dx, double dy, double dz) {
+				for (auto it = verts_.begin(); it != verts_.end(); it += 3) {
+					*(it + 0) += dx;
+					*(it + 1) += dy;
+					*(it + 2) += dz;
+				}
+			}
+
 			void addNormal(double X, double Y, double Z) {
 				normals_.push_back(X);
 				normals_.push_back(Y);
@@ -225,8 +248,8 @@ namespace IfcGeom {
 			void registerEdgeCount(int n1, int n2, std::map<std::pair<int, int>, int>& edgecount);
 
 			void resetWelds() {
-				weld_offset_ += welds.size();
-				welds.clear();
+				weld_slots_.clear();
+				num_welds_ = 0;
 			}
 
 		private:
@@ -0,0 +1,182 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "IncrementalManifest.h"
+
+#include "../ifcparse/IfcBaseClass.h"
+#include "../ifcparse/IfcEntityInstanceData.h"
+#include "../ifcparse/IfcLogger.h"
+#include "../ifcparse/utils.h"
+
+#include <boost/dynamic_bitset.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+
+	const char* const manifest_header = "IfcOpenShell incremental manifest 2";
+
+	std::string bitset_string(const boost::dynamic_bitset<>& b) {
+		std::string s;
+		boost::to_string(b, s);
+		return s;
+	}
+
+}
+
+bool IfcGeom::IncrementalManifest::read(const std::string& path) {
+	previous_.clear();
+
+	std::ifstream stream(IfcUtil::path::from_utf8(path).c_str());
+	std::string line;
+	if (!stream || !std::getline(stream, line) || line != manifest_header) {
+		return false;
+	}
+
+	while (std::getline(stream, line)) {
+		std::istringstream fields(line);
+		std::string guid;
+		entry e;
+		size_t num_items;
+		if (!(fields >> guid >> std::hex >> e.dependency_hash >> e.key >> e.check >> std::dec >> num_items)) {
+			Logger::Error("Invalid entry in incremental manifest '" + path + "'");
+			previous_.clear();
+			return false;
+		}
+		e.item_positions.resize(num_items);
+		for (auto& p : e.item_positions) {
+			if (!(fields >> p)) {
+				Logger::Error("Invalid entry in incremental manifest '" + path + "'");
+				previous_.clear();
+				return false;
+			}
+		}
+		previous_[guid] = std::move(e);
+	}
+
+	return true;
+}
+
+bool IfcGeom::IncrementalManifest::write(const std::string& path) const {
+	std::ofstream stream(IfcUtil::path::from_utf8(path).c_str());
+	if (!stream) {
+		return false;
+	}
+
+	stream << manifest_header << "\n";
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto& p : current_) {
+		stream << p.first << std::hex << " " << p.second.dependency_hash << " " << p.second.key << " " << p.second.check << std::dec << " " << p.second.item_positions.size();
+		for (auto& i : p.second.item_positions) {
+			stream << " " << i;
+		}
+		stream << "\n";
+	}
+
+	return !!stream;
+}
+
+const IfcGeom::IncrementalManifest::entry* IfcGeom::IncrementalManifest::previous(const std::string& guid) const {
+	auto it = previous_.find(guid);
+	return it == previous_.end() ? nullptr : &it->second;
+}
+
+void IfcGeom::IncrementalManifest::record(const std::string& guid, const entry& e) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	current_[guid] = e;
+}
+
+size_t IfcGeom::IncrementalManifest::recorded() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return current_.size();
+}
+
+uint64_t IfcGeom::IncrementalManifest::hash(const aggregate_of_instance::ptr& traversal) {
+	std::unordered_map<const IfcUtil::IfcBaseClass*, uint32_t> positions;
+	for (auto& inst : *traversal) {
+		positions.insert({ inst, (uint32_t) positions.size() });
+	}
+
+	size_t h = 0;
+
+	// Instances outside of the traversal do not occur for a complete traversal
+	auto hash_reference = [&positions, &h](const IfcUtil::IfcBaseClass* inst) {
+		auto it = positions.find(inst);
+		boost::hash_combine(h, it == positions.end() ? uint32_t(-1) : it->second);
+	};
+
+	for (auto& inst : *traversal) {
+		boost::hash_combine(h, inst->declaration().name());
+
+		const auto& data = inst->data();
+		const size_t num_attributes = data.size();
+		boost::hash_combine(h, num_attributes);
+
+		for (size_t i = 0; i < num_attributes; ++i) {
+			boost::hash_combine(h, data.storage_.index(i));
+			data.storage_.apply_visitor([&h, &hash_reference](const auto& v) {
+				using U = std::decay_t<decltype(v)>;
+				if constexpr (std::is_same_v<U, int> || std::is_same_v<U, bool> || std::is_same_v<U, double> || std::is_same_v<U, std::string> ||
+					std::is_same_v<U, std::vector<int>> || std::is_same_v<U, std::vector<double>> || std::is_same_v<U, std::vector<std::string>> ||
+					std::is_same_v<U, std::vector<std::vector<int>>> || std::is_same_v<U, std::vector<std::vector<double>>>)
+				{
+					boost::hash_combine(h, v);
+				} else if constexpr (std::is_same_v<U, boost::logic::tribool>) {
+					boost::hash_combine(h, boost::logic::indeterminate(v) ? 2 : (v ? 1 : 0));
+				} else if constexpr (std::is_same_v<U, boost::dynamic_bitset<>>) {
+					boost::hash_combine(h, bitset_string(v));
+				} else if constexpr (std::is_same_v<U, std::vector<boost::dynamic_bitset<>>>) {
+					boost::hash_combine(h, v.size());
+					for (const auto& b : v) {
+						boost::hash_combine(h, bitset_string(b));
+					}
+				} else if constexpr (std::is_same_v<U, EnumerationReference>) {
+					boost::hash_combine(h, v.enumeration()->name());
+					boost::hash_combine(h, v.index());
+				} else if constexpr (std::is_same_v<U, IfcUtil::IfcBaseClass*>) {
+					hash_reference(v);
+				} else if constexpr (std::is_same_v<U, aggregate_of_instance::ptr>) {
+					boost::hash_combine(h, v ? v->size() : 0);
+					if (v) {
+						for (auto* ref : *v) {
+							hash_reference(ref);
+						}
+					}
+				} else if constexpr (std::is_same_v<U, aggregate_of_aggregate_of_instance::ptr>) {
+					boost::hash_combine(h, v ? v->size() : 0);
+					if (v) {
+						for (const auto& inner : *v) {
+							boost::hash_combine(h, inner.size());
+							for (auto* ref : inner) {
+								hash_reference(ref);
+							}
+						}
+					}
+				}
+			}, i);
+		}
+	}
+
+	return h;
+}
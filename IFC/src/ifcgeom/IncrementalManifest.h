@@ -0,0 +1,106 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Records the instances the geometry of the products of a run depends on, so  *
+ * that a run on the next revision of the model only converts what changed      *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef INCREMENTALMANIFEST_H
+#define INCREMENTALMANIFEST_H
+
+#include "../ifcgeom/ifc_geom_api.h"
+#include "../ifcgeom/GeometryCache.h"
+#include "../ifcparse/aggregate_of_instance.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace IfcGeom {
+
+	/// The manifest of a run lists per product GlobalId a hash of the instances
+	/// the geometry of the product depends on and the key of its triangulation
+	/// in a GeometryCache. In a run on the next revision of the model, products
+	/// of which the hash is unchanged are read from the cache without mapping
+	/// and converting their representation. The manifest of the previous run is
+	/// read, the entries of the current run are recorded and written separately.
+	///
+	/// The hashes do not depend on the ids of the instances, so that a revision
+	/// that is exported again with other ids still matches its predecessor.
+	class IFC_GEOM_API IncrementalManifest {
+	public:
+		struct entry {
+			// Hash of the instances the geometry of the product depends on
+			uint64_t dependency_hash;
+			// The key of the triangulation in the geometry cache
+			GeometryCache::key_type key;
+			// The check of the triangulation in the geometry cache, see GeometryCache::digest()
+			GeometryCache::key_type check;
+			// The ids of the items of the triangulation, see GeometryCache::hash(),
+			// as positions in the traversal of the representation
+			std::vector<uint32_t> item_positions;
+		};
+
+		IncrementalManifest() {}
+
+		/// Reads the manifest of the previous run at path, returns false when there
+		/// is no valid manifest at path
+		bool read(const std::string& path);
+
+		/// Writes the entries recorded in this run to path, returns false when the
+		/// manifest cannot be written
+		bool write(const std::string& path) const;
+
+		/// The entry of the previous run for the product with guid, null when there is none
+		const entry* previous(const std::string& guid) const;
+
+		/// Records the entry of the product with guid in this run
+		void record(const std::string& guid, const entry& e);
+
+		/// Counts a product that is reused from the previous run
+		void count_reused() { ++reused_; }
+		size_t reused() const { return reused_; }
+		size_t recorded() const;
+
+		/// Returns a hash of the instances in traversal, as returned by
+		/// IfcParse::traverse(), in which references are hashed as positions in
+		/// traversal instead of by their ids
+		static uint64_t hash(const aggregate_of_instance::ptr& traversal);
+
+	private:
+		std::map<std::string, entry> previous_;
+
+		mutable std::mutex mutex_;
+		std::map<std::string, entry> current_;
+
+		std::atomic<size_t> reused_{ 0 };
+
+		IncrementalManifest(const IncrementalManifest&);
+		IncrementalManifest& operator=(const IncrementalManifest&);
+	};
+
+}
+
+#endif
@@ -67,6 +67,10 @@
 #include "../ifcgeom/Converter.h"
 #include "../ifcgeom/abstract_mapping.h"
 #include "../ifcgeom/GeometrySerializer.h"
+#include "../ifcgeom/GeometryCache.h"
+#include "../ifcgeom/IncrementalManifest.h"
+#include "../ifcgeom/Profiler.h"
+#include "../ifcgeom/ThreadBudget.h"
 
 #ifdef IFOPSH_WITH_OPENCASCADE
 #include <Standard_Failure.hxx>
@@ -75,6 +79,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <map>
+#include <unordered_map>
 #include <set>
 #include <vector>
 #include <limits>
@@ -83,16 +88,24 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace {
 	struct geometry_conversion_result {
+		// The position of the representation in the order of discovery
 		int index;
 
-		// For NoParallelMapping==true
+		// Estimated relative cost of the conversion, used to order the tasks
+		double cost = 0.;
+		// Whether the task has been processed, for OrderedOutput
+		bool finished = false;
+
+		// When mapped upfront, see Iterator::map_upfront_()
 		ifcopenshell::geometry::taxonomy::ptr item;
 		std::vector<std::pair<const IfcUtil::IfcBaseEntity*, ifcopenshell::geometry::taxonomy::matrix4::ptr>> products;
 
-		// For NoParallelMapping==false
+		// When mapped by the kernels on the conversion threads
 		IfcUtil::IfcBaseEntity* representation;
 		aggregate_of_instance::ptr products_2;
 
@@ -107,6 +120,12 @@ namespace IfcGeom {
 	private:
 		GeometrySerializer* cache_ = nullptr;
 
+		GeometryCache* geometry_cache_ = nullptr;
+		// Hash of the conversion settings, part of every key in the geometry cache
+		size_t geometry_cache_settings_hash_ = 0;
+
+		IncrementalManifest* incremental_manifest_ = nullptr;
+
 		std::atomic<bool> finished_{ false };
 		std::atomic<bool> terminating_{ false };
 		std::atomic<bool> had_error_processing_elements_ { false };
@@ -122,8 +141,15 @@ namespace IfcGeom {
 		typename std::list<IfcGeom::BRepElement*>::const_iterator native_task_result_iterator_;
 
 		std::mutex element_ready_mutex_;
+		// Signalled when an element is appended or when processing has finished
+		std::condition_variable element_ready_;
+		// Signalled when an element is consumed or when the iterator is destroyed, for StreamingWindow
+		std::condition_variable element_consumed_;
 		bool task_result_ptr_initialized = false;
-		// ?
+		// The number of elements appended to all_processed_elements_, including
+		// the ones that have been released since with StreamingWindow
+		size_t elements_appended_ = 0;
+		// The number of elements returned by wait_for_element()
 		size_t async_elements_returned_ = 0;
 		size_t task_result_index_ = 0;
 		
@@ -136,9 +162,21 @@ namespace IfcGeom {
 		// When single-threaded
 		ifcopenshell::geometry::Converter* converter_;
 		
-		// When multi-threaded
+		// When multi-threaded, one per worker thread
 		std::vector<ifcopenshell::geometry::Converter*> kernel_pool;
 
+		// Index of the next task to be claimed by a worker thread
+		std::atomic<size_t> next_task_{ 0 };
+
+		// For OrderedOutput, the tasks in the order of discovery and the index of
+		// the first one of which the elements have not been appended yet
+		std::vector<geometry_conversion_result*> tasks_in_order_;
+		size_t next_in_order_ = 0;
+
+		// Used by estimate_cost_(), prepared on a single thread before the costs are estimated
+		const IfcParse::declaration* boolean_declaration_ = nullptr;
+		std::unordered_map<int, size_t> openings_by_product_;
+
 		// The object is fetched beforehand to be sure that get() returns a valid element
 		TriangulationElement* current_triangulation;
 		BRepElement* current_shape_model;
@@ -166,6 +204,19 @@ namespace IfcGeom {
 	public:
 		void set_cache(GeometrySerializer* cache) { cache_ = cache; }
 
+		/// Reads the triangulations of representations from cache when they have
+		/// been converted before and writes the ones that are converted. Only used
+		/// for triangulated output. Elements read from the cache have no native
+		/// representation, get_native() returns null for them.
+		void set_geometry_cache(GeometryCache* cache) { geometry_cache_ = cache; }
+
+		/// Reads the triangulations of products of which the instances their
+		/// geometry depends on are unchanged since the run of the previous entries
+		/// in manifest from the geometry cache, without mapping or converting their
+		/// representation. The products of this run are recorded in manifest.
+		/// Requires a geometry cache, see set_geometry_cache().
+		void set_incremental_manifest(IncrementalManifest* manifest) { incremental_manifest_ = manifest; }
+
 		const std::string& unit_name() const { return unit_name_; }
 		double unit_magnitude() const { return unit_magnitude_; }
 		// Check if error occurred during iterator initialization or iteration over elements.
@@ -192,11 +243,11 @@ namespace IfcGeom {
 			}
 
 			time_points[0] = high_resolution_clock::now();
-			std::vector<ifcopenshell::geometry::geometry_conversion_task> reps;
-			if (num_threads_ != 1) {
-				// @todo this shouldn't be necessary with properly immutable taxonomy items
-				converter_->mapping()->use_caching() = false;
+			if (geometry_cache_) {
+				geometry_cache_settings_hash_ = GeometryCache::hash(converter_->settings());
 			}
+			std::vector<ifcopenshell::geometry::geometry_conversion_task> reps;
+			converter_->mapping()->num_threads() = (unsigned) (std::max)(num_threads_, 1);
 			try {
 				converter_->mapping()->get_representations(reps, filters_);
 			} catch (const std::exception& e) {
@@ -204,11 +255,26 @@ namespace IfcGeom {
 			}
 			time_points[1] = high_resolution_clock::now();
 
-			for (auto& task : reps) {
+			const bool cost_ordered = num_threads_ != 1 && !settings_.get<ifcopenshell::geometry::settings::NoCostOrdering>().get();
+
+			std::vector<double> costs;
+			if (cost_ordered) {
+				prepare_cost_estimation_();
+				costs.resize(reps.size());
+				ThreadBudget::for_each(reps.size(), [this, &reps, &costs](size_t i) {
+					costs[i] = estimate_cost_(reps[i]);
+				}, (unsigned) (std::max)(num_threads_, 0));
+			}
+
+			for (size_t i = 0; i < reps.size(); ++i) {
+				auto& task = reps[i];
 				geometry_conversion_result res;
 				res.index = task.index;
-				if (!settings_.get<ifcopenshell::geometry::settings::NoParallelMapping>().get()) {
-					res.representation = task.representation;
+				res.representation = task.representation;
+				if (cost_ordered) {
+					res.cost = costs[i];
+				}
+				if (!map_upfront_()) {
 					res.products_2 = task.products;
 				} else {
 					res.item = converter_->mapping()->map(task.representation);
@@ -223,9 +289,33 @@ namespace IfcGeom {
 				tasks_.push_back(res);
 			}
 
+			if (settings_.get<ifcopenshell::geometry::settings::DeduplicateGeometry>().get()) {
+				deduplicate_tasks_();
+			}
+
+			if (num_threads_ != 1) {
+				if (cost_ordered) {
+					// Start the most expensive tasks first, so that a costly task found late
+					// does not keep a single thread busy after the others have run out of work.
+					std::stable_sort(tasks_.begin(), tasks_.end(), [](const geometry_conversion_result& a, const geometry_conversion_result& b) {
+						return a.cost > b.cost;
+					});
+				}
+
+				if (settings_.get<ifcopenshell::geometry::settings::OrderedOutput>().get()) {
+					tasks_in_order_.reserve(tasks_.size());
+					for (auto& r : tasks_) {
+						tasks_in_order_.push_back(&r);
+					}
+					std::sort(tasks_in_order_.begin(), tasks_in_order_.end(), [](const geometry_conversion_result* a, const geometry_conversion_result* b) {
+						return a->index < b->index;
+					});
+				}
+			}
+
 			size_t num_products = 0;
 			for (auto& r : tasks_) {
-				num_products += !settings_.get<ifcopenshell::geometry::settings::NoParallelMapping>().get() ? r.products_2->size() : r.products.size();
+				num_products += !map_upfront_() ? r.products_2->size() : r.products.size();
 			}
 
 			time_points[2] = high_resolution_clock::now();
@@ -290,14 +380,37 @@ namespace IfcGeom {
 		size_t processed_ = 0;
 
 		void process_finished_rep(geometry_conversion_result* rep) {
-			if (rep->elements.empty()) {
-				return;
+			bool appended = false;
+
+			{
+				std::lock_guard<std::mutex> lk(element_ready_mutex_);
+
+				if (tasks_in_order_.empty()) {
+					appended = append_elements_(rep);
+				} else {
+					// Hold back the elements until all tasks found before have finished
+					rep->finished = true;
+					while (next_in_order_ < tasks_in_order_.size() && tasks_in_order_[next_in_order_]->finished) {
+						appended = append_elements_(tasks_in_order_[next_in_order_++]) || appended;
+					}
+				}
 			}
 
-			std::lock_guard<std::mutex> lk(element_ready_mutex_);
+			if (appended) {
+				element_ready_.notify_all();
+			}
+		}
+
+		/// Appends the elements of rep to the processed elements, returns false
+		/// when rep has no elements. Requires element_ready_mutex_ to be locked.
+		bool append_elements_(geometry_conversion_result* rep) {
+			if (rep->elements.empty()) {
+				return false;
+			}
 
 			all_processed_elements_.insert(all_processed_elements_.end(), rep->elements.begin(), rep->elements.end());
 			all_processed_native_elements_.insert(all_processed_native_elements_.end(), rep->breps.begin(), rep->breps.end());
+			elements_appended_ += rep->elements.size();
 
 			if (!task_result_ptr_initialized) {
 				task_result_iterator_ = all_processed_elements_.begin();
@@ -306,6 +419,348 @@ namespace IfcGeom {
 			}
 
 			progress_ = (int) (++processed_ * 100 / tasks_.size());
+
+			return true;
+		}
+
+		/// Whether the representations and products are mapped in initialize(), as
+		/// opposed to by the kernels on the conversion threads
+		bool map_upfront_() const {
+			return settings_.get<ifcopenshell::geometry::settings::NoParallelMapping>().get() ||
+				settings_.get<ifcopenshell::geometry::settings::DeduplicateGeometry>().get();
+		}
+
+		/// Returns item with the placement of its first item moved out of the
+		/// items, together with the placement that was moved, so that items that
+		/// only differ in their placement become equal. Returns item itself and
+		/// null when there is no placement to move.
+		static std::pair<ifcopenshell::geometry::taxonomy::ptr, ifcopenshell::geometry::taxonomy::matrix4::ptr> normalize_placement_(const ifcopenshell::geometry::taxonomy::ptr& item) {
+			using namespace ifcopenshell::geometry;
+
+			auto c = taxonomy::dcast<taxonomy::collection>(item);
+			if (!c || c->children.empty() || (c->matrix && !c->matrix->is_identity())) {
+				return { item, nullptr };
+			}
+			auto placement = c->children.front()->matrix;
+			if (!placement || placement->is_identity()) {
+				return { item, nullptr };
+			}
+			if (std::abs(placement->ccomponents().determinant()) < 1.e-9) {
+				return { item, nullptr };
+			}
+
+			const Eigen::Matrix4d inverse = placement->ccomponents().inverse();
+			auto normalized = taxonomy::collection::ptr(c->clone_());
+			for (auto& child : normalized->children) {
+				const auto child_placement = child->matrix;
+				child = taxonomy::geom_item::ptr(static_cast<taxonomy::geom_item*>(child->clone_()));
+				if (child_placement == placement || (child_placement && child_placement->ccomponents() == placement->ccomponents())) {
+					child->matrix = taxonomy::make<taxonomy::matrix4>();
+				} else if (child_placement) {
+					child->matrix = taxonomy::make<taxonomy::matrix4>(Eigen::Matrix4d(inverse * child_placement->ccomponents()));
+				} else {
+					child->matrix = taxonomy::make<taxonomy::matrix4>(inverse);
+				}
+			}
+			return { normalized, placement };
+		}
+
+		/// Merges the tasks of representations that are equal up to the placement
+		/// of their items into a single task, so that the geometry is converted once
+		/// and the products are emitted as instances of it. Representations are
+		/// bucketed by GeometryCache::hash() after normalize_placement_() and
+		/// merged when their GeometryCache::serialize() is equal, the placement
+		/// that is moved out of the items is applied to the products.
+		/// Products with openings are left alone, as their geometry depends on more
+		/// than the representation. Requires the tasks to be mapped upfront.
+		void deduplicate_tasks_() {
+			using namespace ifcopenshell::geometry;
+
+			if (settings_.get<settings::UseWorldCoords>().get() || settings_.get<settings::ApplyLayerSets>().get()) {
+				Logger::Warning("Geometry is not deduplicated in combination with world coordinates or layer sets");
+				return;
+			}
+
+			auto mapping = converter_->mapping();
+			const bool subtract_openings = !settings_.get<settings::DisableOpeningSubtractions>().get();
+			const bool force_space_transparency = settings_.get<settings::ForceSpaceTransparency>().has();
+
+			struct candidate {
+				taxonomy::ptr item;
+				taxonomy::matrix4::ptr placement;
+				int material_id = 0;
+				bool transparent_space = false;
+				bool applied = false;
+			};
+			std::vector<candidate> candidates(tasks_.size());
+			std::vector<bool> merged(tasks_.size(), false);
+			// Indices of the tasks that are kept by the hash of their normalized representation and the properties of their products
+			std::map<size_t, std::vector<size_t>> unique;
+			// The serializations of the tasks that are kept, computed when another task has the same hash
+			std::vector<std::string> serializations(tasks_.size());
+			size_t num_collisions = 0;
+
+			auto apply = [](geometry_conversion_result& task, candidate& c) {
+				if (c.applied || !c.placement) {
+					return;
+				}
+				task.item = c.item;
+				for (auto& p : task.products) {
+					p.second = taxonomy::make<taxonomy::matrix4>(p.second
+						? Eigen::Matrix4d(p.second->ccomponents() * c.placement->ccomponents())
+						: c.placement->ccomponents());
+				}
+				c.applied = true;
+			};
+
+			for (size_t i = 0; i < tasks_.size(); ++i) {
+				auto& task = tasks_[i];
+				const IfcUtil::IfcBaseEntity* product = task.products.front().first;
+
+				if (subtract_openings && std::any_of(task.products.begin(), task.products.end(), [&mapping](const std::pair<const IfcUtil::IfcBaseEntity*, taxonomy::matrix4::ptr>& p) {
+					return mapping->find_openings(p.first)->size() > 0;
+				})) {
+					continue;
+				}
+
+				auto normalized = normalize_placement_(task.item);
+				std::vector<int> item_ids;
+				auto item_hash = GeometryCache::hash(normalized.first, item_ids);
+				if (!item_hash) {
+					continue;
+				}
+
+				// The material and transparency that Converter::create_brep_for_representation_and_product() apply
+				auto single_material = mapping->get_single_material_association(product);
+				if (!single_material) {
+					auto type_product = mapping->get_product_type(product);
+					if (type_product) {
+						single_material = mapping->get_single_material_association(type_product);
+					}
+				}
+				const int material_id = single_material ? single_material->id() : 0;
+				const bool transparent_space = force_space_transparency && product->declaration().is("IfcSpace");
+				size_t key = *item_hash;
+				boost::hash_combine(key, material_id);
+				boost::hash_combine(key, transparent_space);
+
+				candidates[i] = { normalized.first, normalized.second, material_id, transparent_space };
+				auto& bucket = unique[key];
+
+				auto serialize = [&candidates, &serializations](size_t j) -> const std::string& {
+					if (serializations[j].empty()) {
+						const auto& c = candidates[j];
+						GeometryCache::serialize(c.item, serializations[j]);
+						serializations[j].append(reinterpret_cast<const char*>(&c.material_id), sizeof(c.material_id));
+						serializations[j].push_back(c.transparent_space ? 1 : 0);
+					}
+					return serializations[j];
+				};
+
+				// Equal hashes do not guarantee equal geometry, the serializations are compared as well
+				auto first_it = bucket.end();
+				if (!bucket.empty()) {
+					const std::string& serialization = serialize(i);
+					first_it = std::find_if(bucket.begin(), bucket.end(), [&serialize, &serialization](size_t j) {
+						return serialize(j) == serialization;
+					});
+				}
+
+				if (first_it == bucket.end()) {
+					num_collisions += !bucket.empty();
+					bucket.push_back(i);
+					continue;
+				}
+
+				auto& first = tasks_[*first_it];
+				apply(first, candidates[*first_it]);
+				apply(task, candidates[i]);
+				first.products.insert(first.products.end(), task.products.begin(), task.products.end());
+				merged[i] = true;
+				serializations[i].clear();
+			}
+
+			if (num_collisions) {
+				Logger::Notice(boost::lexical_cast<std::string>(num_collisions) + " representations have the hash of another geometry and are not deduplicated");
+			}
+
+			std::vector<geometry_conversion_result> deduplicated;
+			deduplicated.reserve(tasks_.size());
+			for (size_t i = 0; i < tasks_.size(); ++i) {
+				if (!merged[i]) {
+					deduplicated.push_back(tasks_[i]);
+				}
+			}
+
+			Logger::Notice("Deduplicated " + boost::lexical_cast<std::string>(tasks_.size()) + " representations into " + boost::lexical_cast<std::string>(deduplicated.size()) + " geometries");
+			tasks_.swap(deduplicated);
+		}
+
+		/// Resolves the declarations used by estimate_cost_() and counts the openings
+		/// of every product in one pass over the voiding relationships, so that the
+		/// threads that estimate the costs do not look up inverses.
+		void prepare_cost_estimation_() {
+			auto lookup = [this](const char* name) -> const IfcParse::declaration* {
+				try {
+					return ifc_file->schema()->declaration_by_name(name);
+				} catch (const IfcParse::IfcException&) {
+					return nullptr;
+				}
+			};
+			boolean_declaration_ = lookup("IfcBooleanResult");
+
+			openings_by_product_.clear();
+			if (auto voids_declaration = lookup("IfcRelVoidsElement")) {
+				for (auto& rel : *ifc_file->instances_by_type(voids_declaration)) {
+					// IfcRelVoidsElement.RelatingBuildingElement
+					auto value = rel->data().get_attribute_value(4);
+					if (value.type() == IfcUtil::Argument_ENTITY_INSTANCE) {
+						IfcUtil::IfcBaseClass* host = value;
+						++openings_by_product_[host->id()];
+					}
+				}
+			}
+		}
+
+		/// Counts the elements of the aggregates of entity instances and of nested
+		/// aggregates, such as the faces of a shell or the points of a point list,
+		/// in the attributes of inst and of the instances it refers to, up to depth
+		/// levels deep. Aggregates are not descended into, so that only a handful
+		/// of instances is read for each representation item.
+		double aggregate_cost_(const IfcUtil::IfcBaseClass* inst, int depth) const {
+			static constexpr double element_weight = 4.;
+			static constexpr double boolean_weight = 200.;
+
+			double cost = 1.;
+			if (boolean_declaration_ && inst->declaration().is(*boolean_declaration_)) {
+				cost += boolean_weight;
+			}
+
+			const auto& data = inst->data();
+			for (size_t i = 0; i < data.size(); ++i) {
+				auto value = data.get_attribute_value(i);
+				switch (value.type()) {
+				case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE:
+				case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_INT:
+				case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_DOUBLE:
+				case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE:
+					cost += element_weight * value.size();
+					break;
+				case IfcUtil::Argument_ENTITY_INSTANCE:
+					if (depth > 0) {
+						IfcUtil::IfcBaseClass* ref = value;
+						// Type declarations such as IfcLabel are stored as instances too
+						if (ref && ref->declaration().as_entity()) {
+							cost += aggregate_cost_(ref, depth - 1);
+						}
+					}
+					break;
+				default:
+					break;
+				}
+			}
+
+			return cost;
+		}
+
+		/// Estimates the relative cost of converting the representation of task from
+		/// the sizes of the aggregates its items consist of, with additional weight
+		/// for boolean operations, and from the openings that are subtracted from its
+		/// products. Only the items and the instances close to them are read, so that
+		/// the estimate is cheap compared to the conversion itself.
+		double estimate_cost_(const ifcopenshell::geometry::geometry_conversion_task& task) const {
+			static constexpr double opening_weight = 200.;
+
+			double cost = 0.;
+
+			aggregate_of_instance::ptr items = task.representation->get("Items");
+			if (items) {
+				for (auto& item : *items) {
+					cost += aggregate_cost_(item, 2);
+				}
+			}
+
+			for (auto& prod : *task.products) {
+				cost += 1.;
+				auto it = openings_by_product_.find(prod->id());
+				if (it != openings_by_product_.end()) {
+					cost += opening_weight * it->second;
+				}
+			}
+
+			return cost;
+		}
+
+		/// Converts tasks on the calling thread using kernel until all tasks have
+		/// been claimed. The tasks are claimed one at a time, in order, from the
+		/// shared index, so that threads that finish early pick up the remaining
+		/// work without a thread dedicated to scheduling.
+		void process_tasks_(ifcopenshell::geometry::Converter* kernel) {
+			const size_t window = (size_t) std::max(settings_.get<ifcopenshell::geometry::settings::StreamingWindow>().get(), 0);
+
+			for (size_t i; !terminating_ && (i = next_task_++) < tasks_.size();) {
+				if (window) {
+					// Wait for the consumer to catch up before converting more elements
+					std::unique_lock<std::mutex> lk(element_ready_mutex_);
+					element_consumed_.wait(lk, [this, window]() {
+						return terminating_ || elements_appended_ - async_elements_returned_ < window;
+					});
+				}
+
+				geometry_conversion_result* rep = &tasks_[i];
+				// Catch exceptions to be safe from freezing the iterator.
+				try {
+					this->create_element_(kernel, settings_, rep);
+				} catch (const std::exception& e) {
+					Logger::Error(
+						std::string("Exception '") + e.what() + 
+						std::string("' occurred while iterator was creating a shape: "), 
+						rep->representation
+					);
+					had_error_processing_elements_ = true;
+				} catch (...) {
+					Logger::Error(
+						"Unknown exception occurred while iteartor was creating a shape: ", 
+						rep->representation
+					);
+					had_error_processing_elements_ = true;
+				}
+				process_finished_rep(rep);
+				release_task_(rep);
+			}
+		}
+
+		/// Releases the taxonomy of a processed task when streaming, the elements
+		/// themselves are released by release_consumed_elements_().
+		void release_task_(geometry_conversion_result* rep) {
+			if (settings_.get<ifcopenshell::geometry::settings::StreamingWindow>().get() > 0) {
+				rep->item = nullptr;
+				rep->products.clear();
+				rep->products_2 = nullptr;
+			}
+		}
+
+		/// Deletes the elements before the current element when streaming.
+		void release_consumed_elements_() {
+			if (settings_.get<ifcopenshell::geometry::settings::StreamingWindow>().get() <= 0) {
+				return;
+			}
+
+			const bool native_output = settings_.get<ifcopenshell::geometry::settings::IteratorOutput>().get() == ifcopenshell::geometry::settings::NATIVE;
+
+			{
+				std::lock_guard<std::mutex> lk(element_ready_mutex_);
+				while (all_processed_elements_.begin() != task_result_iterator_) {
+					if (!native_output) {
+						delete all_processed_native_elements_.front();
+					}
+					delete all_processed_elements_.front();
+					all_processed_native_elements_.pop_front();
+					all_processed_elements_.pop_front();
+				}
+			}
+
+			element_consumed_.notify_all();
 		}
 
 		void process_concurrently() {
@@ -317,78 +772,35 @@ namespace IfcGeom {
 			kernel_pool.reserve(conc_threads);
 			for (unsigned i = 0; i < conc_threads; ++i) {
 				kernel_pool.push_back(new ifcopenshell::geometry::Converter(geometry_library_, ifc_file, settings_));
+				// Items mapped by one kernel, or during initialization, are reused by all kernels
+				kernel_pool.back()->mapping()->share_cache(converter_->mapping()->cache());
 			}
 
-			std::vector<std::future<geometry_conversion_result*>> threadpool;			
-			
-			for (auto& rep : tasks_) {
-				ifcopenshell::geometry::Converter* K = nullptr;
-				if (threadpool.size() < kernel_pool.size()) {
-					K = kernel_pool[threadpool.size()];
-				}
-
-				while (threadpool.size() == conc_threads) {
-					for (int i = 0; i < (int)threadpool.size(); i++) {
-						auto& fu = threadpool[i];
-						std::future_status status;
-						status = fu.wait_for(std::chrono::seconds(0));
-						if (status == std::future_status::ready) {
-							process_finished_rep(fu.get());							
-
-							std::swap(threadpool[i], threadpool.back());
-							threadpool.pop_back();
-							std::swap(kernel_pool[i], kernel_pool.back());
-							K = kernel_pool.back();
-							break;
-						} // if
-					}   // for
-				}	 // while
-
-				std::future<geometry_conversion_result*> fu = std::async(
-					std::launch::async, [this](
-						ifcopenshell::geometry::Converter* kernel,
-						ifcopenshell::geometry::Settings settings,
-						geometry_conversion_result* rep) {
-							// Catch exceptions to be safe from freezing the iterator.
-							try {
-								this->create_element_(kernel, settings, rep);
-							} catch (const std::exception& e) {
-								Logger::Error(
-									std::string("Exception '") + e.what() + 
-									std::string("' occurred while iterator was creating a shape: "), 
-									rep->item->instance
-								);
-								had_error_processing_elements_ = true;
-							} catch (...) {
-								Logger::Error(
-									"Unknown exception occurred while iteartor was creating a shape: ", 
-									rep->item->instance
-								);
-								had_error_processing_elements_ = true;
-							}
-							return rep;
-						},
-					K,
-					std::ref(settings_),
-					&rep);
-
-				if (terminating_) {
-					break;
-				}
+			// The workers take the place of the waiting calling thread and other
+			// hardware threads, operations within a task only use the remainder
+			const unsigned reserved_threads = IfcGeom::ThreadBudget::acquire(conc_threads ? (unsigned) conc_threads - 1 : 0);
 
-				threadpool.emplace_back(std::move(fu));
+			std::vector<std::thread> workers;
+			workers.reserve(conc_threads);
+			for (auto* kernel : kernel_pool) {
+				workers.emplace_back([this, kernel]() { process_tasks_(kernel); });
 			}
-
-			for (auto& fu : threadpool) {
-				process_finished_rep(fu.get());
+			for (auto& worker : workers) {
+				worker.join();
 			}
 
-			finished_ = true;
+			IfcGeom::ThreadBudget::release(reserved_threads);
+
+			{
+				std::lock_guard<std::mutex> lk(element_ready_mutex_);
+				finished_ = true;
+			}
+			element_ready_.notify_all();
 
 			Logger::SetProduct(boost::none);
 
 			if (!terminating_) {
-				Logger::Status("\rDone creating geometry (" + boost::lexical_cast<std::string>(all_processed_elements_.size()) +
+				Logger::Status("\rDone creating geometry (" + boost::lexical_cast<std::string>(elements_appended_) +
 					" objects)								");
 			}
 		}
@@ -426,6 +838,7 @@ namespace IfcGeom {
 				} while (++num_created, next());
 			} else {
 				std::vector<ifcopenshell::geometry::geometry_conversion_task> reps;
+				converter_->mapping()->num_threads() = (unsigned) (std::max)(num_threads_, 1);
 				converter_->mapping()->get_representations(reps, filters_);
 
 				std::vector<IfcUtil::IfcBaseClass*> products;
@@ -445,6 +858,47 @@ namespace IfcGeom {
 			}
 		}
 
+		/// Moves the iterator back to the first element once all elements have been
+		/// processed, so that they can be iterated over again without converting
+		/// them again, for example after compute_bounds(true). Returns false when
+		/// processing has not finished or elements have been released because of
+		/// StreamingWindow.
+		bool rewind() {
+			const bool processed = num_threads_ != 1 ? (bool) finished_ : task_iterator_ == tasks_.end();
+			if (!processed || !task_result_ptr_initialized || elements_appended_ != all_processed_elements_.size()) {
+				return false;
+			}
+
+			task_result_iterator_ = all_processed_elements_.begin();
+			native_task_result_iterator_ = all_processed_native_elements_.begin();
+			// The first element is returned by initialize()
+			async_elements_returned_ = 1;
+
+			return true;
+		}
+
+		/// Translates the elements processed so far, so that the model can be
+		/// centered after its bounds have been computed. Triangulations in world
+		/// coordinates have their vertices moved, shared triangulations only once,
+		/// other elements have the translation prepended to their transformation.
+		void translate_elements(double dx, double dy, double dz) {
+			std::lock_guard<std::mutex> lk(element_ready_mutex_);
+
+			const bool world_coords = settings_.get<ifcopenshell::geometry::settings::UseWorldCoords>().get();
+			std::set<const IfcGeom::Representation::Triangulation*> translated;
+
+			for (auto& elem : all_processed_elements_) {
+				auto triangulation_element = world_coords ? dynamic_cast<IfcGeom::TriangulationElement*>(elem) : nullptr;
+				if (triangulation_element) {
+					if (translated.insert(triangulation_element->geometry_pointer().get()).second) {
+						triangulation_element->geometry_pointer()->translate(dx, dy, dz);
+					}
+				} else {
+					elem->transformation().translate(dx, dy, dz);
+				}
+			}
+		}
+
 		int progress() const {
 			return progress_;
 		}
@@ -511,8 +965,11 @@ namespace IfcGeom {
 				}
 			}
 			if (task) {
+				// The item is not mapped when the task is reused from an incremental manifest
+				auto instance = task->representation->as<IfcUtil::IfcBaseClass>();
 				process_finished_rep(task);
-				return task->item->instance->as<IfcUtil::IfcBaseClass>();
+				release_task_(task);
+				return instance;
 			} else {
 				return nullptr;
 			}
@@ -523,16 +980,11 @@ namespace IfcGeom {
 			ifcopenshell::geometry::Settings settings,
 			geometry_conversion_result* rep)
 		{
-			if (!settings_.get<ifcopenshell::geometry::settings::NoParallelMapping>().get()) {
-				rep->item = kernel->mapping()->map(rep->representation);
-				if (!rep->item) {
-					return;
-				}
+			if (!map_upfront_()) {
 				std::transform(rep->products_2->begin(), rep->products_2->end(), std::back_inserter(rep->products), [this, &rep, kernel](IfcUtil::IfcBaseClass* prod) {
 					auto prod_item = kernel->mapping()->map(prod);
 					return std::make_pair(prod->as<IfcUtil::IfcBaseEntity>(), ifcopenshell::geometry::taxonomy::cast<ifcopenshell::geometry::taxonomy::geom_item>(prod_item)->matrix);
 				});
-			} else {
 			}
 
 			auto product_node = rep->products.front();
@@ -540,6 +992,33 @@ namespace IfcGeom {
 			const auto& place = product_node.second;
 
 			Logger::SetProduct(product);
+
+			// Before the representation is mapped, which is not needed when it is unchanged
+			boost::optional<incremental_dependencies> dependencies;
+			if (incremental_manifest_ && geometry_cache_) {
+				dependencies = incremental_dependencies_(kernel, rep);
+				if (dependencies && read_from_incremental_manifest_(kernel, rep, *dependencies)) {
+					return;
+				}
+			}
+
+			if (!map_upfront_()) {
+				rep->item = kernel->mapping()->map(rep->representation);
+				if (!rep->item) {
+					return;
+				}
+			}
+
+			boost::optional<geometry_cache_key> cache_key;
+			if (geometry_cache_) {
+				cache_key = geometry_cache_key_(kernel, rep);
+				if (cache_key && read_from_geometry_cache_(kernel, rep, *cache_key)) {
+					if (dependencies) {
+						record_incremental_(rep, *dependencies, *cache_key);
+					}
+					return;
+				}
+			}
 			
 			IfcGeom::BRepElement* brep = static_cast<IfcGeom::BRepElement*>(decorate_with_cache_(GeometrySerializer::READ_BREP, (std::string)product->get("GlobalId"), std::to_string(rep->item->instance->as<IfcUtil::IfcBaseEntity>()->id()), [kernel, settings, product, place, rep]() {
 				return kernel->create_brep_for_representation_and_product(rep->item, product, place);
@@ -573,6 +1052,388 @@ namespace IfcGeom {
 					}
 				}
 			}
+
+			if (cache_key && write_to_geometry_cache_(rep, *cache_key) && dependencies) {
+				record_incremental_(rep, *dependencies, *cache_key);
+			}
+		}
+
+		struct geometry_cache_key {
+			GeometryCache::key_type key;
+			// Digest of the serialization of what the key is computed from, see GeometryCache::digest()
+			GeometryCache::key_type check;
+			// The ids of the instances of the representation items, see GeometryCache::hash()
+			std::vector<int> item_ids;
+			// The ids of the representation without and with the material of the product
+			std::string id, material_id;
+		};
+
+		/// Returns the key of the triangulation of the task in the geometry cache,
+		/// none when the triangulation cannot be cached. Next to the representation
+		/// and the settings, the key covers everything the conversion in
+		/// Converter::create_brep_for_representation_and_product() depends on: the
+		/// type and material of the product, the openings relative to the product
+		/// and the placement of the product when it is applied to the geometry.
+		boost::optional<geometry_cache_key> geometry_cache_key_(ifcopenshell::geometry::Converter* kernel, geometry_conversion_result* rep) {
+			using namespace ifcopenshell::geometry;
+
+			if (settings_.get<settings::IteratorOutput>().get() != settings::TRIANGULATED ||
+				settings_.get<settings::TriangulationType>().get() != settings::TRIANGLE_MESH ||
+				// Layersets depend on the neighbouring products
+				settings_.get<settings::ApplyLayerSets>().get())
+			{
+				return boost::none;
+			}
+
+			geometry_cache_key key;
+			auto item_hash = GeometryCache::hash(rep->item, key.item_ids);
+			if (!item_hash) {
+				return boost::none;
+			}
+
+			const IfcUtil::IfcBaseEntity* product = rep->products.front().first;
+			const auto& place = rep->products.front().second;
+			auto mapping = kernel->mapping();
+
+			size_t h = geometry_cache_settings_hash_;
+			boost::hash_combine(h, *item_hash);
+			boost::hash_combine(h, product->declaration().name());
+
+			// The same inputs as the key, without relying on the hashes of the taxonomy
+			std::string check_data(reinterpret_cast<const char*>(&geometry_cache_settings_hash_), sizeof(geometry_cache_settings_hash_));
+			GeometryCache::serialize(rep->item, check_data);
+			check_data += product->declaration().name();
+
+			auto single_material = mapping->get_single_material_association(product);
+			if (!single_material) {
+				auto type_product = mapping->get_product_type(product);
+				if (type_product) {
+					single_material = mapping->get_single_material_association(type_product);
+				}
+			}
+			if (single_material) {
+				auto material_style = mapping->map(single_material);
+				boost::hash_combine(h, GeometryCache::hash(taxonomy::cast<taxonomy::style>(material_style)));
+				GeometryCache::serialize(material_style, check_data);
+			}
+
+			if (!settings_.get<settings::DisableOpeningSubtractions>().get()) {
+				auto openings = mapping->find_openings(product);
+				if (openings && openings->size()) {
+					const Eigen::Matrix4d product_inverse = place->ccomponents().inverse();
+					for (auto& opening : *openings) {
+						auto opening_representation = mapping->representation_of(opening->as<IfcUtil::IfcBaseEntity>());
+						if (!opening_representation) {
+							continue;
+						}
+						std::vector<int> opening_item_ids;
+						auto opening_item = mapping->map(opening_representation);
+						auto opening_hash = GeometryCache::hash(opening_item, opening_item_ids);
+						if (!opening_hash) {
+							return boost::none;
+						}
+						auto opening_place = taxonomy::cast<taxonomy::geom_item>(mapping->map(opening))->matrix;
+						auto relative_place = taxonomy::make<taxonomy::matrix4>(product_inverse * opening_place->ccomponents());
+						boost::hash_combine(h, *opening_hash);
+						boost::hash_combine(h, relative_place->hash_components());
+						GeometryCache::serialize(opening_item, check_data);
+						GeometryCache::serialize(relative_place, check_data);
+					}
+				}
+			}
+
+			if (settings_.get<settings::UseWorldCoords>().get()) {
+				boost::hash_combine(h, place->hash_components());
+				GeometryCache::serialize(place, check_data);
+			}
+
+			key.key = h;
+			key.check = GeometryCache::digest(check_data);
+			set_geometry_ids_(kernel, rep->item->instance->as<IfcUtil::IfcBaseEntity>(), product, key);
+			return key;
+		}
+
+		/// Sets the ids of the triangulation of the representation for product
+		/// without and with the material of the product, as assigned by the
+		/// conversion, which name the representation, the material and the
+		/// openings that are applied.
+		void set_geometry_ids_(ifcopenshell::geometry::Converter* kernel, const IfcUtil::IfcBaseEntity* representation, const IfcUtil::IfcBaseEntity* product, geometry_cache_key& key) {
+			using namespace ifcopenshell::geometry;
+
+			auto mapping = kernel->mapping();
+
+			std::ostringstream id;
+			id << representation->id();
+			std::ostringstream suffix;
+
+			if (!settings_.get<settings::DisableOpeningSubtractions>().get()) {
+				auto openings = mapping->find_openings(product);
+				if (openings && openings->size()) {
+					suffix << "-openings";
+					for (auto& opening : *openings) {
+						suffix << "-" << opening->id();
+					}
+				}
+			}
+
+			if (settings_.get<settings::UseWorldCoords>().get()) {
+				suffix << "-world-coords";
+			}
+
+			key.id = id.str() + suffix.str();
+
+			auto single_material = mapping->get_single_material_association(product);
+			if (!single_material) {
+				auto type_product = mapping->get_product_type(product);
+				if (type_product) {
+					single_material = mapping->get_single_material_association(type_product);
+				}
+			}
+			if (single_material) {
+				key.material_id = id.str() + "-material-" + std::to_string(single_material->id()) + suffix.str();
+			}
+		}
+
+		/// Creates the elements of the task from the triangulation in the geometry
+		/// cache, returns false when the triangulation is not in the cache.
+		bool read_from_geometry_cache_(ifcopenshell::geometry::Converter* kernel, geometry_conversion_result* rep, const geometry_cache_key& key) {
+			using namespace ifcopenshell::geometry;
+
+			const IfcUtil::IfcBaseEntity* product = rep->products.front().first;
+			const IfcUtil::IfcBaseEntity* representation = rep->representation;
+
+			auto triangulation = geometry_cache_->read(key.key, key.check, kernel->settings(), product->declaration().name(), key.id, key.material_id, key.item_ids);
+			if (!triangulation) {
+				return false;
+			}
+
+			boost::shared_ptr<IfcGeom::Representation::Triangulation> geometry(triangulation);
+			const std::string context_string = Converter::context_string(representation);
+			const bool world_coords = settings_.get<settings::UseWorldCoords>().get();
+
+			for (auto& p : rep->products) {
+				int parent_id = -1;
+				try {
+					IfcUtil::IfcBaseEntity* parent_object = kernel->mapping()->get_decomposing_entity(p.first);
+					if (parent_object) {
+						parent_id = parent_object->id();
+					}
+				} catch (const std::exception& e) {
+					Logger::Error(e);
+				}
+
+				IfcGeom::Element element(
+					kernel->settings(),
+					p.first->id(),
+					parent_id,
+					p.first->get_value<std::string>("Name", ""),
+					p.first->declaration().name(),
+					p.first->get_value<std::string>("GlobalId", ""),
+					context_string,
+					world_coords ? taxonomy::make<taxonomy::matrix4>() : p.second,
+					p.first
+				);
+
+				// There is no native representation to keep in step with the elements
+				rep->breps.push_back(nullptr);
+				rep->elements.push_back(new TriangulationElement(element, geometry));
+			}
+
+			return true;
+		}
+
+		/// Writes the triangulation of the converted task to the geometry cache,
+		/// returns whether it has been written.
+		bool write_to_geometry_cache_(geometry_conversion_result* rep, const geometry_cache_key& key) {
+			if (rep->elements.empty() || !geometry_cache_->writable()) {
+				return false;
+			}
+
+			auto triangulation_element = static_cast<TriangulationElement*>(rep->elements.front());
+			const std::string& id = triangulation_element->geometry().id();
+
+			// The id tells whether the material of the product was applied. Other ids
+			// mean that the conversion took another route than the key accounts for,
+			// for example because subtracting the openings failed.
+			if (id == key.id) {
+				return geometry_cache_->write(key.key, key.check, triangulation_element->geometry(), key.item_ids, false);
+			} else if (!key.material_id.empty() && id == key.material_id) {
+				return geometry_cache_->write(key.key, key.check, triangulation_element->geometry(), key.item_ids, true);
+			}
+			return false;
+		}
+
+		struct incremental_dependencies {
+			// The instances of the representation in the order of IfcParse::traverse()
+			std::vector<IfcUtil::IfcBaseClass*> instances;
+			// Per product of the task, the hash of the instances its geometry depends on
+			std::vector<uint64_t> hashes;
+		};
+
+		/// Returns per product of the task a hash of the instances its geometry
+		/// depends on: the representation and the styles of its items, the
+		/// placement, type and material of the product and the representations
+		/// and placements of its openings. Returns none for tasks of which the
+		/// products do not share a representation.
+		boost::optional<incremental_dependencies> incremental_dependencies_(ifcopenshell::geometry::Converter* kernel, geometry_conversion_result* rep) {
+			using namespace ifcopenshell::geometry;
+
+			// Deduplicated tasks consist of products with different representations
+			if (settings_.get<settings::DeduplicateGeometry>().get()) {
+				return boost::none;
+			}
+
+			auto mapping = kernel->mapping();
+
+			auto hash_instance = [](size_t& h, IfcUtil::IfcBaseClass* inst) {
+				boost::hash_combine(h, inst ? IncrementalManifest::hash(IfcParse::traverse(inst)) : uint64_t(0));
+			};
+
+			incremental_dependencies dependencies;
+			auto traversal = IfcParse::traverse(rep->representation);
+			dependencies.instances.assign(traversal->begin(), traversal->end());
+
+			size_t representation_hash = geometry_cache_settings_hash_;
+			boost::hash_combine(representation_hash, mapping->get_length_unit());
+			boost::hash_combine(representation_hash, IncrementalManifest::hash(traversal));
+
+			// Styles refer to the items they apply to. Only representation items that
+			// the mapping assigns a style to are looked up, which excludes the points,
+			// directions, placements, curves and topology that make up most of the
+			// traversal.
+			auto styled_item = ifc_file->schema()->declaration_by_name("IfcStyledItem");
+			auto representation_item = ifc_file->schema()->declaration_by_name("IfcRepresentationItem");
+			std::vector<const IfcParse::declaration*> unstyled_items;
+			for (auto& name : { "IfcPoint", "IfcCartesianPointList", "IfcDirection", "IfcVector", "IfcPlacement", "IfcCartesianTransformationOperator", "IfcCurve", "IfcLoop", "IfcEdge", "IfcVertex" }) {
+				try {
+					unstyled_items.push_back(ifc_file->schema()->declaration_by_name(name));
+				} catch (const IfcParse::IfcException&) {
+					// Not every schema has all of these, e.g. IfcCartesianPointList is new in IFC4
+				}
+			}
+			for (auto& inst : dependencies.instances) {
+				const auto& decl = inst->declaration();
+				if (decl.is(*representation_item) && std::none_of(unstyled_items.begin(), unstyled_items.end(), [&decl](const IfcParse::declaration* d) { return decl.is(*d); })) {
+					auto styles = ifc_file->getInverse(inst->id(), styled_item, -1);
+					for (auto& style : *styles) {
+						hash_instance(representation_hash, style);
+					}
+				}
+			}
+
+			auto material_representation = ifc_file->schema()->declaration_by_name("IfcMaterialDefinitionRepresentation");
+
+			for (auto& p : rep->products) {
+				const IfcUtil::IfcBaseEntity* product = p.first;
+
+				size_t h = representation_hash;
+				boost::hash_combine(h, product->declaration().name());
+
+				auto placement = product->get("ObjectPlacement");
+				hash_instance(h, placement.isNull() ? nullptr : (IfcUtil::IfcBaseClass*) placement);
+
+				auto single_material = mapping->get_single_material_association(product);
+				if (!single_material) {
+					auto type_product = mapping->get_product_type(product);
+					if (type_product) {
+						single_material = mapping->get_single_material_association(type_product);
+					}
+				}
+				if (single_material) {
+					hash_instance(h, const_cast<IfcUtil::IfcBaseEntity*>(single_material));
+					auto material_styles = ifc_file->getInverse(single_material->id(), material_representation, -1);
+					for (auto& material_style : *material_styles) {
+						hash_instance(h, material_style);
+					}
+				}
+
+				if (!settings_.get<settings::DisableOpeningSubtractions>().get()) {
+					auto openings = mapping->find_openings(product);
+					if (openings) {
+						boost::hash_combine(h, openings->size());
+						for (auto& opening : *openings) {
+							hash_instance(h, mapping->representation_of(opening->as<IfcUtil::IfcBaseEntity>()));
+							auto opening_placement = opening->as<IfcUtil::IfcBaseEntity>()->get("ObjectPlacement");
+							hash_instance(h, opening_placement.isNull() ? nullptr : (IfcUtil::IfcBaseClass*) opening_placement);
+						}
+					}
+				}
+
+				dependencies.hashes.push_back(h);
+			}
+
+			return dependencies;
+		}
+
+		/// Creates the elements of the task from the geometry cache when the
+		/// dependencies of all of its products are unchanged since the previous
+		/// run, returns false when the task needs to be converted.
+		bool read_from_incremental_manifest_(ifcopenshell::geometry::Converter* kernel, geometry_conversion_result* rep, const incremental_dependencies& dependencies) {
+			std::vector<std::pair<std::string, const IncrementalManifest::entry*>> previous;
+			for (size_t i = 0; i < rep->products.size(); ++i) {
+				const std::string guid = rep->products[i].first->get_value<std::string>("GlobalId", "");
+				auto entry = incremental_manifest_->previous(guid);
+				if (!entry || entry->dependency_hash != dependencies.hashes[i]) {
+					return false;
+				}
+				// All products share the triangulation of the representation
+				if (!previous.empty() && (entry->key != previous.front().second->key || entry->check != previous.front().second->check || entry->item_positions != previous.front().second->item_positions)) {
+					return false;
+				}
+				previous.push_back({ guid, entry });
+			}
+
+			geometry_cache_key key;
+			key.key = previous.front().second->key;
+			key.check = previous.front().second->check;
+			for (auto& i : previous.front().second->item_positions) {
+				if (i >= dependencies.instances.size()) {
+					return false;
+				}
+				key.item_ids.push_back(dependencies.instances[i]->id());
+			}
+			set_geometry_ids_(kernel, rep->representation, rep->products.front().first, key);
+
+			if (!read_from_geometry_cache_(kernel, rep, key)) {
+				return false;
+			}
+
+			for (auto& p : previous) {
+				incremental_manifest_->record(p.first, *p.second);
+				incremental_manifest_->count_reused();
+			}
+
+			return true;
+		}
+
+		/// Records the products of the task in the incremental manifest with the
+		/// triangulation in the geometry cache under key.
+		void record_incremental_(geometry_conversion_result* rep, const incremental_dependencies& dependencies, const geometry_cache_key& key) {
+			std::unordered_map<int, uint32_t> positions;
+			for (uint32_t i = 0; i < (uint32_t) dependencies.instances.size(); ++i) {
+				if (dependencies.instances[i]->declaration().as_entity()) {
+					positions.insert({ dependencies.instances[i]->id(), i });
+				}
+			}
+
+			IncrementalManifest::entry entry;
+			entry.key = key.key;
+			entry.check = key.check;
+			for (auto& id : key.item_ids) {
+				auto it = positions.find(id);
+				if (it == positions.end()) {
+					return;
+				}
+				entry.item_positions.push_back(it->second);
+			}
+
+			for (size_t i = 0; i < rep->products.size(); ++i) {
+				const std::string guid = rep->products[i].first->get_value<std::string>("GlobalId", "");
+				if (!guid.empty()) {
+					entry.dependency_hash = dependencies.hashes[i];
+					incremental_manifest_->record(guid, entry);
+				}
+			}
 		}
 
 		IfcGeom::Element* process_based_on_settings(
@@ -598,6 +1459,7 @@ namespace IfcGeom {
 				return decorate_with_cache_(GeometrySerializer::READ_TRIANGULATION, elem->guid(), gid2, [elem, previous]() {
 					try {
 						if (!previous) {
+							IfcGeom::Profiler::scope profile(IfcGeom::Profiler::TRIANGULATION, elem->type());
 							return new TriangulationElement(*elem);
 						} else {
 							return new TriangulationElement(*elem, previous->geometry_pointer());
@@ -613,21 +1475,15 @@ namespace IfcGeom {
 		}
 
 		bool wait_for_element() {
-			while (true) {
-				size_t s;
-				{
-					std::lock_guard<std::mutex> lk(element_ready_mutex_);
-					s = all_processed_elements_.size();
-				}
-				if (s > async_elements_returned_) {
-					++async_elements_returned_;
-					return true;
-				} else if (finished_) {
-					return false;
-				} else {
-					std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				}
+			std::unique_lock<std::mutex> lk(element_ready_mutex_);
+			element_ready_.wait(lk, [this]() {
+				return elements_appended_ > async_elements_returned_ || finished_;
+			});
+			if (elements_appended_ > async_elements_returned_) {
+				++async_elements_returned_;
+				return true;
 			}
+			return false;
 		}
 
 		void log_timepoints() const {
@@ -678,6 +1534,8 @@ namespace IfcGeom {
 				task_result_iterator_++;
 				native_task_result_iterator_++;
 
+				release_consumed_elements_();
+
 				return (*task_result_iterator_)->product();
 			} else {
 				// Increment the iterator over the list of products using the current
@@ -694,6 +1552,8 @@ namespace IfcGeom {
 				task_result_iterator_++;
 				native_task_result_iterator_++;
 
+				release_consumed_elements_();
+
 				return (*task_result_iterator_)->product();
 			}
 		}
@@ -883,7 +1743,11 @@ namespace IfcGeom {
 
 		~Iterator() {
 			if (num_threads_ != 1) {
-				terminating_ = true;
+				{
+					std::lock_guard<std::mutex> lk(element_ready_mutex_);
+					terminating_ = true;
+				}
+				element_consumed_.notify_all();
 
 				if (init_future_.valid()) {
 					init_future_.wait();
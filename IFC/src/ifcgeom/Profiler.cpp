@@ -0,0 +1,181 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "Profiler.h"
+
+#include "../ifcparse/IfcSchema.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+std::atomic<bool> IfcGeom::Profiler::enabled_(false);
+std::mutex IfcGeom::Profiler::mutex_;
+std::map<std::pair<IfcGeom::Profiler::phase, std::string>, std::vector<double>> IfcGeom::Profiler::samples_;
+std::map<std::string, size_t> IfcGeom::Profiler::counters_;
+
+namespace {
+	// The nested time of the innermost scope on the current thread
+	thread_local double* current_nested = nullptr;
+
+	// Nearest-rank percentile of sorted durations
+	double percentile(const std::vector<double>& sorted, double p) {
+		size_t rank = (size_t) std::ceil(p / 100. * sorted.size());
+		return sorted[rank ? rank - 1 : 0];
+	}
+}
+
+const char* IfcGeom::Profiler::phase_name(phase p) {
+	static const char* const names[NUM_PHASES] = { "mapping", "conversion", "boolean", "triangulation", "serialization" };
+	return names[p];
+}
+
+void IfcGeom::Profiler::record(phase p, const std::string& type, double seconds) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	samples_[{ p, type }].push_back(seconds);
+}
+
+void IfcGeom::Profiler::count(const std::string& counter, size_t n) {
+	if (!enabled_) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	counters_[counter] += n;
+}
+
+size_t IfcGeom::Profiler::counter(const std::string& counter) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = counters_.find(counter);
+	return it == counters_.end() ? 0 : it->second;
+}
+
+void IfcGeom::Profiler::reset() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	samples_.clear();
+	counters_.clear();
+}
+
+void IfcGeom::Profiler::write_json(std::ostream& out) {
+	struct statistics {
+		phase p;
+		std::string type;
+		size_t count;
+		double total, p50, p90, p99, max;
+	};
+
+	std::vector<statistics> rows;
+	double phase_totals[NUM_PHASES] = {};
+	size_t phase_counts[NUM_PHASES] = {};
+	std::map<std::string, size_t> counters;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		counters = counters_;
+		for (auto& s : samples_) {
+			std::vector<double> sorted = s.second;
+			std::sort(sorted.begin(), sorted.end());
+			statistics row;
+			row.p = s.first.first;
+			row.type = s.first.second;
+			row.count = sorted.size();
+			row.total = 0.;
+			for (auto& d : sorted) {
+				row.total += d;
+			}
+			row.p50 = percentile(sorted, 50.);
+			row.p90 = percentile(sorted, 90.);
+			row.p99 = percentile(sorted, 99.);
+			row.max = sorted.back();
+			phase_totals[row.p] += row.total;
+			phase_counts[row.p] += row.count;
+			rows.push_back(row);
+		}
+	}
+
+	std::stable_sort(rows.begin(), rows.end(), [](const statistics& a, const statistics& b) {
+		return a.total > b.total;
+	});
+
+	// Entity type names consist of letters, digits and underscores only, so they need no escaping
+	auto old_flags = out.flags();
+	auto old_precision = out.precision();
+	out << std::setprecision(9);
+
+	out << "{\n  \"phases\": {";
+	for (int i = 0; i < NUM_PHASES; ++i) {
+		out << (i ? "," : "") << "\n    \"" << phase_name((phase) i) << "\": {\"count\": " << phase_counts[i] << ", \"total\": " << phase_totals[i] << "}";
+	}
+	out << "\n  },\n  \"counters\": {";
+	for (auto it = counters.begin(); it != counters.end(); ++it) {
+		out << (it == counters.begin() ? "" : ",") << "\n    \"" << it->first << "\": " << it->second;
+	}
+	out << "\n  },\n  \"types\": [";
+	for (auto it = rows.begin(); it != rows.end(); ++it) {
+		out << (it == rows.begin() ? "" : ",") << "\n    {"
+			<< "\"type\": \"" << it->type << "\", "
+			<< "\"phase\": \"" << phase_name(it->p) << "\", "
+			<< "\"count\": " << it->count << ", "
+			<< "\"total\": " << it->total << ", "
+			<< "\"mean\": " << it->total / it->count << ", "
+			<< "\"p50\": " << it->p50 << ", "
+			<< "\"p90\": " << it->p90 << ", "
+			<< "\"p99\": " << it->p99 << ", "
+			<< "\"max\": " << it->max << "}";
+	}
+	out << "\n  ]\n}\n";
+
+	out.flags(old_flags);
+	out.precision(old_precision);
+}
+
+IfcGeom::Profiler::scope::scope(phase p, const IfcUtil::IfcBaseInterface* instance)
+	: active_(enabled_ && instance), phase_(p), instance_(instance)
+{
+	if (active_) {
+		start_timing_();
+	}
+}
+
+IfcGeom::Profiler::scope::scope(phase p, const std::string& type)
+	: active_(enabled_), phase_(p), instance_(nullptr)
+{
+	if (active_) {
+		type_ = type;
+		start_timing_();
+	}
+}
+
+void IfcGeom::Profiler::scope::start_timing_() {
+	parent_nested_ = current_nested;
+	nested_ = 0.;
+	current_nested = &nested_;
+	start_ = std::chrono::steady_clock::now();
+}
+
+IfcGeom::Profiler::scope::~scope() {
+	if (!active_) {
+		return;
+	}
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+	current_nested = parent_nested_;
+	if (parent_nested_) {
+		*parent_nested_ += elapsed;
+	}
+	record(phase_, instance_ ? instance_->declaration().name() : type_, elapsed - nested_);
+}
@@ -0,0 +1,123 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Aggregates the time spent in the phases of geometry conversion per IFC      *
+ * entity type                                                                  *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "../ifcgeom/ifc_geom_api.h"
+#include "../ifcparse/IfcBaseClass.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace IfcGeom {
+
+	/// Records the wall time and number of calls of the phases of geometry
+	/// conversion per IFC entity type, and named counters of events such as the
+	/// way in which boolean operations are processed. Time is recorded
+	/// exclusively: the time of a scope does not include the time of the scopes
+	/// nested in it on the same thread, so that a boolean operation does not
+	/// also count towards the conversion of its operands and the phases add up
+	/// to the total time.
+	///
+	/// Profiling is disabled by default, in which case a scope or counter only
+	/// checks whether it is enabled.
+	class IFC_GEOM_API Profiler {
+	public:
+		enum phase {
+			MAPPING,
+			CONVERSION,
+			BOOLEAN,
+			TRIANGULATION,
+			SERIALIZATION,
+			NUM_PHASES
+		};
+
+		static const char* phase_name(phase p);
+
+		static void enable(bool b) { enabled_ = b; }
+		static bool enabled() { return enabled_; }
+
+		/// Adds a call of the given duration in seconds
+		static void record(phase p, const std::string& type, double seconds);
+
+		/// Increments a named counter by n
+		static void count(const std::string& counter, size_t n = 1);
+
+		/// The value of a named counter, zero if it was never incremented
+		static size_t counter(const std::string& counter);
+
+		/// Removes all recorded calls and counters
+		static void reset();
+
+		/// Writes the totals per phase, the counters, and the number of calls,
+		/// total time and percentiles of the duration of a call per phase and
+		/// entity type, as a JSON object. Entity types are sorted by descending
+		/// total time.
+		static void write_json(std::ostream& out);
+
+		/// Records the time between its construction and destruction, minus the
+		/// time of the scopes that are nested in it, for the entity type of an
+		/// instance or for a type name.
+		class IFC_GEOM_API scope {
+		public:
+			scope(phase p, const IfcUtil::IfcBaseInterface* instance);
+			scope(phase p, const std::string& type);
+			~scope();
+
+		private:
+			bool active_;
+			phase phase_;
+			const IfcUtil::IfcBaseInterface* instance_;
+			std::string type_;
+			std::chrono::steady_clock::time_point start_;
+			// Time of the scope that encloses this scope on the same thread
+			double* parent_nested_;
+			double nested_;
+
+			void start_timing_();
+
+			scope(const scope&);
+			scope& operator=(const scope&);
+		};
+
+	private:
+		static std::atomic<bool> enabled_;
+		static std::mutex mutex_;
+		// Durations of the calls by phase and entity type
+		static std::map<std::pair<phase, std::string>, std::vector<double>> samples_;
+		static std::map<std::string, size_t> counters_;
+	};
+
+}
+
+#endif
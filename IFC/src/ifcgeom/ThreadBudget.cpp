@@ -0,0 +1,96 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "ThreadBudget.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	std::atomic<int>& available() {
+		static std::atomic<int> available_threads((int) (std::max)(std::thread::hardware_concurrency(), 1U) - 1);
+		return available_threads;
+	}
+}
+
+unsigned IfcGeom::ThreadBudget::acquire(unsigned n) {
+	auto& a = available();
+	int current = a.load();
+	int reserved;
+	do {
+		reserved = (int) (std::min)((unsigned) (std::max)(current, 0), n);
+		if (reserved == 0) {
+			return 0;
+		}
+	} while (!a.compare_exchange_weak(current, current - reserved));
+	return (unsigned) reserved;
+}
+
+void IfcGeom::ThreadBudget::release(unsigned n) {
+	available() += (int) n;
+}
+
+void IfcGeom::ThreadBudget::for_each(size_t n, const std::function<void(size_t)>& fn, unsigned max_threads) {
+	if (n == 0) {
+		return;
+	}
+
+	size_t requested = n - 1;
+	if (max_threads) {
+		requested = (std::min)(requested, (size_t) max_threads - 1);
+	}
+	const unsigned additional = acquire((unsigned) (std::min)(requested, (size_t) (std::numeric_limits<unsigned>::max)()));
+
+	std::atomic<size_t> next(0);
+	std::mutex error_mutex;
+	std::exception_ptr error;
+	auto work = [&]() {
+		for (size_t i; (i = next++) < n;) {
+			try {
+				fn(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(error_mutex);
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(additional);
+	for (unsigned i = 0; i < additional; ++i) {
+		threads.emplace_back(work);
+	}
+	work();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	release(additional);
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
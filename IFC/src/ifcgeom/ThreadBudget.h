@@ -0,0 +1,60 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Bounds the number of threads that geometry conversion uses in total         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef THREADBUDGET_H
+#define THREADBUDGET_H
+
+#include "../ifcgeom/ifc_geom_api.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace IfcGeom {
+
+	/// Process-wide number of threads that can be started in addition to the
+	/// threads that are already running, initially the number of hardware
+	/// threads minus one. The iterator reserves its workers, so that operations
+	/// that split up the conversion of a single shape, such as meshing and
+	/// opening subtraction, only use the hardware threads that the workers
+	/// leave idle instead of starting threads for every hardware thread on
+	/// every worker.
+	class IFC_GEOM_API ThreadBudget {
+	public:
+		/// Reserves up to n threads and returns the number of threads reserved
+		static unsigned acquire(unsigned n);
+
+		/// Returns n threads reserved by acquire()
+		static void release(unsigned n);
+
+		/// Calls fn for the indices [0, n) on the calling thread and on the
+		/// threads that can be reserved, up to n threads in total, and up to
+		/// max_threads when it is not 0. Rethrows the first exception thrown by
+		/// fn after all threads have finished.
+		static void for_each(size_t n, const std::function<void(size_t)>& fn, unsigned max_threads = 0);
+	};
+
+}
+
+#endif
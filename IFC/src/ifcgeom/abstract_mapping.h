@@ -8,9 +8,13 @@
 
 #include <boost/function.hpp>
 
+#include <array>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 
 namespace ifcopenshell {
 
@@ -24,11 +28,58 @@ namespace geometry {
 
 	typedef boost::function<bool(IfcUtil::IfcBaseEntity*)> filter_t;
     
+	/// Mapped taxonomy items by the identity of the instance they were mapped
+	/// from. A single cache can be shared by the mappings of the kernels on
+	/// different threads, so that an instance is mapped once regardless of the
+	/// thread that encounters it. Items are not modified once they are cached,
+	/// conversion code copies an item before modifying it.
+	class mapping_cache {
+	private:
+		// Instance identities are sequential, so consecutive instances end up in
+		// different shards and threads rarely wait for one another.
+		static const size_t num_shards = 64;
+
+		struct shard {
+			std::mutex mutex;
+			std::unordered_map<uint32_t, taxonomy::ptr> items;
+		};
+
+		std::array<shard, num_shards> shards_;
+
+		shard& shard_for_(uint32_t identity) { return shards_[identity % num_shards]; }
+
+	public:
+		/// Returns the item for identity, or null when it has not been mapped
+		taxonomy::ptr find(uint32_t identity) {
+			auto& s = shard_for_(identity);
+			std::lock_guard<std::mutex> guard(s.mutex);
+			auto it = s.items.find(identity);
+			return it == s.items.end() ? nullptr : it->second;
+		}
+
+		/// Stores item for identity. Returns the item that is cached, which is a
+		/// different item when another thread mapped the instance first.
+		taxonomy::ptr insert(uint32_t identity, const taxonomy::ptr& item) {
+			auto& s = shard_for_(identity);
+			std::lock_guard<std::mutex> guard(s.mutex);
+			return s.items.insert({ identity, item }).first->second;
+		}
+
+		void clear() {
+			for (auto& s : shards_) {
+				std::lock_guard<std::mutex> guard(s.mutex);
+				s.items.clear();
+			}
+		}
+	};
+
     class abstract_mapping {
 	protected:
 		Settings settings_;
 
 		bool use_caching_ = true;
+		unsigned num_threads_ = 1;
+		std::shared_ptr<mapping_cache> cache_ = std::make_shared<mapping_cache>();
 
 	public:
 		abstract_mapping(Settings& s) : settings_(s) {}
@@ -52,6 +103,15 @@ namespace geometry {
 
 		bool use_caching() const { return use_caching_; }
 		bool& use_caching() { return use_caching_; }
+
+		/// The maximum number of threads used to find the representations to convert,
+		/// the threads in addition to the calling thread are taken from IfcGeom::ThreadBudget
+		unsigned num_threads() const { return num_threads_; }
+		unsigned& num_threads() { return num_threads_; }
+
+		/// The cache of mapped items, which can be shared with other mappings of the same file and settings
+		const std::shared_ptr<mapping_cache>& cache() const { return cache_; }
+		void share_cache(const std::shared_ptr<mapping_cache>& cache) { cache_ = cache; }
     };
 
 	namespace impl {
@@ -23,6 +23,7 @@
 
 #include "../../../ifcparse/IfcLogger.h"
 #include "../../../ifcgeom/kernels/cgal/CgalConversionResult.h"
+#include "../../../ifcgeom/Profiler.h"
 
 #include <CGAL/minkowski_sum_3.h>
 #include <CGAL/exceptions.h>
@@ -1579,7 +1580,7 @@ bool CgalKernel::process_as_2d_polygon(const taxonomy::boolean_result::ptr br, s
 	const auto& op_0_matrix_2_3 = extrusions[0].second->matrix->ccomponents()(2, 3);
 	if (std::find_if(extrusions.begin() + 1, extrusions.end(), [&op_0_matrix_2_3](extrusion_pair& p) {
 		auto ex = p.second;
-		return op_0_matrix_2_3 < ex->matrix->components()(2, 3);
+		return op_0_matrix_2_3 < ex->matrix->ccomponents()(2, 3);
 	}) != extrusions.end()) {
 		return false;
 	}
@@ -1864,6 +1865,7 @@ bool CgalKernel::convert_impl(const taxonomy::boolean_result::ptr br, Conversion
 		});
 
 		Logger::Notice("Processed boolean operation as 2d arrangement");
+		IfcGeom::Profiler::count("boolean_2d");
 
 		return true;
 
@@ -1873,6 +1875,8 @@ bool CgalKernel::convert_impl(const taxonomy::boolean_result::ptr br, Conversion
 #ifdef IFOPSH_SIMPLE_KERNEL
 	return false;
 #else
+	IfcGeom::Profiler::count("boolean_3d");
+
 	bool first = true;
 
 	CGAL::Nef_polyhedron_3<Kernel_> a;
@@ -7,11 +7,17 @@
 #include <Geom_SphericalSurface.hxx>
 #include <Geom_Plane.hxx>
 #include <BRepTools_WireExplorer.hxx>
+#include <BRepBuilderAPI_MakePolygon.hxx>
+#include <BRepBuilderAPI_MakeFace.hxx>
+#include <TopoDS_Compound.hxx>
+#include <BRep_Builder.hxx>
 
 #include "OpenCascadeConversionResult.h"
 
 #include "../../../ifcparse/IfcLogger.h"
 #include "../../../ifcgeom/IfcGeomRepresentation.h"
+#include "../../../ifcgeom/polygon_triangulation.h"
+#include "../../../ifcgeom/ThreadBudget.h"
 #include "base_utils.h"
 #include "boolean_utils.h"
 
@@ -22,6 +28,8 @@
 #include <unordered_map>
 #include <tuple>
 #include <algorithm>
+#include <mutex>
+#include <thread>
 
 #if OCC_VERSION_HEX >= 0x70600
 #include <TopTools_FormatVersion.hxx>
@@ -43,6 +51,191 @@ namespace {
 			xyz.ChangeData()[2] = v2(2);
 		}
 	}
+
+	// The triangulation of a face, read from the face so that faces can be
+	// read on multiple threads and added to the triangulation in order
+	struct face_buffer {
+		bool has_triangulation;
+		bool is_planar;
+		bool has_inner_bounds;
+		// Transformed coordinates of the nodes
+		std::vector<double> xyz;
+		// Normals of the nodes, empty when normals are not calculated
+		std::vector<double> normals;
+		// Nodes of the triangles, starting at 1, oriented along the face
+		std::vector<int> triangles;
+
+	};
+
+	void read_face(const TopoDS_Face& face, const Eigen::Matrix4d* m, const boost::optional<gp_Mat>& rotation_matrix, bool calculate_normals, face_buffer& buffer) {
+		size_t num_bounds = 0;
+		for (TopoDS_Iterator it(face); it.More(); it.Next(), ++num_bounds) {}
+
+		buffer.is_planar = BRep_Tool::Surface(face) && BRep_Tool::Surface(face)->DynamicType() == STANDARD_TYPE(Geom_Plane);
+		buffer.has_inner_bounds = num_bounds > 1;
+		buffer.xyz.clear();
+		buffer.normals.clear();
+		buffer.triangles.clear();
+
+		TopLoc_Location loc;
+		Handle_Poly_Triangulation tri = BRep_Tool::Triangulation(face, loc);
+		buffer.has_triangulation = !tri.IsNull();
+		if (tri.IsNull()) {
+			return;
+		}
+
+		buffer.xyz.reserve(3 * (size_t) tri->NbNodes());
+		for (int i = 1; i <= tri->NbNodes(); ++i) {
+			gp_XYZ xyz = tri->Node(i).Transformed(loc).XYZ();
+			taxonomy_transform(m, xyz);
+			buffer.xyz.push_back(xyz.X());
+			buffer.xyz.push_back(xyz.Y());
+			buffer.xyz.push_back(xyz.Z());
+		}
+
+		if (calculate_normals) {
+			BRepGProp_Face prop(face);
+			buffer.normals.reserve(3 * (size_t) tri->NbNodes());
+			for (int i = 1; i <= tri->NbNodes(); ++i) {
+				const gp_Pnt2d& uv = tri->UVNode(i);
+				gp_Pnt p;
+				gp_Vec normal_direction;
+				prop.Normal(uv.X(), uv.Y(), p, normal_direction);
+				gp_Vec normal(0., 0., 0.);
+				if (normal_direction.Magnitude() > 1.e-9) {
+					if (rotation_matrix) {
+						normal = gp_Dir(normal_direction.XYZ() * *rotation_matrix);
+					} else {
+						normal = normal_direction;
+					}
+				} else {
+					Handle_Geom_Surface surf = BRep_Tool::Surface(face);
+					// Special case the normal at the poles of a spherical surface
+					if (surf->DynamicType() == STANDARD_TYPE(Geom_SphericalSurface)) {
+						if (fabs(fabs(uv.Y()) - M_PI / 2.) < 1.e-9) {
+							const bool is_top = uv.Y() > 0;
+							const bool is_forward = face.Orientation() == TopAbs_FORWARD;
+							const double z = (is_top == is_forward) ? 1. : -1.;
+							if (rotation_matrix) {
+								normal = gp_Dir(gp_XYZ(0, 0, z) * *rotation_matrix);
+							} else {
+								normal = gp_Dir(gp_XYZ(0, 0, z));
+							}
+						}
+					}
+					// TODO: Do the same for conical surfaces, but they are rare in IFC.
+				}
+				buffer.normals.push_back(normal.X());
+				buffer.normals.push_back(normal.Y());
+				buffer.normals.push_back(normal.Z());
+			}
+		}
+
+		const Poly_Array1OfTriangle& triangles = tri->Triangles();
+		buffer.triangles.reserve(3 * (size_t) triangles.Length());
+		for (int i = 1; i <= triangles.Length(); ++i) {
+			int n1, n2, n3;
+			if (face.Orientation() == TopAbs_REVERSED)
+				triangles(i).Get(n3, n2, n1);
+			else triangles(i).Get(n1, n2, n3);
+			buffer.triangles.push_back(n1);
+			buffer.triangles.push_back(n2);
+			buffer.triangles.push_back(n3);
+		}
+	}
+
+	void read_polygonal_face(const ifcopenshell::geometry::polygonal_faces::face& face, const Eigen::Matrix4d* m, const boost::optional<gp_Mat>& rotation_matrix, bool calculate_normals, face_buffer& buffer) {
+		buffer.has_triangulation = true;
+		buffer.is_planar = true;
+		buffer.has_inner_bounds = face.loops.size() > 1;
+		buffer.xyz.clear();
+		buffer.normals.clear();
+		buffer.triangles.clear();
+
+		const size_t num_nodes = face.xyz.size() / 3;
+		buffer.xyz.reserve(face.xyz.size());
+		for (size_t i = 0; i < num_nodes; ++i) {
+			gp_XYZ xyz(face.xyz[3 * i], face.xyz[3 * i + 1], face.xyz[3 * i + 2]);
+			taxonomy_transform(m, xyz);
+			buffer.xyz.push_back(xyz.X());
+			buffer.xyz.push_back(xyz.Y());
+			buffer.xyz.push_back(xyz.Z());
+		}
+
+		if (calculate_normals) {
+			const gp_XYZ normal_direction(face.normal.x(), face.normal.y(), face.normal.z());
+			const gp_Dir normal = rotation_matrix ? gp_Dir(normal_direction * *rotation_matrix) : gp_Dir(normal_direction);
+			buffer.normals.reserve(face.xyz.size());
+			for (size_t i = 0; i < num_nodes; ++i) {
+				buffer.normals.push_back(normal.X());
+				buffer.normals.push_back(normal.Y());
+				buffer.normals.push_back(normal.Z());
+			}
+		}
+
+		buffer.triangles.reserve(face.triangles.size());
+		for (int n : face.triangles) {
+			buffer.triangles.push_back(n + 1);
+		}
+	}
+
+	// Builds a compound of the polygonal faces, like faceted shells are
+	// converted when they are not reoriented
+	TopoDS_Shape build_polygonal_shape(const ifcopenshell::geometry::polygonal_faces& polygonal) {
+		TopTools_ListOfShape face_list;
+		for (auto& face : polygonal.faces) {
+			TopoDS_Face occ_face;
+			for (auto it = face.loops.begin(); it != face.loops.end(); ++it) {
+				BRepBuilderAPI_MakePolygon polygon;
+				for (int i : *it) {
+					polygon.Add(gp_Pnt(face.xyz[3 * i], face.xyz[3 * i + 1], face.xyz[3 * i + 2]));
+				}
+				polygon.Close();
+				if (!polygon.IsDone()) {
+					continue;
+				}
+				TopoDS_Wire wire = polygon.Wire();
+				if (it == face.loops.begin()) {
+					const double* p = &face.xyz[3 * (size_t) it->front()];
+					BRepBuilderAPI_MakeFace mf(gp_Pln(gp_Pnt(p[0], p[1], p[2]), gp_Dir(face.normal.x(), face.normal.y(), face.normal.z())), wire, true);
+					if (!mf.IsDone()) {
+						break;
+					}
+					occ_face = mf.Face();
+				} else {
+					// Holes are oriented opposite to the outer boundary
+					if (IfcGeom::util::polygon_normal(face.xyz, *it).dot(face.normal) > 0.) {
+						wire.Reverse();
+					}
+					BRepBuilderAPI_MakeFace mf(occ_face);
+					mf.Add(wire);
+					if (mf.IsDone()) {
+						occ_face = mf.Face();
+					}
+				}
+			}
+			if (!occ_face.IsNull()) {
+				face_list.Append(occ_face);
+			}
+		}
+
+		BRep_Builder builder;
+		TopoDS_Compound compound;
+		builder.MakeCompound(compound);
+		for (TopTools_ListIteratorOfListOfShape it(face_list); it.More(); it.Next()) {
+			builder.Add(compound, it.Value());
+		}
+		return compound;
+	}
+}
+
+const TopoDS_Shape& ifcopenshell::geometry::OpenCascadeShape::shape() const {
+	if (polygonal_faces_) {
+		std::call_once(shape_built_, [this]() {
+			shape_ = build_polygonal_shape(*polygonal_faces_);
+		});
+	}
+	return shape_;
 }
 
 void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometry::Settings settings, const ifcopenshell::geometry::taxonomy::matrix4& place, IfcGeom::Representation::Triangulation* t, int item_id, int surface_style_id) const {
@@ -66,96 +259,92 @@ void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometr
 	// to keep track of which edges were already emitted.
 	std::set<std::pair<int, int>> emitted_edges;
 
+	// Faces are meshed and read on multiple threads when there are at least this many
+	const int parallel_meshing_faces = settings.get<settings::ParallelMeshingFaces>().get();
+
+	// Polygonal faces are already triangulated and have no boundary representation
+	const bool polygonal = !!polygonal_faces_;
+
+	std::vector<TopoDS_Face> faces;
+	if (!polygonal) {
+		for (TopExp_Explorer exp(shape_, TopAbs_FACE); exp.More(); exp.Next()) {
+			faces.push_back(TopoDS::Face(exp.Current()));
+		}
+	}
+	const int num_faces = polygonal ? (int) polygonal_faces_->faces.size() : (int) faces.size();
+	const bool parallel = !polygonal && parallel_meshing_faces > 0 && num_faces >= parallel_meshing_faces;
+
 	// Triangulate the shape
-	try {
-		BRepMesh_IncrementalMesh(shape_, settings.get<settings::MesherLinearDeflection>().get(), false, settings.get<settings::MesherAngularDeflection>().get());
-	} catch (...) {
-		Logger::Message(Logger::LOG_ERROR, "Failed to triangulate shape");
-		return;
+	if (!polygonal) {
+		// BRepMesh uses the thread pool of Open CASCADE, which occupies every core
+		// and cannot be limited. It only meshes in parallel when all other cores
+		// are left idle by the other conversions, which are reserved while
+		// meshing, otherwise the shape is meshed on the calling thread.
+		const unsigned pool_threads = (std::max)(std::thread::hardware_concurrency(), 1U) - 1;
+		unsigned mesh_threads = parallel && pool_threads ? IfcGeom::ThreadBudget::acquire(pool_threads) : 0;
+		if (mesh_threads < pool_threads) {
+			IfcGeom::ThreadBudget::release(mesh_threads);
+			mesh_threads = 0;
+		}
+		try {
+			BRepMesh_IncrementalMesh(shape_, settings.get<settings::MesherLinearDeflection>().get(), false, settings.get<settings::MesherAngularDeflection>().get(), mesh_threads > 0);
+		} catch (...) {
+			IfcGeom::ThreadBudget::release(mesh_threads);
+			Logger::Message(Logger::LOG_ERROR, "Failed to triangulate shape");
+			return;
+		}
+		IfcGeom::ThreadBudget::release(mesh_threads);
 	}
 
-	// Iterates over the faces of the shape
-	int num_faces = 0;
-	TopExp_Explorer exp;
-	for (exp.Init(shape_, TopAbs_FACE); exp.More(); exp.Next(), ++num_faces) {
-		TopoDS_Face face = TopoDS::Face(exp.Current());
+	// Vertex normals are only calculated if vertices are not welded and calculation is not disable explicitly.
+	const bool calculate_normals = !settings.get<settings::WeldVertices>().get() &&
+		!settings.get<settings::DontEmitNormals>().get();
+
+	// When reading faces in parallel all faces are read upfront, they are
+	// added to the triangulation in order below, so that the output does not
+	// depend on the number of threads.
+	std::vector<face_buffer> buffers(parallel ? faces.size() : 1);
+	if (parallel) {
+		IfcGeom::ThreadBudget::for_each(faces.size(), [&](size_t i) {
+			read_face(faces[i], place.components_, rotation_matrix, calculate_normals, buffers[i]);
+		});
+	}
 
-		size_t num_bounds = 0; 
-		for (TopoDS_Iterator it(face); it.More(); it.Next(), ++num_bounds) {}
-		
-		const bool is_planar = BRep_Tool::Surface(face) && BRep_Tool::Surface(face)->DynamicType() == STANDARD_TYPE(Geom_Plane);
-		const bool has_inner_bounds = num_bounds > 1;
+	// Iterates over the faces of the shape
+	for (size_t face_index = 0; face_index < (size_t) num_faces; ++face_index) {
+		face_buffer& buffer = buffers[parallel ? face_index : 0];
+		if (polygonal) {
+			read_polygonal_face(polygonal_faces_->faces[face_index], place.components_, rotation_matrix, calculate_normals, buffer);
+		} else if (!parallel) {
+			read_face(faces[face_index], place.components_, rotation_matrix, calculate_normals, buffer);
+		}
 
-		const bool polyhedral_output_with_holes = settings.get<settings::TriangulationType>().get() == settings::POLYHEDRON_WITH_HOLES && is_planar;
-		const bool polyhedral_output_without_holes = settings.get<settings::TriangulationType>().get() == settings::POLYHEDRON_WITHOUT_HOLES && is_planar && !has_inner_bounds;
+		const bool polyhedral_output_with_holes = settings.get<settings::TriangulationType>().get() == settings::POLYHEDRON_WITH_HOLES && buffer.is_planar;
+		const bool polyhedral_output_without_holes = settings.get<settings::TriangulationType>().get() == settings::POLYHEDRON_WITHOUT_HOLES && buffer.is_planar && !buffer.has_inner_bounds;
 
 		std::vector<std::tuple<int, int, int>> triangle_indices;
 
-		TopLoc_Location loc;
-		Handle_Poly_Triangulation tri = BRep_Tool::Triangulation(face, loc);
-
-		if (tri.IsNull()) {
+		if (!buffer.has_triangulation) {
 			Logger::Message(Logger::LOG_ERROR, "Triangulation missing for face");
 		} else {
 			// Keep track of the number of times an edge is used
 			// Manifold edges (i.e. edges used twice) are deemed invisible
 			std::map<std::pair<int, int>, int> edgecount;
 
-			std::vector<gp_XYZ> coords;
-			BRepGProp_Face prop(face);
-			std::map<int, int> dict;
+			// dict[n - 1] is the index in the triangulation of node n of the face
+			std::vector<int> dict;
+			t->addVertices(item_id, surface_style_id, buffer.xyz, dict);
 
-			// Vertex normals are only calculated if vertices are not welded and calculation is not disable explicitly.
-			const bool calculate_normals = !settings.get<settings::WeldVertices>().get() &&
-				!settings.get<settings::DontEmitNormals>().get();
-
-			for (int i = 1; i <= tri->NbNodes(); ++i) {
-				coords.push_back(tri->Node(i).Transformed(loc).XYZ());
-				taxonomy_transform(place.components_, *coords.rbegin());
-				const gp_XYZ& last = *coords.rbegin();
-				dict[i] = t->addVertex(item_id, surface_style_id, last.X(), last.Y(), last.Z());
-
-				if (calculate_normals) {
-					const gp_Pnt2d& uv = tri->UVNode(i);
-					gp_Pnt p;
-					gp_Vec normal_direction;
-					prop.Normal(uv.X(), uv.Y(), p, normal_direction);
-					gp_Vec normal(0., 0., 0.);
-					if (normal_direction.Magnitude() > 1.e-9) {
-						if (rotation_matrix) {
-							normal = gp_Dir(normal_direction.XYZ() * *rotation_matrix);
-						} else {
-							normal = normal_direction;
-						}
-					} else {
-						Handle_Geom_Surface surf = BRep_Tool::Surface(face);
-						// Special case the normal at the poles of a spherical surface
-						if (surf->DynamicType() == STANDARD_TYPE(Geom_SphericalSurface)) {
-							if (fabs(fabs(uv.Y()) - M_PI / 2.) < 1.e-9) {
-								const bool is_top = uv.Y() > 0;
-								const bool is_forward = face.Orientation() == TopAbs_FORWARD;
-								const double z = (is_top == is_forward) ? 1. : -1.;
-								if (rotation_matrix) {
-									normal = gp_Dir(gp_XYZ(0, 0, z) * *rotation_matrix);
-								} else {
-									normal = gp_Dir(gp_XYZ(0, 0, z));
-								}
-							}
-						}
-						// TODO: Do the same for conical surfaces, but they are rare in IFC.
-					}
-					t->addNormal(normal.X(), normal.Y(), normal.Z());
-				}
+			for (size_t i = 0; i < buffer.normals.size(); i += 3) {
+				t->addNormal(buffer.normals[i], buffer.normals[i + 1], buffer.normals[i + 2]);
 			}
 
-			const Poly_Array1OfTriangle& triangles = tri->Triangles();
-			for (int i = 1; i <= triangles.Length(); ++i) {
-				int n1, n2, n3;
-				if (face.Orientation() == TopAbs_REVERSED)
-					triangles(i).Get(n3, n2, n1);
-				else triangles(i).Get(n1, n2, n3);
+			for (size_t i = 0; i < buffer.triangles.size(); i += 3) {
+				const int n1 = buffer.triangles[i];
+				const int n2 = buffer.triangles[i + 1];
+				const int n3 = buffer.triangles[i + 2];
 
-				if (dict[n1] == dict[n2] || dict[n2] == dict[n3] || dict[n3] == dict[n1]) {
+				if (dict[n1 - 1] == dict[n2 - 1] || dict[n2 - 1] == dict[n3 - 1] || dict[n3 - 1] == dict[n1 - 1]) {
 					Logger::Warning("Mesher generated a degenerate triangle, ignoring");
 					continue;
 				}
@@ -175,18 +364,18 @@ void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometr
 				*/
 
 				if (polyhedral_output_without_holes || polyhedral_output_with_holes) {
-					triangle_indices.push_back({ dict[n1], dict[n2], dict[n3] });
+					triangle_indices.push_back({ dict[n1 - 1], dict[n2 - 1], dict[n3 - 1] });
 				} else {
 					if (settings.get<settings::TriangulationType>().get() == settings::POLYHEDRON_WITHOUT_HOLES) {
-						t->addFace(item_id, surface_style_id, std::vector<int>{ dict[n1], dict[n2], dict[n3] });
+						t->addFace(item_id, surface_style_id, std::vector<int>{ dict[n1 - 1], dict[n2 - 1], dict[n3 - 1] });
 					} else if (settings.get<settings::TriangulationType>().get() == settings::POLYHEDRON_WITH_HOLES) {
-						t->addFace(item_id, surface_style_id, std::vector<std::vector<int>>{{ dict[n1], dict[n2], dict[n3] }});
+						t->addFace(item_id, surface_style_id, std::vector<std::vector<int>>{{ dict[n1 - 1], dict[n2 - 1], dict[n3 - 1] }});
 					} else {
-						t->addFace(item_id, surface_style_id, dict[n1], dict[n2], dict[n3]);
+						t->addFace(item_id, surface_style_id, dict[n1 - 1], dict[n2 - 1], dict[n3 - 1]);
 
-						t->registerEdgeCount(dict[n1], dict[n2], edgecount);
-						t->registerEdgeCount(dict[n2], dict[n3], edgecount);
-						t->registerEdgeCount(dict[n3], dict[n1], edgecount);
+						t->registerEdgeCount(dict[n1 - 1], dict[n2 - 1], edgecount);
+						t->registerEdgeCount(dict[n2 - 1], dict[n3 - 1], edgecount);
+						t->registerEdgeCount(dict[n3 - 1], dict[n1 - 1], edgecount);
 					}
 				}
 			}
@@ -215,6 +404,11 @@ void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometr
 				}
 			}
 		}
+
+		if (parallel) {
+			// Releases the face as soon as it is added
+			buffer = face_buffer();
+		}
 	}
 
 	if (!t->normals().empty() && settings.get<settings::GenerateUvs>().get()) {
@@ -229,7 +423,7 @@ void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometr
 
 		TopTools_ListOfShape edges;
 		// First collect edges part of wire in order
-		for (TopExp_Explorer texp(shape_, TopAbs_WIRE); texp.More(); texp.Next()) {
+		for (TopExp_Explorer texp(shape(), TopAbs_WIRE); texp.More(); texp.Next()) {
 			BRepTools_WireExplorer wexp(TopoDS::Wire(texp.Current()));
 			for (; wexp.More(); wexp.Next()) {
 				edges.Append(wexp.Current());
@@ -237,7 +431,7 @@ void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometr
 		}
 
 		// Then collect edges not part of wire
-		for (TopExp_Explorer texp(shape_, TopAbs_EDGE, TopAbs_WIRE); texp.More(); texp.Next()) {
+		for (TopExp_Explorer texp(shape(), TopAbs_EDGE, TopAbs_WIRE); texp.More(); texp.Next()) {
 			edges.Append(texp.Current());
 		}
 
@@ -302,11 +496,13 @@ void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometr
 		}
 	}
 
-	BRepTools::Clean(shape_);
+	if (!polygonal) {
+		BRepTools::Clean(shape_);
+	}
 }
 
 void ifcopenshell::geometry::OpenCascadeShape::Serialize(const ifcopenshell::geometry::taxonomy::matrix4& place, std::string& r) const {
-	auto s = IfcGeom::util::apply_transformation(shape_, place);
+	auto s = IfcGeom::util::apply_transformation(shape(), place);
 	std::stringstream sstream;
 #if OCC_VERSION_HEX >= 0x70600
 	BRepTools::Write(s, sstream, false, false, TopTools_FormatVersion_VERSION_2);
@@ -317,32 +513,32 @@ void ifcopenshell::geometry::OpenCascadeShape::Serialize(const ifcopenshell::geo
 }
 
 int ifcopenshell::geometry::OpenCascadeShape::surface_genus() const {
-	return IfcGeom::util::surface_genus(shape_);
+	return IfcGeom::util::surface_genus(shape());
 }
 
 bool ifcopenshell::geometry::OpenCascadeShape::is_manifold() const {
-	return IfcGeom::util::is_manifold(shape_);
+	return IfcGeom::util::is_manifold(shape());
 }
 
 int ifcopenshell::geometry::OpenCascadeShape::num_vertices() const
 {
-	return IfcGeom::util::count(shape_, TopAbs_VERTEX);
+	return IfcGeom::util::count(shape(), TopAbs_VERTEX);
 }
 
 int ifcopenshell::geometry::OpenCascadeShape::num_edges() const
 {
-	return IfcGeom::util::count(shape_, TopAbs_EDGE);
+	return IfcGeom::util::count(shape(), TopAbs_EDGE);
 }
 
 int ifcopenshell::geometry::OpenCascadeShape::num_faces() const
 {
-	return IfcGeom::util::count(shape_, TopAbs_FACE);
+	return IfcGeom::util::count(shape(), TopAbs_FACE);
 }
 
 OpaqueNumber* ifcopenshell::geometry::OpenCascadeShape::OpenCascadeShape::length()
 {
 	GProp_GProps prop;
-	BRepGProp::LinearProperties(shape_, prop);
+	BRepGProp::LinearProperties(shape(), prop);
 	double l = prop.Mass();
 	return new NumberNativeDouble(l);
 }
@@ -350,7 +546,7 @@ OpaqueNumber* ifcopenshell::geometry::OpenCascadeShape::OpenCascadeShape::length
 OpaqueNumber* ifcopenshell::geometry::OpenCascadeShape::area()
 {
 	GProp_GProps prop;
-	BRepGProp::SurfaceProperties(shape_, prop);
+	BRepGProp::SurfaceProperties(shape(), prop);
 	double l = prop.Mass();
 	return new NumberNativeDouble(l);
 }
@@ -358,7 +554,7 @@ OpaqueNumber* ifcopenshell::geometry::OpenCascadeShape::area()
 OpaqueNumber* ifcopenshell::geometry::OpenCascadeShape::volume()
 {
 	GProp_GProps prop;
-	BRepGProp::VolumeProperties(shape_, prop);
+	BRepGProp::VolumeProperties(shape(), prop);
 	double l = prop.Mass();
 	return new NumberNativeDouble(l);
 }
@@ -367,8 +563,8 @@ OpaqueNumber* ifcopenshell::geometry::OpenCascadeShape::volume()
 
 OpaqueCoordinate<3> ifcopenshell::geometry::OpenCascadeShape::position()
 {
-	if (shape_.ShapeType() == TopAbs_FACE) {
-		auto surf = BRep_Tool::Surface(TopoDS::Face(shape_));
+	if (shape().ShapeType() == TopAbs_FACE) {
+		auto surf = BRep_Tool::Surface(TopoDS::Face(shape()));
 		auto plane = Handle(Geom_Plane)::DownCast(surf);
 		if (plane) {
 			auto loc = plane->Location();
@@ -384,8 +580,8 @@ OpaqueCoordinate<3> ifcopenshell::geometry::OpenCascadeShape::position()
 
 OpaqueCoordinate<3> ifcopenshell::geometry::OpenCascadeShape::axis()
 {
-	if (shape_.ShapeType() == TopAbs_FACE) {
-		auto surf = BRep_Tool::Surface(TopoDS::Face(shape_));
+	if (shape().ShapeType() == TopAbs_FACE) {
+		auto surf = BRep_Tool::Surface(TopoDS::Face(shape()));
 		auto plane = Handle(Geom_Plane)::DownCast(surf);
 		if (plane) {
 			auto dir = plane->Axis().Direction();
@@ -401,8 +597,8 @@ OpaqueCoordinate<3> ifcopenshell::geometry::OpenCascadeShape::axis()
 
 OpaqueCoordinate<4> ifcopenshell::geometry::OpenCascadeShape::plane_equation()
 {
-	if (shape_.ShapeType() == TopAbs_FACE) {
-		auto surf = BRep_Tool::Surface(TopoDS::Face(shape_));
+	if (shape().ShapeType() == TopAbs_FACE) {
+		auto surf = BRep_Tool::Surface(TopoDS::Face(shape()));
 		auto plane = Handle(Geom_Plane)::DownCast(surf);
 		if (plane) {
 			double a, b, c, d;
@@ -441,7 +637,7 @@ ConversionResultShape * ifcopenshell::geometry::OpenCascadeShape::box()
 std::vector<ConversionResultShape*> ifcopenshell::geometry::OpenCascadeShape::vertices()
 {
 	TopTools_IndexedMapOfShape map;
-	TopExp::MapShapes(shape_, TopAbs_VERTEX, map);
+	TopExp::MapShapes(shape(), TopAbs_VERTEX, map);
 	std::vector<ConversionResultShape*> vec;
 	for (int i = 1; i <= map.Extent(); ++i) {
 		vec.push_back(new OpenCascadeShape(map.FindKey(i)));
@@ -452,7 +648,7 @@ std::vector<ConversionResultShape*> ifcopenshell::geometry::OpenCascadeShape::ve
 std::vector<ConversionResultShape*> ifcopenshell::geometry::OpenCascadeShape::edges()
 {
 	TopTools_IndexedMapOfShape map;
-	TopExp::MapShapes(shape_, TopAbs_EDGE, map);
+	TopExp::MapShapes(shape(), TopAbs_EDGE, map);
 	std::vector<ConversionResultShape*> vec;
 	for (int i = 1; i <= map.Extent(); ++i) {
 		vec.push_back(new OpenCascadeShape(map.FindKey(i)));
@@ -463,7 +659,7 @@ std::vector<ConversionResultShape*> ifcopenshell::geometry::OpenCascadeShape::ed
 std::vector<ConversionResultShape*> ifcopenshell::geometry::OpenCascadeShape::facets()
 {
 	TopTools_IndexedMapOfShape map;
-	TopExp::MapShapes(shape_, TopAbs_FACE, map);
+	TopExp::MapShapes(shape(), TopAbs_FACE, map);
 	std::vector<ConversionResultShape*> vec;
 	for (int i = 1; i <= map.Extent(); ++i) {
 		vec.push_back(new OpenCascadeShape(map.FindKey(i)));
@@ -489,17 +685,17 @@ namespace {
 
 ConversionResultShape* ifcopenshell::geometry::OpenCascadeShape::add(ConversionResultShape* other)
 {
-	return boolean_op(BOPAlgo_FUSE, shape_, ((ifcopenshell::geometry::OpenCascadeShape*)other)->shape_);
+	return boolean_op(BOPAlgo_FUSE, shape(), ((ifcopenshell::geometry::OpenCascadeShape*)other)->shape());
 }
 
 ConversionResultShape* ifcopenshell::geometry::OpenCascadeShape::subtract(ConversionResultShape* other)
 {
-	return boolean_op(BOPAlgo_CUT, shape_, ((ifcopenshell::geometry::OpenCascadeShape*)other)->shape_);
+	return boolean_op(BOPAlgo_CUT, shape(), ((ifcopenshell::geometry::OpenCascadeShape*)other)->shape());
 }
 
 ConversionResultShape* ifcopenshell::geometry::OpenCascadeShape::intersect(ConversionResultShape* other)
 {
-	return boolean_op(BOPAlgo_COMMON, shape_, ((ifcopenshell::geometry::OpenCascadeShape*)other)->shape_);
+	return boolean_op(BOPAlgo_COMMON, shape(), ((ifcopenshell::geometry::OpenCascadeShape*)other)->shape());
 }
 
 std::pair<OpaqueCoordinate<3>, OpaqueCoordinate<3>> ifcopenshell::geometry::OpenCascadeShape::bounding_box() const
@@ -509,7 +705,7 @@ std::pair<OpaqueCoordinate<3>, OpaqueCoordinate<3>> ifcopenshell::geometry::Open
 
 ConversionResultShape* ifcopenshell::geometry::OpenCascadeShape::moved(ifcopenshell::geometry::taxonomy::matrix4::ptr t) const
 {
-	return new OpenCascadeShape(IfcGeom::util::apply_transformation(shape_, *t));
+	return new OpenCascadeShape(IfcGeom::util::apply_transformation(shape(), *t));
 }
 
 void ifcopenshell::geometry::OpenCascadeShape::map(OpaqueCoordinate<4>&, OpaqueCoordinate<4>&) {
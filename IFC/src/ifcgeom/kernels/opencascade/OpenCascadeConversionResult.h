@@ -36,24 +36,53 @@
 
 #include "../../../ifcgeom/ConversionResult.h"
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace ifcopenshell {
 	namespace geometry {
 
 		using IfcGeom::OpaqueCoordinate;
 		using IfcGeom::OpaqueNumber;
 
+		// The planar faces of a faceted representation item that have been
+		// triangulated without constructing a boundary representation
+		struct polygonal_faces {
+			struct face {
+				// The coordinates of the vertices of the face
+				std::vector<double> xyz;
+				// The outer boundary followed by the holes, as indices into xyz
+				std::vector<std::vector<int>> loops;
+				// Triangles as indices into xyz, counter-clockwise around normal
+				std::vector<int> triangles;
+				// The unit normal of the face
+				Eigen::Vector3d normal;
+			};
+
+			std::vector<face> faces;
+		};
+
 		class OpenCascadeShape : public IfcGeom::ConversionResultShape {
 		public:
 			OpenCascadeShape(const TopoDS_Shape& shape)
 				: shape_(shape) {}
 
-			const TopoDS_Shape& shape() const { return shape_; }
-			operator const TopoDS_Shape& () { return shape_; }
+			// The boundary representation of polygonal faces is only constructed
+			// when it is requested, triangulation uses the faces directly.
+			OpenCascadeShape(const std::shared_ptr<const polygonal_faces>& faces)
+				: polygonal_faces_(faces) {}
+
+			const TopoDS_Shape& shape() const;
+			operator const TopoDS_Shape& () { return shape(); }
 
 			virtual void Triangulate(ifcopenshell::geometry::Settings settings, const ifcopenshell::geometry::taxonomy::matrix4& place, IfcGeom::Representation::Triangulation* t, int item_id, int surface_style_id) const;
 			virtual void Serialize(const ifcopenshell::geometry::taxonomy::matrix4& place, std::string&) const;
 
 			virtual IfcGeom::ConversionResultShape* clone() const {
+				if (polygonal_faces_) {
+					return new OpenCascadeShape(polygonal_faces_);
+				}
 				return new OpenCascadeShape(shape_);
 			}
 
@@ -100,7 +129,9 @@ namespace ifcopenshell {
 			virtual void map(const std::vector<OpaqueCoordinate<4>>& from, const std::vector<OpaqueCoordinate<4>>& to);
 			virtual ConversionResultShape* moved(ifcopenshell::geometry::taxonomy::matrix4::ptr) const;
 		private:
-			TopoDS_Shape shape_;
+			mutable TopoDS_Shape shape_;
+			std::shared_ptr<const polygonal_faces> polygonal_faces_;
+			mutable std::once_flag shape_built_;
 		};
 
 	}
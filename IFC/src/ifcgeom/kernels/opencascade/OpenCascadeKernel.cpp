@@ -27,8 +27,12 @@
 
 #include "boolean_utils.h"
 #include "base_utils.h"
+#include "IfcGeomTree.h"
+#include "../../../ifcgeom/ThreadBudget.h"
 
 #include <BRepPrimAPI_MakeRevol.hxx>
+#include <BRepBndLib.hxx>
+#include <Bnd_Box.hxx>
 
 namespace {
 	struct opening_sorter {
@@ -105,125 +109,256 @@ bool IfcGeom::OpenCascadeKernel::convert_openings(const IfcUtil::IfcBaseEntity*
 
 	std::sort(opening_vector.begin(), opening_vector.end(), opening_sorter());
 
-	// Iterate over the shapes of the IfcProduct
-	for (IfcGeom::ConversionResults::const_iterator it3 = entity_shapes.begin(); it3 != entity_shapes.end(); ++it3) {
-
-		TopoDS_Compound C;
-		BRep_Builder B;
-		B.MakeCompound(C);
-		TopoDS_Shape combined_result;
-
-		std::list<TopoDS_Shape> parts;
-
-		auto it3_shape = std::static_pointer_cast<OpenCascadeShape>(it3->Shape())->shape();
-		if (it3_shape.IsNull()) {
-			Logger::Error("Null operand");
-			continue;
+	// The bounding boxes of the openings are put in a tree, so that every solid of
+	// the IfcProduct is only cut by the openings near it
+	IfcGeom::impl::tree<size_t> opening_tree;
+	for (size_t i = 0; i < opening_vector.size(); ++i) {
+		Bnd_Box b;
+		BRepBndLib::Add(opening_vector[i].second, b);
+		if (!b.IsVoid()) {
+			opening_tree.add(i, b);
 		}
+	}
 
-		bool is_multiple = it3_shape.ShapeType() == TopAbs_COMPOUND && TopoDS_Iterator(it3_shape).More() && util::is_nested_compound_of_solid(it3_shape);
+	auto subtract_openings = [&](const TopoDS_Shape& entity_part, const Eigen::Matrix4d& m) {
+		bool is_manifold = util::is_manifold(entity_part);
 
-		if (is_multiple) {
-			TopoDS_Iterator sit(it3_shape);
-			for (; sit.More(); sit.Next()) {
-				parts.push_back(sit.Value());
-			}
-		} else {
-			parts.push_back(it3_shape);
+		if (!is_manifold) {
+			Logger::Warning("Non-manifold first operand");
 		}
 
-		for (auto& entity_part : parts) {
-			bool is_manifold = util::is_manifold(entity_part);
+		TopoDS_Shape entity_part_result;
 
-			if (!is_manifold) {
-				Logger::Warning("Non-manifold first operand");
+		for (int as_shell = 0; as_shell < 2; ++as_shell) {
+			TopoDS_Shape entity_shape_unlocated;
+			if (as_shell) {
+				entity_shape_unlocated = entity_part;
+			} else {
+				entity_shape_unlocated = util::ensure_fit_for_subtraction(entity_part, settings_.get<settings::Precision>().get());
 			}
+			// @todo
+			// if (entity_shape_gtrsf.Form() == gp_Other) {
+			// 	Logger::Message(Logger::LOG_WARNING, "Applying non uniform transformation to:", entity);
+			// }
+			gp_Trsf entity_shape_gtrsf;
+			entity_shape_gtrsf.SetValues(
+				m(0, 0), m(0, 1), m(0, 2), m(0, 3),
+				m(1, 0), m(1, 1), m(1, 2), m(1, 3),
+				m(2, 0), m(2, 1), m(2, 2), m(2, 3)
+			);
+			TopoDS_Shape entity_shape = util::apply_transformation(entity_shape_unlocated, entity_shape_gtrsf);
 
-			TopoDS_Shape entity_part_result;
-
-			for (int as_shell = 0; as_shell < 2; ++as_shell) {
-				TopoDS_Shape entity_shape_unlocated;
-				if (as_shell) {
-					entity_shape_unlocated = entity_part;
+			// Openings with a disjoint bounding box would be eliminated by the boolean
+			// operation, but only after they have been unified, which dominates the cost
+			// for elements consisting of many solids.
+			std::vector< std::pair<double, TopoDS_Shape> > part_openings;
+			{
+				Bnd_Box b;
+				BRepBndLib::Add(entity_shape, b);
+				if (b.IsVoid()) {
+					part_openings = opening_vector;
 				} else {
-					entity_shape_unlocated = util::ensure_fit_for_subtraction(entity_part, settings_.get<settings::Precision>().get());
+					b.Enlarge(bst.precision);
+					auto selected = opening_tree.select_box(b);
+					// Retain the order by size
+					std::sort(selected.begin(), selected.end());
+					for (auto& i : selected) {
+						part_openings.push_back(opening_vector[i]);
+					}
 				}
-				const auto& m = it3->Placement()->ccomponents();
-				// @todo
-				// if (entity_shape_gtrsf.Form() == gp_Other) {
-				// 	Logger::Message(Logger::LOG_WARNING, "Applying non uniform transformation to:", entity);
-				// }
-				gp_Trsf entity_shape_gtrsf;
-				entity_shape_gtrsf.SetValues(
-					m(0, 0), m(0, 1), m(0, 2), m(0, 3),
-					m(1, 0), m(1, 1), m(1, 2), m(1, 3),
-					m(2, 0), m(2, 1), m(2, 2), m(2, 3)
-				);
-				TopoDS_Shape entity_shape = util::apply_transformation(entity_shape_unlocated, entity_shape_gtrsf);
-
-				TopoDS_Shape result = entity_shape;
+			}
 
-				auto it = opening_vector.begin();
-				auto jt = it;
+			if (part_openings.empty()) {
+				return entity_shape;
+			}
 
-				for (;; ++it) {
-					if (it == opening_vector.end() || jt->first / it->first > 10.) {
+			TopoDS_Shape result = entity_shape;
 
-						TopTools_ListOfShape opening_list;
-						for (auto kt = jt; kt < it; ++kt) {
-							opening_list.Append(kt->second);
-						}
+			auto it = part_openings.begin();
+			auto jt = it;
 
-						TopoDS_Shape intermediate_result;
-						if (util::boolean_operation(bst, result, opening_list, BOPAlgo_CUT, intermediate_result)) {
-							result = intermediate_result;
-						} else {
-							Logger::Message(Logger::LOG_ERROR, "Opening subtraction failed for " + boost::lexical_cast<std::string>(std::distance(jt, it)) + " openings", entity);
-						}
+			for (;; ++it) {
+				if (it == part_openings.end() || jt->first / it->first > 10.) {
 
-						jt = it;
+					TopTools_ListOfShape opening_list;
+					for (auto kt = jt; kt < it; ++kt) {
+						opening_list.Append(kt->second);
 					}
 
-					if (it == opening_vector.end()) {
-						break;
+					TopoDS_Shape intermediate_result;
+					if (util::boolean_operation(bst, result, opening_list, BOPAlgo_CUT, intermediate_result)) {
+						result = intermediate_result;
+					} else {
+						Logger::Message(Logger::LOG_ERROR, "Opening subtraction failed for " + boost::lexical_cast<std::string>(std::distance(jt, it)) + " openings", entity);
 					}
+
+					jt = it;
 				}
 
-				int result_n_faces = util::count(result, TopAbs_FACE);
+				if (it == part_openings.end()) {
+					break;
+				}
+			}
 
-				if (!is_manifold && as_shell == 0 && result_n_faces == 0) {
-					// If we have a non-manifold first operand and our first attempt
-					// on a Solid-Solid subtraction yielded a empty result (no faces)
-					// or a strange result, a larger number of faces with the original input
-					// included. Then retry (another iteration on the for-loop on as-shell)
-					// where we keep the first operand as is (a compound of faces probably,
-					// unless --orient-shells was activated in which case we're already lost).
-					if (!is_manifold) {
-						Logger::Warning("Retrying boolean operation on individual faces");
-					}
-					continue;
+			int result_n_faces = util::count(result, TopAbs_FACE);
+
+			if (!is_manifold && as_shell == 0 && result_n_faces == 0) {
+				// If we have a non-manifold first operand and our first attempt
+				// on a Solid-Solid subtraction yielded a empty result (no faces)
+				// or a strange result, a larger number of faces with the original input
+				// included. Then retry (another iteration on the for-loop on as-shell)
+				// where we keep the first operand as is (a compound of faces probably,
+				// unless --orient-shells was activated in which case we're already lost).
+				if (!is_manifold) {
+					Logger::Warning("Retrying boolean operation on individual faces");
 				}
+				continue;
+			}
+
+			entity_part_result = result;
+
+			// For manifold first operands we're not even going to try if processing
+			// as loose faces gives a better result.
+			break;
+		}
+
+		return entity_part_result;
+	};
+
+	// The solids of the shapes of the IfcProduct, which are cut independently
+	struct host_part {
+		size_t shape_index;
+		TopoDS_Shape part;
+		TopoDS_Shape result;
+	};
+	std::vector<host_part> host_parts;
+	std::vector<bool> is_multiple(entity_shapes.size(), false);
+	std::vector<bool> is_null(entity_shapes.size(), false);
+
+	for (size_t i = 0; i < entity_shapes.size(); ++i) {
+		auto it3_shape = std::static_pointer_cast<OpenCascadeShape>(entity_shapes[i].Shape())->shape();
+		if (it3_shape.IsNull()) {
+			Logger::Error("Null operand");
+			is_null[i] = true;
+			continue;
+		}
 
-				entity_part_result = result;
+		is_multiple[i] = it3_shape.ShapeType() == TopAbs_COMPOUND && TopoDS_Iterator(it3_shape).More() && util::is_nested_compound_of_solid(it3_shape);
 
-				// For manifold first operands we're not even going to try if processing
-				// as loose faces gives a better result.
-				break;
+		if (is_multiple[i]) {
+			TopoDS_Iterator sit(it3_shape);
+			for (; sit.More(); sit.Next()) {
+				host_parts.push_back({ i, sit.Value(), TopoDS_Shape() });
 			}
+		} else {
+			host_parts.push_back({ i, it3_shape, TopoDS_Shape() });
+		}
+	}
 
-			if (is_multiple) {
-				B.Add(C, entity_part_result);
-			} else {
-				combined_result = entity_part_result;
+	// Splits a solid placed by m with many openings between its openings into as
+	// many pieces as there are threads available, cuts the pieces in parallel and
+	// fuses the results. Returns false when the solid is not split.
+	auto subtract_openings_in_pieces = [&](const TopoDS_Shape& entity_part, const Eigen::Matrix4d& m, TopoDS_Shape& result) {
+		static const unsigned max_pieces = 8;
+
+		if (!util::is_manifold(entity_part)) {
+			return false;
+		}
+
+		// The threads are only reserved by ThreadBudget::for_each(), this only tells whether any are idle
+		const unsigned num_threads = IfcGeom::ThreadBudget::acquire(max_pieces - 1);
+		IfcGeom::ThreadBudget::release(num_threads);
+		if (num_threads == 0) {
+			return false;
+		}
+
+		gp_Trsf trsf;
+		trsf.SetValues(
+			m(0, 0), m(0, 1), m(0, 2), m(0, 3),
+			m(1, 0), m(1, 1), m(1, 2), m(1, 3),
+			m(2, 0), m(2, 1), m(2, 2), m(2, 3)
+		);
+		TopoDS_Shape entity_shape = util::apply_transformation(entity_part, trsf);
+
+		Bnd_Box b;
+		BRepBndLib::Add(entity_shape, b);
+		if (b.IsVoid()) {
+			return false;
+		}
+		b.Enlarge(bst.precision);
+		std::vector<Bnd_Box> opening_boxes;
+		for (auto& i : opening_tree.select_box(b)) {
+			opening_boxes.emplace_back();
+			BRepBndLib::Add(opening_vector[i].second, opening_boxes.back());
+		}
+		if (opening_boxes.size() < 2) {
+			return false;
+		}
+
+		TopTools_ListOfShape pieces;
+		if (!util::split_between_boxes(entity_shape, opening_boxes, num_threads + 1, bst.precision, pieces)) {
+			return false;
+		}
+
+		std::vector<TopoDS_Shape> pieces_vector(pieces.begin(), pieces.end());
+		std::vector<TopoDS_Shape> piece_results(pieces_vector.size());
+		IfcGeom::ThreadBudget::for_each(pieces_vector.size(), [&](size_t i) {
+			piece_results[i] = subtract_openings(pieces_vector[i], Eigen::Matrix4d::Identity());
+		});
+
+		TopTools_ListOfShape results;
+		for (auto& r : piece_results) {
+			if (r.IsNull()) {
+				return false;
+			}
+			results.Append(r);
+		}
+		if (!util::fuse_adjacent(results, bst.precision, result)) {
+			Logger::Message(Logger::LOG_WARNING, "Failed to fuse the pieces of a solid cut on multiple threads", entity);
+			return false;
+		}
+		return true;
+	};
+
+	// Elements of many solids are cut per solid in parallel, the solids of other
+	// elements are split between their openings to be cut in parallel
+	const int parallel_opening_subtraction = settings_.get<settings::ParallelOpeningSubtraction>().get();
+	if (parallel_opening_subtraction > 0 && (int) host_parts.size() >= (std::max)(parallel_opening_subtraction, 2)) {
+		IfcGeom::ThreadBudget::for_each(host_parts.size(), [&](size_t i) {
+			auto& hp = host_parts[i];
+			hp.result = subtract_openings(hp.part, entity_shapes[hp.shape_index].Placement()->ccomponents());
+		});
+	} else {
+		for (auto& hp : host_parts) {
+			const Eigen::Matrix4d& m = entity_shapes[hp.shape_index].Placement()->ccomponents();
+			if (parallel_opening_subtraction <= 0 || !subtract_openings_in_pieces(hp.part, m, hp.result)) {
+				hp.result = subtract_openings(hp.part, m);
 			}
+		}
+	}
 
+	// Iterate over the shapes of the IfcProduct
+	auto hp = host_parts.begin();
+	for (size_t i = 0; i < entity_shapes.size(); ++i) {
+		if (is_null[i]) {
+			continue;
 		}
 
-		if (is_multiple) {
+		TopoDS_Shape combined_result;
+
+		if (is_multiple[i]) {
+			TopoDS_Compound C;
+			BRep_Builder B;
+			B.MakeCompound(C);
+			for (; hp != host_parts.end() && hp->shape_index == i; ++hp) {
+				B.Add(C, hp->result);
+			}
 			combined_result = C;
+		} else {
+			combined_result = (hp++)->result;
 		}
 
-		cut_shapes.push_back(IfcGeom::ConversionResult(it3->ItemId(), new OpenCascadeShape(combined_result), it3->StylePtr()));
+		cut_shapes.push_back(IfcGeom::ConversionResult(entity_shapes[i].ItemId(), new OpenCascadeShape(combined_result), entity_shapes[i].StylePtr()));
 	}
 	return true;
 }
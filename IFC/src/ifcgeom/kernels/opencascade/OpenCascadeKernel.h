@@ -109,6 +109,14 @@ public:
 	bool convert(const ifcopenshell::geometry::taxonomy::matrix4::ptr, gp_GTrsf&);
 	bool convert(const ifcopenshell::geometry::taxonomy::shell::ptr, TopoDS_Shape&);
 	bool convert(const ifcopenshell::geometry::taxonomy::solid::ptr, TopoDS_Shape&);
+
+	// Converts the planar faces of a faceted shell into triangulated polygons without
+	// a boundary representation. Returns false when the shell needs to be converted
+	// regularly, for example because faces are not planar or intersect themselves.
+	bool convert(const ifcopenshell::geometry::taxonomy::shell::ptr, ifcopenshell::geometry::polygonal_faces&);
+	// Whether shells are to be converted into polygonal faces
+	bool convert_to_polygonal_faces() const;
+
 	bool convert(const ifcopenshell::geometry::taxonomy::loft::ptr, TopoDS_Shape&);
 	bool convert(const ifcopenshell::geometry::taxonomy::bspline_surface::ptr bs, Handle(Geom_Surface) surf);
 	bool convert(const ifcopenshell::geometry::taxonomy::sweep_along_curve::ptr, TopoDS_Shape&);
@@ -56,6 +56,14 @@ namespace {
 		}
 	}
 
+	// Sets a flag for the lifetime of the scope and restores its previous value
+	struct flag_scope {
+		bool& flag;
+		bool previous;
+		flag_scope(bool& f, bool value) : flag(f), previous(f) { flag = value; }
+		~flag_scope() { flag = previous; }
+	};
+
 	bool get_single_child(const TopoDS_Shape& s, TopoDS_Shape& child) {
 		TopoDS_Iterator it(s);
 		if (!it.More()) {
@@ -93,6 +101,9 @@ bool OpenCascadeKernel::convert_impl(const taxonomy::boolean_result::ptr br, Con
 
 	taxonomy::style::ptr first_item_style;
 
+	// Operands need a boundary representation for the boolean operation
+	flag_scope operands_not_triangulated(triangulated_output_only, false);
+
 	for (auto& c : br->children) {
 		IfcGeom::ConversionResults cr;
 		AbstractKernel::convert(c, cr);
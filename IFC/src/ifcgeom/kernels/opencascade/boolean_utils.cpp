@@ -3,6 +3,8 @@
 #include "IfcGeomTree.h"
 #include "base_utils.h"
 
+#include "../../../ifcgeom/Profiler.h"
+
 #include <BRepBuilderAPI_Copy.hxx>
 #include <TopExp_Explorer.hxx>
 #include <GProp_GProps.hxx>
@@ -19,6 +21,8 @@
 #include <BRepBuilderAPI_MakeFace.hxx>
 #include <Standard_Version.hxx>
 #include <BRepAlgoAPI_Fuse.hxx>
+#include <BRepAlgoAPI_Common.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
 #include <BRepPrimAPI_MakePrism.hxx>
 #include <BOPAlgo_PaveFiller.hxx>
 #include <BOPAlgo_Alerts.hxx>
@@ -29,6 +33,10 @@
 #include <ShapeAnalysis_Edge.hxx>
 #include <Bnd_OBB.hxx>
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <tuple>
 #include <vector>
 #include <thread>
 
@@ -589,7 +597,114 @@ TopoDS_Shape IfcGeom::util::unify(const TopoDS_Shape & s, double tolerance) {
 	return usd.Shape();
 }
 
-bool IfcGeom::util::boolean_subtraction_2d_using_builder(const TopoDS_Shape & a_input, const TopTools_ListOfShape & b_input, TopoDS_Shape & result, double eps) {
+bool IfcGeom::util::split_between_boxes(const TopoDS_Shape& a, const std::vector<Bnd_Box>& boxes, size_t max_parts, double eps, TopTools_ListOfShape& parts) {
+	Bnd_Box A;
+	BRepBndLib::Add(a, A);
+	if (A.IsVoid() || max_parts < 2) {
+		return false;
+	}
+
+	double a_min[3], a_max[3];
+	A.Get(a_min[0], a_min[1], a_min[2], a_max[0], a_max[1], a_max[2]);
+	int axis = 0;
+	for (int i = 1; i < 3; ++i) {
+		if (a_max[i] - a_min[i] > a_max[axis] - a_min[axis]) {
+			axis = i;
+		}
+	}
+
+	// The intervals of the boxes along the axis, in order of their start
+	std::vector<std::pair<double, double>> intervals;
+	for (auto& b : boxes) {
+		if (b.IsVoid()) {
+			continue;
+		}
+		double b_min[3], b_max[3];
+		b.Get(b_min[0], b_min[1], b_min[2], b_max[0], b_max[1], b_max[2]);
+		intervals.push_back({ b_min[axis] - eps, b_max[axis] + eps });
+	}
+	std::sort(intervals.begin(), intervals.end());
+
+	// Splits in the gaps between the intervals, where the number of intervals before
+	// the gap reaches the next multiple of the number of intervals per part
+	std::vector<double> splits;
+	double end = -std::numeric_limits<double>::infinity();
+	for (size_t i = 0; i < intervals.size() && splits.size() + 1 < max_parts; ++i) {
+		end = (std::max)(end, intervals[i].second);
+		if (i + 1 == intervals.size()) {
+			break;
+		}
+		const double next = intervals[i + 1].first;
+		const double split = (end + next) / 2.;
+		if (next > end && split > a_min[axis] + eps && split < a_max[axis] - eps && (i + 1) * max_parts >= (splits.size() + 1) * intervals.size()) {
+			splits.push_back(split);
+		}
+	}
+	if (splits.empty()) {
+		return false;
+	}
+
+	// Every part is the common of operand a with a box beyond its bounding box, except along the axis
+	splits.insert(splits.begin(), a_min[axis] - 1.);
+	splits.push_back(a_max[axis] + 1.);
+	TopTools_ListOfShape split_parts;
+	for (size_t i = 0; i + 1 < splits.size(); ++i) {
+		gp_XYZ p0(a_min[0] - 1., a_min[1] - 1., a_min[2] - 1.);
+		gp_XYZ p1(a_max[0] + 1., a_max[1] + 1., a_max[2] + 1.);
+		p0.SetCoord(axis + 1, splits[i]);
+		p1.SetCoord(axis + 1, splits[i + 1]);
+
+		TopTools_ListOfShape arguments, tools;
+		arguments.Append(a);
+		tools.Append(BRepPrimAPI_MakeBox(gp_Pnt(p0), gp_Pnt(p1)).Shape());
+
+		BRepAlgoAPI_Common common;
+#if OCC_VERSION_HEX >= 0x70000
+		common.SetNonDestructive(true);
+#endif
+		common.SetArguments(arguments);
+		common.SetTools(tools);
+		common.Build();
+		if (!common.IsDone() || count(common.Shape(), TopAbs_SOLID) == 0) {
+			return false;
+		}
+		split_parts.Append(common.Shape());
+	}
+
+	parts.Append(split_parts);
+	return true;
+}
+
+bool IfcGeom::util::fuse_adjacent(const TopTools_ListOfShape& shapes, double fuzziness, TopoDS_Shape& result) {
+	if (shapes.Extent() < 2) {
+		if (shapes.Extent()) {
+			result = shapes.First();
+		}
+		return shapes.Extent() == 1;
+	}
+
+	TopTools_ListOfShape first, rest = shapes;
+	first.Append(rest.First());
+	rest.RemoveFirst();
+
+	BRepAlgoAPI_Fuse fuse;
+#if OCC_VERSION_HEX >= 0x70000
+	fuse.SetNonDestructive(true);
+#endif
+	fuse.SetFuzzyValue(fuzziness);
+	fuse.SetArguments(first);
+	fuse.SetTools(rest);
+	fuse.Build();
+	if (!fuse.IsDone()) {
+		return false;
+	}
+
+	// Removes the faces between the shapes
+	result = unify(fuse.Shape(), fuzziness * 1000.);
+	return true;
+}
+
+bool IfcGeom::util::boolean_subtraction_2d_using_builder(const TopoDS_Shape & a_input, const TopTools_ListOfShape & b_input, TopoDS_Shape & result, double eps, const gp_Dir& direction) {
 	IfcGeom::impl::tree<int> edge_tree;
 
 	TopTools_ListOfShape ab_input = b_input;
@@ -691,11 +806,10 @@ bool IfcGeom::util::boolean_subtraction_2d_using_builder(const TopoDS_Shape & a_
 						ecc.Points(i, p1, p2);
 
 						// #3616 Only take into account orthogonal distance between closest points on curve
-						// to see whether inside tolerance. Current DY is hardcoded. The sensible default
-						// for walls.
+						// to see whether inside tolerance, orthogonal to the extrusion direction.
 						gp_Vec vec(p1, p2);
-						Standard_Real d = vec.Dot(gp::DY());
-						gp_Vec projected = d * gp::DY();
+						Standard_Real d = vec.Dot(direction);
+						gp_Vec projected = d * gp_Vec(direction);
 						gp_Vec ortho_remainder = vec - projected;
 						Standard_Real ortho_distance = ortho_remainder.Magnitude();
 
@@ -1051,21 +1165,25 @@ bool IfcGeom::util::boolean_operation(const boolean_settings& settings, const To
 	}
 
 	if (op == BOPAlgo_CUT) {
-		TopoDS_Face a_face;
-		std::pair<double, double> a_interval;
-
-		TopTools_ListOfShape b_faces, b_remainder_3d;
-
-		bool is_extrusion_a = false;
-		if (do_attempt_2d_boolean) {
-			PERF("boolean subtraction: extrusion check");
-
-			is_extrusion_a = is_extrusion(gp::DY(), a, a_face, a_interval);
-		}
-
-		if (is_extrusion_a) {
-			Logger::Notice("Operand A 1/1 is an extrusion");
-
+		// The operands B classified against operand A as an extrusion along a direction
+		struct extrusion_operands {
+			gp_Dir direction;
+			TopoDS_Face a_face;
+			std::pair<double, double> a_interval;
+			// Faces of operands that cut through operand A, aligned with the base face of A
+			TopTools_ListOfShape b_faces;
+			// Faces of operands that only cut part of the depth of operand A, aligned with
+			// the base face of A, with their interval clamped to that of A, and the
+			// original operands to process in 3D in case the partial holes fail in 2D
+			std::vector<std::pair<TopoDS_Shape, std::pair<double, double>>> b_partial;
+			TopTools_ListOfShape b_partial_3d;
+			TopTools_ListOfShape b_remainder_3d;
+			size_t num_outside = 0;
+		};
+
+		const double interval_tolerance = fuzz * 100.;
+
+		auto classify = [&](extrusion_operands& ops) {
 			TopTools_ListIteratorOfListOfShape it(b);
 			for (int nb = 1; it.More(); it.Next(), ++nb) {
 				bool process_2d = false;
@@ -1076,69 +1194,290 @@ bool IfcGeom::util::boolean_operation(const boolean_settings& settings, const To
 				{
 					PERF("boolean subtraction: extrusion check");
 
-					is_extrusion_b = is_extrusion(gp::DY(), it.Value(), b_face, b_interval);
+					is_extrusion_b = is_extrusion(ops.direction, it.Value(), b_face, b_interval);
 				}
 
 				if (is_extrusion_b) {
 					Logger::Notice("Operand B " + std::to_string(nb) + "/" + std::to_string(b.Extent()) + " is an extrusion");
 
-					if (b_interval.first < a_interval.first + (fuzz * 100.) && b_interval.second > a_interval.second - (fuzz * 100.)) {
+					// Align b with a operand
+					gp_Trsf trsf;
+					trsf.SetTranslation(gp_Vec(ops.direction) * (ops.a_interval.first - b_interval.first));
+
+					if (b_interval.first < ops.a_interval.first + interval_tolerance && b_interval.second > ops.a_interval.second - interval_tolerance) {
 						Logger::Notice("Operand B creates a through hole");
 
-						// Align b with a operand
-						gp_Trsf trsf;
-						trsf.SetTranslation(gp_Vec(gp::DY()) * (a_interval.first - b_interval.first));
+						ops.b_faces.Append(b_face.Moved(trsf));
+						process_2d = true;
+					} else if (b_interval.second < ops.a_interval.first + interval_tolerance || b_interval.first > ops.a_interval.second - interval_tolerance) {
+						Logger::Notice("Operand B is outside of the extrusion interval of operand A");
 
-						b_faces.Append(b_face.Moved(trsf));
+						++ops.num_outside;
+						process_2d = true;
+					} else {
+						Logger::Notice("Operand B creates a partial hole");
+
+						ops.b_partial.push_back({ b_face.Moved(trsf), {
+							(std::max)(b_interval.first, ops.a_interval.first),
+							(std::min)(b_interval.second, ops.a_interval.second)
+						} });
+						ops.b_partial_3d.Append(it.Value());
 						process_2d = true;
 					}
 				}
 
 				if (!process_2d) {
-					b_remainder_3d.Append(it.Value());
+					ops.b_remainder_3d.Append(it.Value());
 				}
 			}
+		};
+
+		// Ranks the classification by the number of through holes, then by the
+		// number of operands left to 3D and the number of partial holes
+		auto rank = [](const extrusion_operands& ops) {
+			return std::make_tuple(ops.b_faces.Extent(), -ops.b_remainder_3d.Extent(), -(int) ops.b_partial.size());
+		};
+
+		// A box is an extrusion along all of its axes, for which a wall with
+		// horizontal openings is cut through along Y, but a slab with vertical
+		// openings along Z, with the openings as partial holes along Y. Therefore
+		// every direction along which operand A is an extrusion is tried and the
+		// one with the most through holes is used.
+		static const gp_Dir directions[] = { gp::DY(), gp::DZ(), gp::DX() };
+		std::unique_ptr<extrusion_operands> chosen;
 
-			if (b_faces.Extent()) {
-				TopoDS_Shape face_result;
+		if (do_attempt_2d_boolean) {
+			// Classifying the operands along a direction takes an extrusion check per
+			// operand. The bounding boxes bound the number of through holes along
+			// every direction, so that the directions are tried from the highest
+			// bound down and only while they can rank at least as high as the
+			// direction chosen so far.
+			auto project = [](const Bnd_Box& box, const gp_Dir& d) {
+				double xyz[2][3];
+				box.Get(xyz[0][0], xyz[0][1], xyz[0][2], xyz[1][0], xyz[1][1], xyz[1][2]);
+				std::pair<double, double> interval = { std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+				for (int i = 0; i < 8; ++i) {
+					const double dot = gp_XYZ(xyz[i & 1][0], xyz[(i >> 1) & 1][1], xyz[(i >> 2) & 1][2]).Dot(d.XYZ());
+					interval.first = (std::min)(interval.first, dot);
+					interval.second = (std::max)(interval.second, dot);
+				}
+				return interval;
+			};
+
+			Bnd_Box a_box;
+			BRepBndLib::Add(a, a_box);
+			std::vector<Bnd_Box> b_boxes;
+			for (TopTools_ListIteratorOfListOfShape it(b); it.More(); it.Next()) {
+				b_boxes.emplace_back();
+				BRepBndLib::Add(it.Value(), b_boxes.back());
+			}
+
+			std::vector<std::pair<int, size_t>> through_bounds;
+			for (size_t i = 0; i < sizeof(directions) / sizeof(directions[0]); ++i) {
+				int bound = 0;
+				if (!a_box.IsVoid()) {
+					const auto a_extent = project(a_box, directions[i]);
+					for (auto& box : b_boxes) {
+						if (!box.IsVoid()) {
+							const auto b_extent = project(box, directions[i]);
+							bound += b_extent.first < a_extent.first + interval_tolerance && b_extent.second > a_extent.second - interval_tolerance;
+						}
+					}
+				}
+				through_bounds.push_back({ bound, i });
+			}
+			std::stable_sort(through_bounds.begin(), through_bounds.end(), [](const std::pair<int, size_t>& x, const std::pair<int, size_t>& y) {
+				return x.first > y.first;
+			});
+
+			for (auto& bound : through_bounds) {
+				if (chosen && bound.first < chosen->b_faces.Extent()) {
+					break;
+				}
+
+				const gp_Dir& d = directions[bound.second];
+				std::unique_ptr<extrusion_operands> ops(new extrusion_operands);
+				ops->direction = d;
+
+				bool is_extrusion_a;
+				{
+					PERF("boolean subtraction: extrusion check");
+
+					is_extrusion_a = is_extrusion(d, a, ops->a_face, ops->a_interval);
+				}
+				if (!is_extrusion_a) {
+					continue;
+				}
+
+				classify(*ops);
+				if (!chosen || rank(*ops) > rank(*chosen)) {
+					chosen = std::move(ops);
+				}
+				if (chosen->b_partial.empty() && chosen->b_remainder_3d.Extent() == 0) {
+					// All operands cut through or are outside of operand A
+					break;
+				}
+			}
+		}
+
+		if (chosen) {
+			Logger::Notice("Operand A 1/1 is an extrusion");
+
+			const gp_Dir& direction = chosen->direction;
+			const TopoDS_Face& a_face = chosen->a_face;
+			const std::pair<double, double>& a_interval = chosen->a_interval;
+			const TopTools_ListOfShape& b_faces = chosen->b_faces;
+			const auto& b_partial = chosen->b_partial;
+			TopTools_ListOfShape& b_partial_3d = chosen->b_partial_3d;
+			TopTools_ListOfShape& b_remainder_3d = chosen->b_remainder_3d;
+			const size_t num_outside = chosen->num_outside;
+
+			// Subtracts faces from the base face of operand A
+			auto subtract_2d = [&](const TopTools_ListOfShape& faces, TopoDS_Shape& face_result) {
+				if (faces.Extent() == 0) {
+					face_result = a_face;
+					return true;
+				}
 
 				bool boolean_op_2d_success;
 				{
 					PERF("boolean operation: 2d builder");
 					// First try using face builder
 
-					boolean_op_2d_success = boolean_subtraction_2d_using_builder(a_face, b_faces, face_result, fuzziness);
+					boolean_op_2d_success = boolean_subtraction_2d_using_builder(a_face, faces, face_result, fuzziness, direction);
 				}
 
 				if (!boolean_op_2d_success) {
 					PERF("boolean operation: 2d");
 					// Retry using generic 2d using boolean algo on faces
 
-					boolean_op_2d_success = boolean_operation(settings, a_face, b_faces, op, face_result, fuzziness);
+					boolean_op_2d_success = boolean_operation(settings, a_face, faces, op, face_result, fuzziness);
 				}
 
-				if (boolean_op_2d_success) {
-					PERF("boolean operation: 2d to 3d");
+				return boolean_op_2d_success;
+			};
 
-					BRepPrimAPI_MakePrism mp(face_result, gp_Vec(gp::DY()) * (a_interval.second - a_interval.first));
-					if (mp.IsDone()) {
-						if (b_remainder_3d.Extent()) {
-							Logger::Notice(std::to_string(b_remainder_3d.Extent()) + " operands remaining to process in 3D");
-							b = b_remainder_3d;
-							s1s.Clear();
-							s1s.Append(mp.Shape());
-						} else {
-							Logger::Notice("Processed fully in 2D");
-							result = mp.Shape();
-							return true;
+			// Extrudes a face at the base of operand A over an interval along the direction
+			auto extrude = [&](const TopoDS_Shape& face, double z0, double z1, TopoDS_Shape& prism) {
+				PERF("boolean operation: 2d to 3d");
+
+				gp_Trsf trsf;
+				trsf.SetTranslation(gp_Vec(direction) * (z0 - a_interval.first));
+				BRepPrimAPI_MakePrism mp(face.Moved(trsf), gp_Vec(direction) * (z1 - z0));
+				if (!mp.IsDone()) {
+					return false;
+				}
+				prism = mp.Shape();
+				return true;
+			};
+
+			bool processed_2d = false;
+			TopoDS_Shape prism;
+
+			if (!b_partial.empty()) {
+				// Operand A is split into slabs at the bounds of the partial holes. Every
+				// slab is cut in 2D by the holes that span it and extruded, after which
+				// the slabs are fused.
+				std::vector<double> bounds = { a_interval.first, a_interval.second };
+				for (auto& p : b_partial) {
+					bounds.push_back(p.second.first);
+					bounds.push_back(p.second.second);
+				}
+				std::sort(bounds.begin(), bounds.end());
+				std::vector<double> slab_bounds;
+				for (auto& z : bounds) {
+					if (slab_bounds.empty() || z - slab_bounds.back() > interval_tolerance) {
+						slab_bounds.push_back(z);
+					}
+				}
+				slab_bounds.back() = a_interval.second;
+
+				// Adjacent slabs that are cut by the same holes are extruded at once
+				std::vector<std::pair<double, double>> slabs;
+				std::vector<std::vector<bool>> slab_holes;
+				for (size_t i = 0; i + 1 < slab_bounds.size(); ++i) {
+					const double z0 = slab_bounds[i], z1 = slab_bounds[i + 1];
+					std::vector<bool> holes;
+					for (auto& p : b_partial) {
+						holes.push_back(p.second.first < z0 + interval_tolerance && p.second.second > z1 - interval_tolerance);
+					}
+					if (!slab_holes.empty() && slab_holes.back() == holes) {
+						slabs.back().second = z1;
+					} else {
+						slabs.push_back({ z0, z1 });
+						slab_holes.push_back(holes);
+					}
+				}
+
+				// Every slab is cut and extruded separately and fused afterwards, which
+				// for many slabs is slower than a single boolean operation in 3D
+				static const size_t max_slabs = 8;
+
+				TopTools_ListOfShape slab_prisms;
+				bool slabs_success = slabs.size() <= max_slabs;
+				if (!slabs_success) {
+					Logger::Notice("Partial holes split operand A into " + std::to_string(slabs.size()) + " slabs");
+				}
+				for (size_t i = 0; i < slabs.size() && slabs_success; ++i) {
+					TopTools_ListOfShape faces = b_faces;
+					for (size_t j = 0; j < b_partial.size(); ++j) {
+						if (slab_holes[i][j]) {
+							faces.Append(b_partial[j].first);
 						}
+					}
+					TopoDS_Shape face_result, slab_prism;
+					slabs_success = subtract_2d(faces, face_result) && extrude(face_result, slabs[i].first, slabs[i].second, slab_prism);
+					if (slabs_success) {
+						slab_prisms.Append(slab_prism);
+					}
+				}
+
+				if (slabs_success && slab_prisms.Extent() == 1) {
+					prism = slab_prisms.First();
+					processed_2d = true;
+				} else if (slabs_success) {
+					PERF("boolean operation: 2d slab fusion");
+
+					processed_2d = fuse_adjacent(slab_prisms, fuzz, prism);
+				}
+
+				if (!processed_2d) {
+					Logger::Notice("Failed to process partial holes in 2D, processing them in 3D.");
+					b_remainder_3d.Append(b_partial_3d);
+				}
+			}
+
+			if (!processed_2d && b_faces.Extent()) {
+				TopoDS_Shape face_result;
+				if (subtract_2d(b_faces, face_result)) {
+					if (extrude(face_result, a_interval.first, a_interval.second, prism)) {
+						processed_2d = true;
 					} else {
 						Logger::Notice("Failed to extrude 2D boolean result. Retrying in 3D.");
 					}
 				} else {
 					Logger::Notice("Failed to perform 2D boolean operation. Retrying in 3D.");
 				}
-			} else {
+			}
+
+			if (processed_2d || (num_outside && b_remainder_3d.Extent() == 0 && b_faces.Extent() == 0)) {
+				if (!processed_2d) {
+					// All operands are outside of the extrusion interval
+					prism = a;
+				}
+				if (b_remainder_3d.Extent()) {
+					Logger::Notice(std::to_string(b_remainder_3d.Extent()) + " operands remaining to process in 3D");
+					IfcGeom::Profiler::count("boolean_2d_partial");
+					b = b_remainder_3d;
+					s1s.Clear();
+					s1s.Append(prism);
+				} else {
+					Logger::Notice("Processed fully in 2D");
+					IfcGeom::Profiler::count("boolean_2d");
+					result = prism;
+					return true;
+				}
+			} else if (!processed_2d && b_faces.Extent() == 0 && b_partial.empty()) {
 				Logger::Notice("No second operands can be processed as 2D inner bounds. Retrying in 3D.");
 			}
 		}
@@ -1155,6 +1494,9 @@ bool IfcGeom::util::boolean_operation(const boolean_settings& settings, const To
 	{
 		PERF("boolean operation: build");
 
+		if (!is_2d) {
+			IfcGeom::Profiler::count("boolean_3d");
+		}
 		builder->Build();
 	}
 	if (builder->IsDone()) {
@@ -29,6 +29,11 @@
 #include <BRepTools.hxx>
 #include <TopTools_IndexedMapOfShape.hxx>
 #include <BOPAlgo_Operation.hxx>
+#include <gp.hxx>
+#include <gp_Dir.hxx>
+#include <Bnd_Box.hxx>
+
+#include <vector>
 
 namespace IfcGeom {
 	namespace util {
@@ -85,7 +90,15 @@ namespace IfcGeom {
 
 		TopoDS_Shape unify(const TopoDS_Shape& s, double tolerance);
 
-		bool boolean_subtraction_2d_using_builder(const TopoDS_Shape& a_input, const TopTools_ListOfShape& b_input, TopoDS_Shape& result, double eps);
+		// Splits a along the longest axis of its bounding box into at most max_parts parts, at
+		// planes that do not intersect any of the boxes, with about as many boxes in every part
+		bool split_between_boxes(const TopoDS_Shape& a, const std::vector<Bnd_Box>& boxes, size_t max_parts, double eps, TopTools_ListOfShape& parts);
+
+		// Fuses shapes that only share faces, such as the parts of split_between_boxes(), into
+		// a single shape without the faces in between
+		bool fuse_adjacent(const TopTools_ListOfShape& shapes, double fuzziness, TopoDS_Shape& result);
+
+		bool boolean_subtraction_2d_using_builder(const TopoDS_Shape& a_input, const TopTools_ListOfShape& b_input, TopoDS_Shape& result, double eps, const gp_Dir& direction = gp::DY());
 
 		struct boolean_settings {
 			bool debug, attempt_2d;
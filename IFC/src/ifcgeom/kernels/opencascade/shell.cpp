@@ -2,6 +2,8 @@
 
 #include "base_utils.h"
 
+#include "../../polygon_triangulation.h"
+
 using namespace ifcopenshell::geometry;
 using namespace ifcopenshell::geometry::kernels;
 using namespace IfcGeom;
@@ -106,7 +108,158 @@ bool OpenCascadeKernel::convert(const taxonomy::shell::ptr l, TopoDS_Shape& shap
 	return true;
 }
 
+bool OpenCascadeKernel::convert_to_polygonal_faces() const {
+	// Reoriented shells are sewn into solids, which requires a boundary representation
+	return triangulated_output_only &&
+		settings_.get<settings::DirectPolygonTriangulation>().get() &&
+		!settings_.get<settings::ReorientShells>().get();
+}
+
+bool OpenCascadeKernel::convert(const taxonomy::shell::ptr l, polygonal_faces& result) {
+	if (!shell_polyhedral(l)) {
+		return false;
+	}
+
+	// Consecutive points closer than eps are merged, similar to the tolerance
+	// used for faceted shells by the faceset_helper
+	const double eps = precision_ * 10.;
+	const double min_face_area = eps * eps / 20.;
+
+	// Warnings are only emitted when the shell is not converted regularly instead
+	std::vector<const IfcUtil::IfcBaseInterface*> degenerate_faces;
+
+	for (auto& face : l->children) {
+		if (face->basis) {
+			return false;
+		}
+
+		const int num_bounds = face->children.size();
+		int num_outer_bounds = 0;
+		for (auto& bound : face->children) {
+			if (bound->external.get_value_or(false)) {
+				num_outer_bounds++;
+			}
+		}
+
+		if (num_bounds > 1 && num_outer_bounds > 1 && num_bounds != num_outer_bounds) {
+			return false;
+		}
+
+		// The exterior face boundary comes first, as in the regular face conversion
+		std::vector<std::vector<Eigen::Vector3d>> boundaries;
+		for (int process_interior = 0; process_interior <= 1; ++process_interior) {
+			for (auto& bound : face->children) {
+				const bool is_interior =
+					!bound->external.get_value_or(false) &&
+					(num_bounds > 1) &&
+					(num_outer_bounds < num_bounds);
+
+				if (is_interior == !process_interior) continue;
+
+				std::vector<Eigen::Vector3d> points;
+				for (auto& e : bound->children) {
+					const auto& p = boost::get<taxonomy::point3::ptr>(e->orientation.get_value_or(true) ? e->start : e->end)->ccomponents();
+					if (points.empty() || (p - points.back()).norm() > eps) {
+						points.push_back(p);
+					}
+				}
+				while (points.size() > 1 && (points.back() - points.front()).norm() <= eps) {
+					points.pop_back();
+				}
+				boundaries.emplace_back(std::move(points));
+			}
+		}
+
+		// Multiple outer bounds are processed as separate faces
+		std::vector<std::vector<size_t>> groups;
+		if (num_outer_bounds > 1) {
+			for (size_t i = 0; i < boundaries.size(); ++i) {
+				groups.push_back({ i });
+			}
+		} else {
+			groups.emplace_back();
+			for (size_t i = 0; i < boundaries.size(); ++i) {
+				groups.back().push_back(i);
+			}
+		}
+
+		for (auto& group : groups) {
+			if (group.empty()) {
+				return false;
+			}
+			if (group.size() == 1 && boundaries[group.front()].size() < 3) {
+				degenerate_faces.push_back(face->instance);
+				continue;
+			}
+
+			polygonal_faces::face f;
+			for (size_t i : group) {
+				if (boundaries[i].size() < 3) {
+					return false;
+				}
+				f.loops.emplace_back();
+				for (auto& p : boundaries[i]) {
+					f.loops.back().push_back((int) (f.xyz.size() / 3));
+					f.xyz.insert(f.xyz.end(), p.data(), p.data() + 3);
+				}
+			}
+
+			Eigen::Vector3d normal = IfcGeom::util::polygon_normal(f.xyz, f.loops.front());
+			if (normal.norm() / 2. <= min_face_area) {
+				degenerate_faces.push_back(face->instance);
+				continue;
+			}
+			normal.normalize();
+
+			// Faces that are not planar are converted regularly, so that they are
+			// triangulated the same as they would be otherwise
+			Eigen::Vector3d center = Eigen::Vector3d::Zero();
+			for (auto& p : boundaries[group.front()]) {
+				center += p;
+			}
+			center /= (double) boundaries[group.front()].size();
+			for (size_t i : group) {
+				for (auto& p : boundaries[i]) {
+					if (std::fabs((p - center).dot(normal)) > precision_) {
+						return false;
+					}
+				}
+			}
+
+			if (!IfcGeom::util::triangulate_polygon(f.xyz, f.loops, normal, f.triangles)) {
+				return false;
+			}
+
+			f.normal = normal;
+			result.faces.emplace_back(std::move(f));
+		}
+	}
+
+	if (result.faces.empty()) {
+		return false;
+	}
+
+	for (auto& instance : degenerate_faces) {
+		Logger::Message(Logger::LOG_WARNING, "Degenerate face:", instance);
+	}
+
+	return true;
+}
+
 bool OpenCascadeKernel::convert_impl(const taxonomy::shell::ptr shell, IfcGeom::ConversionResults& results) {
+	if (convert_to_polygonal_faces()) {
+		auto faces = std::make_shared<polygonal_faces>();
+		if (convert(shell, *faces)) {
+			results.emplace_back(ConversionResult(
+				shell->instance->as<IfcUtil::IfcBaseEntity>()->id(),
+				shell->matrix,
+				new OpenCascadeShape(std::shared_ptr<const polygonal_faces>(faces)),
+				shell->surface_style
+			));
+			return true;
+		}
+	}
+
 	TopoDS_Shape shape;
 	if (!convert(shell, shape)) {
 		return false;
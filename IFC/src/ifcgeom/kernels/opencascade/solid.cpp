@@ -102,6 +102,21 @@ bool OpenCascadeKernel::convert(const taxonomy::solid::ptr solid, TopoDS_Shape&
 }
 
 bool OpenCascadeKernel::convert_impl(const taxonomy::solid::ptr solid, IfcGeom::ConversionResults& results) {
+	// A single faceted shell that is not reoriented is converted into a compound of
+	// faces, which is equivalent to its polygonal faces
+	if (convert_to_polygonal_faces() && solid->children.size() == 1 && !solid->instance->declaration().is("IfcHalfSpaceSolid")) {
+		auto faces = std::make_shared<polygonal_faces>();
+		if (convert(solid->children[0], *faces)) {
+			results.emplace_back(ConversionResult(
+				solid->instance->as<IfcUtil::IfcBaseEntity>()->id(),
+				solid->matrix,
+				new OpenCascadeShape(std::shared_ptr<const polygonal_faces>(faces)),
+				solid->surface_style
+			));
+			return true;
+		}
+	}
+
 	TopoDS_Shape shape;
 	if (!convert(solid, shape)) {
 		return false;
@@ -22,5 +22,11 @@
 using namespace ifcopenshell::geometry;
 
 taxonomy::ptr mapping::map_impl(const IfcSchema::IfcCsgSolid* inst) {
-	return map(inst->TreeRootExpression());
+	auto root = map(inst->TreeRootExpression());
+	if (!root) {
+		return nullptr;
+	}
+	// The mapped root expression is shared through the mapping cache and the style
+	// of the solid is set on the item returned, so a copy is returned
+	return taxonomy::ptr(root->clone_());
 }
@@ -26,7 +26,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcDerivedProfileDef* inst) {
 	if (it == nullptr) {
 		return nullptr;
 	}
-	// @todo we mutate it so we need to clone otherwise we alter the cached item.
+	// The cached item is shared, so it is cloned before its matrix is set.
 	it = taxonomy::item::ptr(it->clone_());
 
 	taxonomy::matrix4::ptr m;
@@ -45,10 +45,12 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcDerivedProfileDef* inst) {
 			return nullptr;
 		}
 	}
-	if (!taxonomy::cast<taxonomy::geom_item>(it)->matrix) {
-		// @todo should this not be initialized by default? matrix4 already has a 'lazy identity' mechanism.
-		taxonomy::cast<taxonomy::geom_item>(it)->matrix = taxonomy::make<taxonomy::matrix4>();
+	auto git = taxonomy::cast<taxonomy::geom_item>(it);
+	// The clone shares the matrix of the cached item, so a new matrix is assigned.
+	if (git->matrix) {
+		git->matrix = taxonomy::make<taxonomy::matrix4>(Eigen::Matrix4d(git->matrix->ccomponents() * m->ccomponents()));
+	} else {
+		git->matrix = m;
 	}
-	taxonomy::cast<taxonomy::geom_item>(it)->matrix->components() *= m->ccomponents();
 	return it;
 }
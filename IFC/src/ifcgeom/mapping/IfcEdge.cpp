@@ -43,8 +43,13 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcEdge* inst) {
 		auto basis = map(inst->as<IfcSchema::IfcEdgeCurve>()->EdgeGeometry());
 		auto loop = taxonomy::dcast<taxonomy::loop>(basis);
 		if (loop && loop->children.size() == 1) {
-			loop->calculate_linear_edge_curves();
-			basis = loop->children[0]->basis;
+			// The mapped loop is shared through the mapping cache, so a copy is modified
+			auto copy = taxonomy::loop::ptr(loop->clone_());
+			for (auto& c : copy->children) {
+				c = taxonomy::edge::ptr(c->clone_());
+			}
+			copy->calculate_linear_edge_curves();
+			basis = copy->children[0]->basis;
 		}
 		e->basis = basis;
 		e->curve_sense = inst->as<IfcSchema::IfcEdgeCurve>()->SameSense();
@@ -38,13 +38,14 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcEllipse* inst) {
 	// ellipse is rotated. Note that special care is taken
 	// when creating a trimmed curve off of an ellipse like this.
 	if (y > x) {
-		// @todo is a copy necesary here or can this be done in place?
+		// The cached placement is shared, so a copy is rotated
 		auto m4_copy = *el->matrix;
+		el->matrix = taxonomy::matrix4::ptr(el->matrix->clone_());
 		el->matrix->components() <<
-			m4_copy.components().col(1),
-			-m4_copy.components().col(0),
-			m4_copy.components().col(2),
-			m4_copy.components().col(3);
+			m4_copy.ccomponents().col(1),
+			-m4_copy.ccomponents().col(0),
+			m4_copy.ccomponents().col(2),
+			m4_copy.ccomponents().col(3);
 		std::swap(x, y);
 	}
 
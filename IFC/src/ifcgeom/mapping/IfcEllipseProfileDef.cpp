@@ -45,13 +45,14 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcEllipseProfileDef* inst) {
 	}
 
 	if (ry > rx) {
-		// @todo is a copy necesary here or can this be done in place?
+		// The cached placement is shared, so a copy is rotated
 		auto m4_copy = *m4;
+		m4 = taxonomy::matrix4::ptr(m4->clone_());
 		m4->components() <<
-			m4_copy.components().col(1),
-			-m4_copy.components().col(0),
-			m4_copy.components().col(2),
-			m4_copy.components().col(3);
+			m4_copy.ccomponents().col(1),
+			-m4_copy.ccomponents().col(0),
+			m4_copy.ccomponents().col(2),
+			m4_copy.ccomponents().col(3);
 		std::swap(rx, ry);
 	}
 
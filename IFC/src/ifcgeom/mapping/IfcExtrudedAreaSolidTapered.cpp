@@ -35,19 +35,21 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcExtrudedAreaSolidTapered* in
 	Eigen::Affine3d af3d(Eigen::Translation3d(height * dir->ccomponents()));
 	Eigen::Matrix4d end_profile = af3d.matrix();
 
+	// The end profile is placed at the end of the extrusion, the cached item is shared so it is cloned first.
+	auto end_face = taxonomy::face::ptr(taxonomy::cast<taxonomy::face>(map(inst->EndSweptArea()))->clone_());
+	if (end_face->matrix) {
+		end_face->matrix = taxonomy::make<taxonomy::matrix4>(Eigen::Matrix4d(end_face->matrix->ccomponents() * end_profile));
+	} else {
+		end_face->matrix = taxonomy::make<taxonomy::matrix4>(end_profile);
+	}
+
 	auto loft = taxonomy::make<taxonomy::loft>();
 	loft->axis = nullptr;
 	loft->children = {
 		taxonomy::cast<taxonomy::face>(map(inst->SweptArea())),
-		taxonomy::cast<taxonomy::face>(map(inst->EndSweptArea()))
+		end_face
 	};
 
-	if (!loft->children.back()->matrix) {
-		loft->children.back()->matrix = taxonomy::make<taxonomy::matrix4>();
-	}
-	auto old = loft->children.back()->matrix->ccomponents();
-	loft->children.back()->matrix->components() = old * end_profile;
-
 	taxonomy::matrix4::ptr matrix;
 	bool has_position = true;
 #ifdef SCHEMA_IfcSweptAreaSolid_Position_IS_OPTIONAL
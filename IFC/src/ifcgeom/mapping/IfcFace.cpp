@@ -26,18 +26,16 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcFace* inst) {
 	auto bounds = inst->Bounds();
 	for (auto& bound : *bounds) {
 		if (auto r = taxonomy::cast<taxonomy::loop>(map(bound->Bound()))) {
-			if (!bound->Orientation()) {
-				r->reverse();
-			}
 			// @todo check why loop sets external to true initially
-			r->external = bound->declaration().is(IfcSchema::IfcFaceOuterBound::Class());
-			/*
-			// Make a copy in case we need immutability later for e.g. caching
-			auto s = r->clone();
-			((taxonomy::loop*)s)->external = true;
-			delete r;
-			r = s;
-			*/
+			const bool external = bound->declaration().is(IfcSchema::IfcFaceOuterBound::Class());
+			// The cached loop is shared, so it is only modified on a copy
+			if (!bound->Orientation() || r->external != external) {
+				r = taxonomy::loop::ptr(r->clone_());
+				if (!bound->Orientation()) {
+					r->reverse();
+				}
+				r->external = external;
+			}
 			face->children.push_back(r);
 		}
 	}
@@ -84,7 +84,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcFixedReferenceSweptAreaSolid
 				m4b.col(3).head<3>() = pos;
 			} else {
 				Eigen::Vector3d tangent = m4.col(0).head<3>().normalized();
-				Eigen::Vector3d proj = (ref->components() - tangent * tangent.dot(ref->components()));
+				Eigen::Vector3d proj = (ref->ccomponents() - tangent * tangent.dot(ref->ccomponents()));
 				proj.normalize();
 				auto ref = proj.cross(tangent);
 
@@ -25,6 +25,12 @@
 #include "../../ifcparse/IfcLogger.h"
 #include "../../ifcparse/IfcFile.h"
 #include "../../ifcparse/IfcSIPrefix.h"
+#include "../../ifcgeom/Profiler.h"
+#include "../../ifcgeom/ThreadBudget.h"
+
+#include <exception>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace IfcUtil;
 using namespace ifcopenshell::geometry;
@@ -224,21 +230,88 @@ void mapping::get_representations(std::vector<geometry_conversion_task>& tasks,
         addRepresentationsFromContextIds(representations);
     }
 
-    IfcSchema::IfcRepresentation::list::ptr ok_mapped_representations(new IfcSchema::IfcRepresentation::list);
+    // The products of a representation and whether they can share its geometry are determined independently
+    // for every representation, in parallel. The tasks are created afterwards in the order of the
+    // representations, so that they do not depend on the number of threads.
+    struct representation_analysis {
+        IfcSchema::IfcRepresentationMap* rmap = nullptr;
+        IfcSchema::IfcProduct::list::ptr products;
+        bool reuse_ok = false;
+        IfcSchema::IfcRepresentation* mapped_to = nullptr;
+        // Rethrown when the tasks are created, at the position where it would have occurred sequentially
+        std::exception_ptr error;
+    };
+
+    std::vector<IfcSchema::IfcRepresentation*> reps(representations->begin(), representations->end());
+    std::vector<representation_analysis> analyses(reps.size());
+
+    auto analyze = [this, &filters](IfcSchema::IfcRepresentation* representation, representation_analysis& analysis) {
+        analysis = representation_analysis();
+        try {
+            analysis.products = filter_products(products_represented_by(representation, analysis.rmap, false), filters);
+            analysis.reuse_ok = analysis.products->size() && reuse_ok_(analysis.products);
+            analysis.mapped_to = analysis.products->size() ? representation_mapped_to(representation) : nullptr;
+        } catch (...) {
+            analysis.error = std::current_exception();
+        }
+    };
+
+    IfcGeom::ThreadBudget::for_each(reps.size(), [&](size_t i) {
+        analyze(reps[i], analyses[i]);
+    }, num_threads_);
+
+    // Whether geometry can be reused for all products of the representations that others are mapped to. Only
+    // needed for representations that can reuse their geometry themselves.
+    struct mapped_analysis {
+        IfcSchema::IfcRepresentationMap* rmap = nullptr;
+        bool reuse_ok = false;
+        std::exception_ptr error;
+    };
+
+    std::vector<IfcSchema::IfcRepresentation*> mapped_reps;
+    std::unordered_map<const IfcSchema::IfcRepresentation*, mapped_analysis> mapped_analyses;
+    for (auto& analysis : analyses) {
+        if (analysis.reuse_ok && analysis.mapped_to && mapped_analyses.emplace(analysis.mapped_to, mapped_analysis{}).second) {
+            mapped_reps.push_back(analysis.mapped_to);
+        }
+    }
+
+    IfcGeom::ThreadBudget::for_each(mapped_reps.size(), [&](size_t i) {
+        auto& analysis = mapped_analyses.find(mapped_reps[i])->second;
+        try {
+            analysis.reuse_ok = reuse_ok_(products_represented_by(mapped_reps[i], analysis.rmap));
+        } catch (...) {
+            analysis.error = std::current_exception();
+        }
+    }, num_threads_);
+
+    std::unordered_set<const IfcSchema::IfcRepresentation*> ok_mapped_representations, visited_representations;
 
     int task_index = 0;
     
-    for (auto representation : *representations) {
-        IfcSchema::IfcRepresentationMap* rmap = nullptr;
-        IfcSchema::IfcProduct::list::ptr ifcproducts = filter_products(products_represented_by(representation, rmap, false), filters);
+    for (size_t i = 0; i < reps.size(); ++i) {
+        IfcSchema::IfcRepresentation* representation = reps[i];
+        auto& analysis = analyses[i];
+
+        // When a representation is listed more than once, the maps that are found not to be reusable for
+        // its first occurrence affect the products of the next.
+        if (!visited_representations.insert(representation).second) {
+            analyze(representation, analysis);
+        }
+
+        if (analysis.error) {
+            std::rethrow_exception(analysis.error);
+        }
+
+        IfcSchema::IfcProduct::list::ptr& ifcproducts = analysis.products;
         
         if (ifcproducts->size() == 0) {
             continue;
         }
 
-        auto geometry_reuse_ok_for_current_representation_ = reuse_ok_(ifcproducts);
-        if (!geometry_reuse_ok_for_current_representation_ && rmap != nullptr) {
-            not_reusable_maps_.insert(rmap);
+        auto geometry_reuse_ok_for_current_representation_ = analysis.reuse_ok;
+        if (!geometry_reuse_ok_for_current_representation_ && analysis.rmap != nullptr) {
+            not_reusable_maps_.insert(analysis.rmap);
         }
 
         IfcSchema::IfcRepresentationMap::list::ptr maps = representation->RepresentationMap();
@@ -258,14 +331,26 @@ void mapping::get_representations(std::vector<geometry_conversion_task>& tasks,
 
         // Check if this representation has (or will be) processed as part its mapped representation
         bool representation_processed_as_mapped_item = false;
-        IfcSchema::IfcRepresentation* representation_mapped_to_result = representation_mapped_to(representation);
-        if (representation_mapped_to_result) {
-            representation_processed_as_mapped_item = geometry_reuse_ok_for_current_representation_ && (
-                ok_mapped_representations->contains(representation_mapped_to_result) || reuse_ok_(products_represented_by(representation_mapped_to_result, rmap)));
+        IfcSchema::IfcRepresentation* representation_mapped_to_result = analysis.mapped_to;
+        if (representation_mapped_to_result && geometry_reuse_ok_for_current_representation_) {
+            representation_processed_as_mapped_item = ok_mapped_representations.count(representation_mapped_to_result) > 0;
+            if (!representation_processed_as_mapped_item) {
+                auto it = mapped_analyses.find(representation_mapped_to_result);
+                if (it == mapped_analyses.end() || (it->second.rmap != nullptr && not_reusable_maps_.count(it->second.rmap))) {
+                    // The map of the mapped representation has been found not to be reusable since it was
+                    // analyzed, so that only its direct products are taken into account.
+                    IfcSchema::IfcRepresentationMap* rmap = nullptr;
+                    representation_processed_as_mapped_item = reuse_ok_(products_represented_by(representation_mapped_to_result, rmap));
+                } else if (it->second.error) {
+                    std::rethrow_exception(it->second.error);
+                } else {
+                    representation_processed_as_mapped_item = it->second.reuse_ok;
+                }
+            }
         }
 
         if (representation_processed_as_mapped_item) {
-            ok_mapped_representations->push(representation_mapped_to_result);
+            ok_mapped_representations.insert(representation_mapped_to_result);
             continue;
         }
 
@@ -665,10 +750,8 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcSurfaceStyle* style) {
 taxonomy::ptr mapping::map(const IfcBaseInterface* inst) {
     auto iden = inst->as<IfcUtil::IfcBaseClass>()->identity();
     if (use_caching_) {
-        std::lock_guard<std::mutex> guard(cache_guard_);
-        auto it = cache_.find(iden);
-        if (it != cache_.end()) {
-            return it->second;
+        if (auto cached = cache_->find(iden)) {
+            return cached;
         }
     }
     taxonomy::ptr item = nullptr;
@@ -679,12 +762,15 @@ taxonomy::ptr mapping::map(const IfcBaseInterface* inst) {
 
     bool matched = false;
 
+    {
+        IfcGeom::Profiler::scope profile(IfcGeom::Profiler::MAPPING, inst);
 #include "bind_convert_impl.i"
+    }
 
     if (item) {
         if (use_caching_) {
-            std::lock_guard<std::mutex> guard(cache_guard_);
-            cache_.insert({iden, item});
+            // When the cache is shared, another kernel may have mapped the same instance in the meantime
+            item = cache_->insert(iden, item);
         }
     } else if (!matched) {
         Logger::Message(Logger::LOG_ERROR, "No operation defined for:", inst);
@@ -1023,8 +1109,9 @@ bool mapping::get_layerset_information(const IfcUtil::IfcBaseInterface* p, layer
             offset += thickness;
 
             if (fabs(offset) < 1.e-7) {
-                auto ofc = c;
-                c->matrix = m4;
+                // The axis curve is shared through the mapping cache, so a copy is placed
+                auto ofc = taxonomy::geom_item::ptr(static_cast<taxonomy::geom_item*>(c->clone_()));
+                ofc->matrix = m4;
                 info.layers.push_back(ofc);
             } else {
                 auto ofc = taxonomy::make<taxonomy::offset_curve>();
@@ -1104,7 +1191,7 @@ bool mapping::get_layerset_information(const IfcUtil::IfcBaseInterface* p, layer
             auto offset_matrix = taxonomy::make<taxonomy::matrix4>();
             offset_matrix->components()(2, 3) = offset;
             offset_matrix->components()(3, 3) = 1.;
-            offset_matrix->components() *= extrusion_position->components();
+            offset_matrix->components() *= extrusion_position->ccomponents();
 
             auto pln = taxonomy::make<taxonomy::plane>();
             pln->matrix = offset_matrix;
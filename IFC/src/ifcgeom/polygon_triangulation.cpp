@@ -0,0 +1,301 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "polygon_triangulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	typedef Eigen::Vector2d point2;
+
+	// Twice the signed area of the triangle a, b, c, positive when it is counter-clockwise
+	double orient(const point2& a, const point2& b, const point2& c) {
+		return (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+	}
+
+	double signed_area(const std::vector<point2>& points, const std::vector<int>& loop) {
+		double area = 0.;
+		for (size_t i = 0; i < loop.size(); ++i) {
+			const point2& p = points[loop[i]];
+			const point2& q = points[loop[(i + 1) % loop.size()]];
+			area += p.x() * q.y() - q.x() * p.y();
+		}
+		return area / 2.;
+	}
+
+	// Whether p is inside or on the boundary of the counter-clockwise triangle a, b, c
+	bool in_triangle(const point2& a, const point2& b, const point2& c, const point2& p) {
+		return orient(a, b, p) >= 0. && orient(b, c, p) >= 0. && orient(c, a, p) >= 0.;
+	}
+
+	// Whether the direction from vertex i of the counter-clockwise polygon to p
+	// points into the polygon
+	bool locally_inside(const std::vector<point2>& points, const std::vector<int>& polygon, size_t i, const point2& p) {
+		const size_t n = polygon.size();
+		const point2& a = points[polygon[i]];
+		const point2& prev = points[polygon[(i + n - 1) % n]];
+		const point2& next = points[polygon[(i + 1) % n]];
+		if (orient(prev, a, next) > 0.) {
+			return orient(a, p, next) <= 0. && orient(a, prev, p) <= 0.;
+		} else {
+			return orient(a, p, prev) > 0. || orient(a, next, p) > 0.;
+		}
+	}
+
+	// Connects a clockwise hole to the counter-clockwise polygon with two coincident
+	// edges between the rightmost vertex of the hole and a vertex of the polygon that
+	// is visible from it, so that the result is a single counter-clockwise polygon.
+	bool bridge_hole(const std::vector<point2>& points, std::vector<int>& polygon, const std::vector<int>& hole) {
+		size_t m = 0;
+		for (size_t i = 1; i < hole.size(); ++i) {
+			if (points[hole[i]].x() > points[hole[m]].x()) {
+				m = i;
+			}
+		}
+		const point2& M = points[hole[m]];
+
+		// The closest edge of the polygon that is hit by a ray from M along +x,
+		// only upward edges are hit from the inside of the polygon.
+		const size_t n = polygon.size();
+		double closest = std::numeric_limits<double>::infinity();
+		size_t edge = n;
+		for (size_t i = 0; i < n; ++i) {
+			const point2& a = points[polygon[i]];
+			const point2& b = points[polygon[(i + 1) % n]];
+			if (a.y() < b.y() && a.y() <= M.y() && M.y() <= b.y()) {
+				const double x = a.x() + (M.y() - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+				if (x >= M.x() && x < closest) {
+					closest = x;
+					edge = i;
+				}
+			}
+		}
+		if (edge == n) {
+			return false;
+		}
+
+		const point2 I(closest, M.y());
+		const size_t ia = edge, ib = (edge + 1) % n;
+		size_t visible = points[polygon[ia]].x() > points[polygon[ib]].x() ? ia : ib;
+		if (points[polygon[ia]] == I) {
+			visible = ia;
+		} else if (points[polygon[ib]] == I) {
+			visible = ib;
+		} else {
+			// A reflex vertex inside the triangle M, I, P obstructs the view of P, in
+			// which case the reflex vertex with the smallest angle to the ray is visible.
+			const point2 P = points[polygon[visible]];
+			const bool ccw = orient(M, I, P) > 0.;
+			double smallest_angle = std::numeric_limits<double>::infinity();
+			double smallest_distance = std::numeric_limits<double>::infinity();
+			for (size_t i = 0; i < n; ++i) {
+				if (i == visible) {
+					continue;
+				}
+				const point2& r = points[polygon[i]];
+				if (orient(points[polygon[(i + n - 1) % n]], r, points[polygon[(i + 1) % n]]) > 0.) {
+					continue;
+				}
+				const bool inside = ccw ? in_triangle(M, I, P, r) : in_triangle(M, P, I, r);
+				if (!inside || r.x() <= M.x()) {
+					continue;
+				}
+				const double angle = std::fabs(r.y() - M.y()) / (r.x() - M.x());
+				const double distance = (r - M).squaredNorm();
+				if (angle < smallest_angle || (angle == smallest_angle && distance < smallest_distance)) {
+					smallest_angle = angle;
+					smallest_distance = distance;
+					visible = i;
+				}
+			}
+		}
+
+		// A vertex that is the end of an earlier bridge occurs twice, the bridge
+		// needs to start from the occurrence that has M on its inside.
+		for (size_t i = 0; i < n; ++i) {
+			if (i != visible && points[polygon[i]] == points[polygon[visible]] && locally_inside(points, polygon, i, M)) {
+				visible = i;
+				break;
+			}
+		}
+
+		std::vector<int> result;
+		result.reserve(n + hole.size() + 2);
+		result.insert(result.end(), polygon.begin(), polygon.begin() + visible + 1);
+		for (size_t i = 0; i <= hole.size(); ++i) {
+			result.push_back(hole[(m + i) % hole.size()]);
+		}
+		result.insert(result.end(), polygon.begin() + visible, polygon.end());
+		polygon.swap(result);
+		return true;
+	}
+
+	bool clip_ears(const std::vector<point2>& points, const std::vector<int>& polygon, std::vector<int>& triangles) {
+		const size_t n = polygon.size();
+		std::vector<size_t> prev(n), next(n);
+		for (size_t i = 0; i < n; ++i) {
+			prev[i] = (i + n - 1) % n;
+			next[i] = (i + 1) % n;
+		}
+
+		size_t remaining = n;
+		size_t i = 0;
+		size_t visited_without_ear = 0;
+		while (remaining > 3) {
+			const size_t p = prev[i], q = next[i];
+			const point2& a = points[polygon[p]];
+			const point2& b = points[polygon[i]];
+			const point2& c = points[polygon[q]];
+
+			bool ear = orient(a, b, c) > 0.;
+			if (ear) {
+				for (size_t j = next[q]; j != p; j = next[j]) {
+					const point2& r = points[polygon[j]];
+					// Vertices that coincide with the ear are the other ends of bridges
+					if (r == a || r == b || r == c) {
+						continue;
+					}
+					if (in_triangle(a, b, c, r)) {
+						ear = false;
+						break;
+					}
+				}
+			}
+
+			if (ear) {
+				triangles.push_back(polygon[p]);
+				triangles.push_back(polygon[i]);
+				triangles.push_back(polygon[q]);
+			} else if (++visited_without_ear <= remaining) {
+				i = q;
+				continue;
+			} else {
+				// Without ears the remaining polygon is degenerate, collinear vertices
+				// are removed, otherwise the polygon intersects itself.
+				size_t j = i;
+				do {
+					if (orient(points[polygon[prev[j]]], points[polygon[j]], points[polygon[next[j]]]) == 0.) {
+						break;
+					}
+					j = next[j];
+				} while (j != i);
+				if (orient(points[polygon[prev[j]]], points[polygon[j]], points[polygon[next[j]]]) != 0.) {
+					return false;
+				}
+				i = j;
+			}
+
+			next[prev[i]] = next[i];
+			prev[next[i]] = prev[i];
+			i = prev[i];
+			--remaining;
+			visited_without_ear = 0;
+		}
+
+		const point2& a = points[polygon[prev[i]]];
+		const point2& b = points[polygon[i]];
+		const point2& c = points[polygon[next[i]]];
+		if (orient(a, b, c) > 0.) {
+			triangles.push_back(polygon[prev[i]]);
+			triangles.push_back(polygon[i]);
+			triangles.push_back(polygon[next[i]]);
+		}
+
+		return true;
+	}
+}
+
+Eigen::Vector3d IfcGeom::util::polygon_normal(const std::vector<double>& xyz, const std::vector<int>& polygon) {
+	Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+	for (size_t i = 0; i < polygon.size(); ++i) {
+		const double* p = &xyz[3 * (size_t) polygon[i]];
+		const double* q = &xyz[3 * (size_t) polygon[(i + 1) % polygon.size()]];
+		normal.x() += (p[1] - q[1]) * (p[2] + q[2]);
+		normal.y() += (p[2] - q[2]) * (p[0] + q[0]);
+		normal.z() += (p[0] - q[0]) * (p[1] + q[1]);
+	}
+	return normal;
+}
+
+bool IfcGeom::util::triangulate_polygon(const std::vector<double>& xyz, const std::vector<std::vector<int>>& loops, const Eigen::Vector3d& normal, std::vector<int>& triangles) {
+	if (loops.empty() || loops.front().size() < 3) {
+		return false;
+	}
+
+	// A triangle without holes needs no projection
+	if (loops.size() == 1 && loops.front().size() == 3) {
+		triangles.insert(triangles.end(), loops.front().begin(), loops.front().end());
+		return true;
+	}
+
+	// Projects onto the plane of the two axes along which the normal is smallest,
+	// ordered so that the outer boundary is counter-clockwise
+	int axis;
+	normal.cwiseAbs().maxCoeff(&axis);
+	int u = (axis + 1) % 3, v = (axis + 2) % 3;
+	if (normal(axis) < 0.) {
+		std::swap(u, v);
+	}
+
+	std::vector<point2> points(xyz.size() / 3);
+	for (size_t i = 0; i < points.size(); ++i) {
+		points[i] = point2(xyz[3 * i + u], xyz[3 * i + v]);
+	}
+
+	if (signed_area(points, loops.front()) <= 0.) {
+		return false;
+	}
+
+	std::vector<int> polygon = loops.front();
+
+	// Holes are bridged from right to left, so that the bridges do not cross
+	std::vector<std::pair<double, std::vector<int>>> holes;
+	for (auto it = loops.begin() + 1; it != loops.end(); ++it) {
+		if (it->size() < 3) {
+			continue;
+		}
+		std::vector<int> hole = *it;
+		if (signed_area(points, hole) > 0.) {
+			std::reverse(hole.begin(), hole.end());
+		}
+		double max_x = -std::numeric_limits<double>::infinity();
+		for (int i : hole) {
+			max_x = (std::max)(max_x, points[i].x());
+		}
+		holes.emplace_back(max_x, std::move(hole));
+	}
+	std::stable_sort(holes.begin(), holes.end(), [](const std::pair<double, std::vector<int>>& a, const std::pair<double, std::vector<int>>& b) {
+		return a.first > b.first;
+	});
+	for (auto& h : holes) {
+		if (!bridge_hole(points, polygon, h.second)) {
+			return false;
+		}
+	}
+
+	std::vector<int> result;
+	result.reserve(3 * (polygon.size() - 2));
+	if (!clip_ears(points, polygon, result)) {
+		return false;
+	}
+	triangles.insert(triangles.end(), result.begin(), result.end());
+	return true;
+}
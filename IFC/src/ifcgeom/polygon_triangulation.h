@@ -0,0 +1,56 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Triangulates planar polygons with holes by ear clipping, without building a *
+ * boundary representation                                                      *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef POLYGON_TRIANGULATION_H
+#define POLYGON_TRIANGULATION_H
+
+#include "../ifcgeom/ifc_geom_api.h"
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+namespace IfcGeom {
+	namespace util {
+
+		/// Returns the normal of the polygon along the indices into xyz by Newell's
+		/// method. The length of the normal is twice the area of the polygon.
+		IFC_GEOM_API Eigen::Vector3d polygon_normal(const std::vector<double>& xyz, const std::vector<int>& polygon);
+
+		/// Triangulates the planar polygon of which the first loop is the outer
+		/// boundary and the other loops are holes. Loops are indices into the
+		/// coordinates in xyz and are not closed by repeating the first index.
+		/// Triangles are appended to triangles as indices into xyz, oriented
+		/// counter-clockwise around normal, which is the normal of the outer
+		/// boundary. Returns false when the polygon cannot be triangulated, for
+		/// example because it intersects itself, in which case triangles is
+		/// left unchanged.
+		IFC_GEOM_API bool triangulate_polygon(const std::vector<double>& xyz, const std::vector<std::vector<int>>& loops, const Eigen::Vector3d& normal, std::vector<int>& triangles);
+
+	}
+}
+
+#endif
@@ -3,6 +3,17 @@
 using namespace ifcopenshell::geometry;
 
 taxonomy::loop::ptr ifcopenshell::geometry::fillet_loop(taxonomy::loop::ptr loop, double radius) {
+	// The loop is shared with other conversions, so its edges and their points
+	// are copied before edges are inserted and points are moved.
+	loop = taxonomy::loop::ptr(loop->clone_());
+	for (auto& e : loop->children) {
+		e = taxonomy::edge::ptr(e->clone_());
+		for (auto* v : { &e->start, &e->end }) {
+			if (auto p = boost::get<taxonomy::point3::ptr>(v)) {
+				*p = taxonomy::point3::ptr((*p)->clone_());
+			}
+		}
+	}
 	std::vector<profile_point_with_edges_3d> pps(loop->children.size());
 	for (int b = 0; b < loop->children.size(); ++b) {
 		int c = (b - 1) % loop->children.size();
@@ -12,6 +12,7 @@
 
 #include <Eigen/Dense>
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <tuple>
@@ -144,7 +145,8 @@ typedef item const* ptr;
 			private:
 				uint32_t identity_;
 				static std::atomic_uint32_t counter_;
-				mutable size_t computed_hash_;
+				// Computed lazily, items that are shared between threads compute the same value
+				mutable std::atomic<size_t> computed_hash_;
 			public:
 				DECLARE_PTR(item)
 
@@ -158,18 +160,33 @@ typedef item const* ptr;
 				virtual void reverse() { throw taxonomy::topology_error(); }
 				virtual size_t calc_hash() const = 0;
 				virtual size_t hash() const {
-					if (computed_hash_) {
-						return computed_hash_;
+					size_t h = computed_hash_.load(std::memory_order_relaxed);
+					if (h) {
+						return h;
 					}
-					computed_hash_ = calc_hash();
-					if (computed_hash_ == 0) {
-						computed_hash_++;
+					h = calc_hash();
+					// Orientation is not part of calc_hash(), but it decides e.g. the side of a half space that is kept
+					boost::hash_combine(h, std::hash<size_t>{}(orientation ? *orientation ? 2 : 1 : 0));
+					if (h == 0) {
+						h++;
 					}
-					return computed_hash_;
+					computed_hash_.store(h, std::memory_order_relaxed);
+					return h;
 				}
 
 				item(const IfcUtil::IfcBaseInterface* instance = nullptr) : identity_(counter_++), computed_hash_(0), instance(instance) {}
 
+				// Copies are typically made to be modified, so the hash is not copied
+				item(const item& other) : identity_(other.identity_), computed_hash_(0), instance(other.instance), orientation(other.orientation) {}
+
+				item& operator=(const item& other) {
+					identity_ = other.identity_;
+					computed_hash_.store(0, std::memory_order_relaxed);
+					instance = other.instance;
+					orientation = other.orientation;
+					return *this;
+				}
+
 				virtual ~item() {}
 
 				uint32_t identity() const { return identity_; }
@@ -240,6 +257,9 @@ typedef item const* ptr;
 					}
 				}
 
+				// Allocates the components of an item that was constructed without them.
+				// Mapped items are shared between threads once they are cached, so these
+				// are read with ccomponents() and copied before they are modified.
 				T& components() {
 					if (!this->components_) {
 						this->components_ = new T(eigen_defaults<T>());
@@ -251,7 +271,7 @@ typedef item const* ptr;
 					return components_;
 				}
 
-				uint32_t hash_components() const {
+				size_t hash_components() const {
 					size_t h = std::hash<size_t>{}(T::RowsAtCompileTime);
 					boost::hash_combine(h, std::hash<size_t>{}(T::ColsAtCompileTime));
 					if (components_) {
@@ -260,7 +280,7 @@ typedef item const* ptr;
 							boost::hash_combine(h, std::hash<typename T::Scalar>()(elem));
 						}
 					}
-					return (uint32_t)h;
+					return h;
 				}
 			};
 
@@ -790,6 +810,16 @@ typedef item const* ptr;
 				}
 
 				void print(std::ostream& o, int indent = 0) const;
+
+				// Hashes the coordinates of a point rather than its address, so that equal trims hash equally
+				static size_t hash_trim(const boost::variant<boost::blank, point3::ptr, double>& v) {
+					if (auto p = boost::get<point3::ptr>(&v)) {
+						return *p ? (*p)->hash() : size_t(0);
+					} else if (auto d = boost::get<double>(&v)) {
+						return std::hash<double>{}(*d);
+					}
+					return 0;
+				}
 			};
 
 			struct edge : public trimmed_curve {
@@ -803,7 +833,7 @@ typedef item const* ptr;
 				virtual kinds kind() const { return EDGE; }
 
 				virtual size_t calc_hash() const {
-					auto v = std::make_tuple(static_cast<size_t>(EDGE), start, end, basis ? basis->hash() : size_t(0), curve_sense ? *curve_sense ? 2 : 1 : 0);
+					auto v = std::make_tuple(static_cast<size_t>(EDGE), hash_trim(start), hash_trim(end), basis ? basis->hash() : size_t(0), curve_sense ? *curve_sense ? 2 : 1 : 0);
 					return boost::hash<decltype(v)>{}(v);
 				}
 			};
@@ -813,8 +843,9 @@ typedef item const* ptr;
 				std::vector<typename T::ptr> children;
 
 				collection_base() {}
+				// Copies share the children, placement and style of the original
 				collection_base(const collection_base& other)
-					: geom_item()
+					: geom_item(other)
 				{
 					std::transform(other.children.begin(), other.children.end(), std::back_inserter(children), [](typename T::ptr p) { return clone(p); });
 				}
@@ -835,9 +866,10 @@ typedef item const* ptr;
 				*/
 
 				virtual void reverse() {
-					// @todo this needs to create copies of the children in case of shared_ptr
+					// Copies share their children, so the children are copied before they are reversed
 					std::reverse(children.begin(), children.end());
 					for (auto& child : children) {
+						child = typename T::ptr(static_cast<T*>(child->clone_()));
 						child->reverse();
 					}
 				}
@@ -865,13 +897,12 @@ typedef item const* ptr;
 #endif
 				}
 
-				uint32_t hash_elements() const {
+				size_t hash_elements() const {
 					size_t h = 0;
 					for (auto& c : children) {
 						boost::hash_combine(h, c->hash());
 					}
-					// @todo should we really use uint32_t instead of size_t for hashes?
-					return (uint32_t) h;
+					return h;
 				}
 			};
 
@@ -0,0 +1,90 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Subtracts boxes from a box with and without the attempt to process the       *
+ * subtraction as 2D operations on an extrusion, and checks that both yield the *
+ * same volume and that the 2D attempt processes the operands fully in 2D.      *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/Profiler.h"
+#include "../../ifcgeom/kernels/opencascade/boolean_utils.h"
+
+#include <BRepGProp.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <GProp_GProps.hxx>
+
+#include <cmath>
+#include <string>
+
+namespace {
+	struct subtraction {
+		std::string description;
+		gp_Pnt a_min, a_max, b_min, b_max;
+		double volume;
+	};
+
+	// Subtracts b from a, returns the volume of the result or a negative value on failure
+	double subtract(const subtraction& s, bool attempt_2d) {
+		IfcGeom::util::boolean_settings settings;
+		settings.debug = false;
+		settings.attempt_2d = attempt_2d;
+		settings.precision = 1.e-5;
+
+		TopTools_ListOfShape b;
+		b.Append(BRepPrimAPI_MakeBox(s.b_min, s.b_max).Shape());
+
+		TopoDS_Shape result;
+		if (!IfcGeom::util::boolean_operation(settings, BRepPrimAPI_MakeBox(s.a_min, s.a_max).Shape(), b, BOPAlgo_CUT, result)) {
+			return -1.;
+		}
+
+		GProp_GProps props;
+		BRepGProp::VolumeProperties(result, props);
+		return props.Mass();
+	}
+}
+
+int main() {
+	const subtraction subtractions[] = {
+		// A wall along X with an opening through part of its depth along Y
+		{ "a partial-depth opening in a wall", { 0., 0., 0. }, { 4., 1., 3. }, { 1., -0.1, 1. }, { 2., 0.5, 2. }, 11.5 },
+		// A slab with an opening through it along Z, which is not the first direction tried
+		{ "a vertical opening through a slab", { 0., 0., 0. }, { 4., 3., 0.3 }, { 1., 1., -0.1 }, { 2., 2., 0.4 }, 3.3 }
+	};
+
+	IfcGeom::Profiler::enable(true);
+
+	for (auto& s : subtractions) {
+		IfcGeom::Profiler::reset();
+		const double volume_3d = subtract(s, false);
+		check(std::fabs(volume_3d - s.volume) < 1.e-6, "the 3D subtraction of " + s.description + " has the expected volume");
+		check(IfcGeom::Profiler::counter("boolean_2d") == 0, "the 3D subtraction of " + s.description + " is not processed in 2D");
+
+		const double volume_2d = subtract(s, true);
+		check(std::fabs(volume_2d - volume_3d) < 1.e-6, "the 2D subtraction of " + s.description + " has the volume of the 3D subtraction");
+		check(IfcGeom::Profiler::counter("boolean_2d") == 1, "the 2D subtraction of " + s.description + " is processed fully in 2D");
+	}
+
+	return exit_status();
+}
@@ -0,0 +1,65 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Checks shared by the tests, which report every check that fails and return  *
+ * a nonzero exit status when any did                                           *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include "../../ifcparse/IfcFile.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+	int failures = 0;
+
+	/// Reports description, which states what is expected, when condition does
+	/// not hold. Returns condition, so that a test can stop when later checks
+	/// depend on it.
+	inline bool check(bool condition, const std::string& description) {
+		if (!condition) {
+			std::cerr << "Failed: " << description << std::endl;
+			++failures;
+		}
+		return condition;
+	}
+
+	/// The exit status of the test
+	inline int exit_status() {
+		return failures ? 1 : 0;
+	}
+
+	/// Parses a model from SPF data in memory
+	inline std::unique_ptr<IfcParse::IfcFile> parse_model(const std::string& model) {
+		// The file takes ownership of the data
+		char* data = new char[model.size()];
+		memcpy(data, model.data(), model.size());
+		return std::unique_ptr<IfcParse::IfcFile>(new IfcParse::IfcFile(data, (int) model.size()));
+	}
+}
+
+#endif
@@ -0,0 +1,134 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Converts two products with separate but identical extrusions, placed at      *
+ * different positions within their representations and by their products,     *
+ * with deduplicate-geometry on a single thread. Checks that the extrusion is   *
+ * converted once and emitted for both products, each with its own transform    *
+ * that places the shared triangulation where the product's own extrusion is.   *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/Iterator.h"
+
+#include <map>
+#include <string>
+
+using namespace ifcopenshell::geometry;
+
+namespace {
+	// A is placed at the origin and its extrusion as well, B is placed at (10, 0, 0)
+	// and its extrusion at (0, 5, 0) within the representation
+	const std::string model =
+		"ISO-10303-21;\n"
+		"HEADER;\n"
+		"FILE_DESCRIPTION((''),'2;1');\n"
+		"FILE_NAME('','',(''),(''),'','','');\n"
+		"FILE_SCHEMA(('IFC2X3'));\n"
+		"ENDSEC;\n"
+		"DATA;\n"
+		"#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+		"#2=IFCDIRECTION((0.,0.,1.));\n"
+		"#3=IFCDIRECTION((1.,0.,0.));\n"
+		"#4=IFCAXIS2PLACEMENT3D(#1,#2,#3);\n"
+		"#5=IFCGEOMETRICREPRESENTATIONCONTEXT($,'Model',3,1.E-05,#4,$);\n"
+		"#6=IFCSIUNIT(*,.LENGTHUNIT.,$,.METRE.);\n"
+		"#7=IFCUNITASSIGNMENT((#6));\n"
+		"#8=IFCPROJECT('0YvctVUKr0kugbFTf53O9L',$,'Project',$,$,$,$,(#5),#7);\n"
+		"#9=IFCLOCALPLACEMENT($,#4);\n"
+		"#10=IFCCARTESIANPOINT((0.,0.));\n"
+		"#11=IFCAXIS2PLACEMENT2D(#10,$);\n"
+		"#12=IFCRECTANGLEPROFILEDEF(.AREA.,$,#11,2.,1.);\n"
+		"#13=IFCEXTRUDEDAREASOLID(#12,#4,#2,3.);\n"
+		"#14=IFCSHAPEREPRESENTATION(#5,'Body','SweptSolid',(#13));\n"
+		"#15=IFCPRODUCTDEFINITIONSHAPE($,$,(#14));\n"
+		"#16=IFCBUILDINGELEMENTPROXY('1kTvXnbbzCWw8lcMd1dR4o',$,'A',$,$,#9,#15,$,$);\n"
+		"#17=IFCCARTESIANPOINT((10.,0.,0.));\n"
+		"#18=IFCAXIS2PLACEMENT3D(#17,#2,#3);\n"
+		"#19=IFCLOCALPLACEMENT($,#18);\n"
+		"#20=IFCCARTESIANPOINT((0.,0.));\n"
+		"#21=IFCAXIS2PLACEMENT2D(#20,$);\n"
+		"#22=IFCRECTANGLEPROFILEDEF(.AREA.,$,#21,2.,1.);\n"
+		"#23=IFCCARTESIANPOINT((0.,5.,0.));\n"
+		"#24=IFCAXIS2PLACEMENT3D(#23,#2,#3);\n"
+		"#25=IFCEXTRUDEDAREASOLID(#22,#24,#2,3.);\n"
+		"#26=IFCSHAPEREPRESENTATION(#5,'Body','SweptSolid',(#25));\n"
+		"#27=IFCPRODUCTDEFINITIONSHAPE($,$,(#26));\n"
+		"#28=IFCBUILDINGELEMENTPROXY('2kTvXnbbzCWw8lcMd1dR4o',$,'B',$,$,#19,#27,$,$);\n"
+		"ENDSEC;\n"
+		"END-ISO-10303-21;\n";
+
+	struct emitted {
+		const IfcGeom::Representation::Triangulation* geometry;
+		Eigen::Vector3d min, max;
+	};
+
+	// The bounds of the vertices of elem after its transformation
+	emitted world_bounds(const IfcGeom::TriangulationElement& elem) {
+		const Eigen::Matrix4d& m = elem.transformation().data()->ccomponents();
+		const auto& verts = elem.geometry().verts();
+		emitted e = { &elem.geometry(), Eigen::Vector3d::Constant(1.e9), Eigen::Vector3d::Constant(-1.e9) };
+		for (size_t i = 0; i + 2 < verts.size(); i += 3) {
+			const Eigen::Vector3d p = (m * Eigen::Vector4d(verts[i], verts[i + 1], verts[i + 2], 1.)).head<3>();
+			e.min = e.min.cwiseMin(p);
+			e.max = e.max.cwiseMax(p);
+		}
+		return e;
+	}
+
+	bool near(const Eigen::Vector3d& a, const Eigen::Vector3d& b) {
+		return (a - b).norm() < 1.e-6;
+	}
+}
+
+int main() {
+	auto file = parse_model(model);
+	if (!check(file->good(), "the model is parsed")) {
+		return exit_status();
+	}
+
+	std::map<std::string, emitted> elements;
+	{
+		Settings settings;
+		settings.get<settings::DeduplicateGeometry>().value = true;
+		IfcGeom::Iterator iterator(settings, file.get(), {}, 1);
+		if (iterator.initialize()) {
+			do {
+				auto elem = dynamic_cast<IfcGeom::TriangulationElement*>(iterator.get());
+				if (elem) {
+					elements[elem->name()] = world_bounds(*elem);
+				}
+			} while (iterator.next());
+		}
+	}
+
+	if (!check(elements.size() == 2 && elements.count("A") && elements.count("B"), "both products are emitted")) {
+		return exit_status();
+	}
+
+	check(elements["A"].geometry == elements["B"].geometry, "the products share the triangulation of a single conversion");
+	check(near(elements["A"].min, { -1., -0.5, 0. }) && near(elements["A"].max, { 1., 0.5, 3. }), "A is placed at the origin");
+	check(near(elements["B"].min, { 9., 4.5, 0. }) && near(elements["B"].max, { 11., 5.5, 3. }), "B is placed at its extrusion's position within its placement");
+
+	return exit_status();
+}
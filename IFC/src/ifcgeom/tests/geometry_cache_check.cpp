@@ -0,0 +1,155 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Checks that a geometry cache entry is only read with the check it was        *
+ * written with, so that geometry of which the key collides with the key of an  *
+ * entry is not read from it, and that the hashes and the serializations the    *
+ * keys and checks are computed from tell apart geometry that differs only in   *
+ * the coordinates of a point or in the AgreementFlag of a half space. Only the *
+ * mapping is used, no geometry kernel is needed.                               *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/abstract_mapping.h"
+#include "../../ifcgeom/GeometryCache.h"
+
+#include <boost/filesystem.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace ifcopenshell::geometry;
+
+namespace {
+	// Three clippings of the same extrusion, #23 equals #21 and #22 only differs in AgreementFlag
+	const std::string model =
+		"ISO-10303-21;\n"
+		"HEADER;\n"
+		"FILE_DESCRIPTION((''),'2;1');\n"
+		"FILE_NAME('','',(''),(''),'','','');\n"
+		"FILE_SCHEMA(('IFC2X3'));\n"
+		"ENDSEC;\n"
+		"DATA;\n"
+		"#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+		"#2=IFCCARTESIANPOINT((0.,0.));\n"
+		"#3=IFCDIRECTION((0.,0.,1.));\n"
+		"#4=IFCDIRECTION((1.,0.,0.));\n"
+		"#5=IFCAXIS2PLACEMENT3D(#1,#3,#4);\n"
+		"#6=IFCAXIS2PLACEMENT2D(#2,$);\n"
+		"#7=IFCRECTANGLEPROFILEDEF(.AREA.,$,#6,2.,2.);\n"
+		"#8=IFCEXTRUDEDAREASOLID(#7,#5,#3,2.);\n"
+		"#9=IFCCARTESIANPOINT((0.,0.,1.));\n"
+		"#10=IFCAXIS2PLACEMENT3D(#9,#3,#4);\n"
+		"#11=IFCPLANE(#10);\n"
+		"#12=IFCHALFSPACESOLID(#11,.T.);\n"
+		"#13=IFCHALFSPACESOLID(#11,.F.);\n"
+		"#14=IFCHALFSPACESOLID(#11,.T.);\n"
+		"#21=IFCBOOLEANCLIPPINGRESULT(.DIFFERENCE.,#8,#12);\n"
+		"#22=IFCBOOLEANCLIPPINGRESULT(.DIFFERENCE.,#8,#13);\n"
+		"#23=IFCBOOLEANCLIPPINGRESULT(.DIFFERENCE.,#8,#14);\n"
+		"ENDSEC;\n"
+		"END-ISO-10303-21;\n";
+
+	void check_entries() {
+		const auto directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+		{
+			Settings settings;
+			IfcGeom::GeometryCache cache(directory.string(), 0);
+
+			const IfcGeom::GeometryCache::key_type key = 0x1234, check_value = 0x5678;
+
+			IfcGeom::Representation::Triangulation triangulation(
+				settings, "IfcBuildingElementProxy", "1",
+				{ 0., 0., 0., 1., 0., 0., 0., 1., 0. }, { 0, 1, 2 }, {},
+				{ 0., 0., 1., 0., 0., 1., 0., 0., 1. }, {},
+				{ -1 }, {},
+				{ 1 }, {});
+
+			check(cache.write(key, check_value, triangulation, { 1 }, false), "the entry is written");
+
+			std::unique_ptr<IfcGeom::Representation::Triangulation> read(cache.read(key, check_value, settings, "IfcBuildingElementProxy", "1", "", { 1 }));
+			check(read && read->verts() == triangulation.verts(), "the entry is read with its check");
+
+			std::unique_ptr<IfcGeom::Representation::Triangulation> colliding(cache.read(key, check_value + 1, settings, "IfcBuildingElementProxy", "1", "", { 1 }));
+			check(!colliding, "the entry is not read with another check");
+		}
+
+		boost::system::error_code ec;
+		boost::filesystem::remove_all(directory, ec);
+	}
+
+	void check_points() {
+		std::string a, b, c;
+		IfcGeom::GeometryCache::serialize(taxonomy::make<taxonomy::point3>(1., 2., 3.), a);
+		IfcGeom::GeometryCache::serialize(taxonomy::make<taxonomy::point3>(1., 2., 3.), b);
+		IfcGeom::GeometryCache::serialize(taxonomy::make<taxonomy::point3>(1., 2., 3. + 1.e-12), c);
+
+		check(a == b && IfcGeom::GeometryCache::digest(a) == IfcGeom::GeometryCache::digest(b), "equal points have the same serialization");
+		check(a != c && IfcGeom::GeometryCache::digest(a) != IfcGeom::GeometryCache::digest(c), "different points have a different serialization");
+	}
+
+	void check_half_spaces() {
+		auto file = parse_model(model);
+		if (!check(file->good(), "the model is parsed")) {
+			return;
+		}
+
+		Settings settings;
+		std::unique_ptr<abstract_mapping> mapping(ifcopenshell::geometry::impl::mapping_implementations().construct(file.get(), settings));
+
+		auto hash = [&mapping, &file](int id) -> boost::optional<size_t> {
+			auto item = mapping->map(file->instance_by_id(id));
+			if (!item) {
+				return boost::none;
+			}
+			std::vector<int> item_ids;
+			return IfcGeom::GeometryCache::hash(item, item_ids);
+		};
+		auto serialization = [&mapping, &file](int id) {
+			std::string data;
+			IfcGeom::GeometryCache::serialize(mapping->map(file->instance_by_id(id)), data);
+			return data;
+		};
+
+		auto agreeing = hash(21);
+		auto opposing = hash(22);
+		auto identical = hash(23);
+		if (!check(agreeing && opposing && identical, "the clippings are mapped")) {
+			return;
+		}
+
+		check(*agreeing != *opposing, "clippings with opposite AgreementFlag have a different hash");
+		check(*agreeing == *identical, "identical clippings have the same hash");
+		check(serialization(21) != serialization(22), "clippings with opposite AgreementFlag have a different serialization");
+		check(serialization(21) == serialization(23), "identical clippings have the same serialization");
+	}
+}
+
+int main() {
+	check_entries();
+	check_points();
+	check_half_spaces();
+
+	return exit_status();
+}
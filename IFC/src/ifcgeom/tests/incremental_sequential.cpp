@@ -0,0 +1,131 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Converts the same file twice on a single thread with a geometry cache and an *
+ * incremental manifest, and checks that the second run reuses all products     *
+ * from the first run and emits the same triangulations.                        *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/Iterator.h"
+#include "../../ifcgeom/GeometryCache.h"
+#include "../../ifcgeom/IncrementalManifest.h"
+
+#include <boost/filesystem.hpp>
+
+#include <map>
+#include <string>
+
+using namespace ifcopenshell::geometry;
+
+namespace {
+	// Two products that share a representation
+	const std::string model =
+		"ISO-10303-21;\n"
+		"HEADER;\n"
+		"FILE_DESCRIPTION((''),'2;1');\n"
+		"FILE_NAME('','',(''),(''),'','','');\n"
+		"FILE_SCHEMA(('IFC2X3'));\n"
+		"ENDSEC;\n"
+		"DATA;\n"
+		"#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+		"#2=IFCDIRECTION((0.,0.,1.));\n"
+		"#3=IFCDIRECTION((1.,0.,0.));\n"
+		"#4=IFCAXIS2PLACEMENT3D(#1,#2,#3);\n"
+		"#5=IFCGEOMETRICREPRESENTATIONCONTEXT($,'Model',3,1.E-05,#4,$);\n"
+		"#6=IFCSIUNIT(*,.LENGTHUNIT.,$,.METRE.);\n"
+		"#7=IFCUNITASSIGNMENT((#6));\n"
+		"#8=IFCPROJECT('0YvctVUKr0kugbFTf53O9L',$,'Project',$,$,$,$,(#5),#7);\n"
+		"#9=IFCLOCALPLACEMENT($,#4);\n"
+		"#10=IFCCARTESIANPOINT((0.,0.));\n"
+		"#11=IFCAXIS2PLACEMENT2D(#10,$);\n"
+		"#12=IFCRECTANGLEPROFILEDEF(.AREA.,$,#11,2.,1.);\n"
+		"#13=IFCEXTRUDEDAREASOLID(#12,#4,#2,3.);\n"
+		"#14=IFCSHAPEREPRESENTATION(#5,'Body','SweptSolid',(#13));\n"
+		"#15=IFCPRODUCTDEFINITIONSHAPE($,$,(#14));\n"
+		"#16=IFCBUILDINGELEMENTPROXY('1kTvXnbbzCWw8lcMd1dR4o',$,'A',$,$,#9,#15,$,$);\n"
+		"#17=IFCCARTESIANPOINT((5.,0.,0.));\n"
+		"#18=IFCAXIS2PLACEMENT3D(#17,#2,#3);\n"
+		"#19=IFCLOCALPLACEMENT($,#18);\n"
+		"#20=IFCPRODUCTDEFINITIONSHAPE($,$,(#14));\n"
+		"#21=IFCBUILDINGELEMENTPROXY('2kTvXnbbzCWw8lcMd1dR4o',$,'B',$,$,#19,#20,$,$);\n"
+		"ENDSEC;\n"
+		"END-ISO-10303-21;\n";
+
+	// Converts file on a single thread, returns the number of vertices per product GlobalId
+	std::map<std::string, size_t> convert(IfcParse::IfcFile& file, const std::string& cache_directory, const std::string& manifest_path, size_t& reused, size_t& recorded) {
+		std::map<std::string, size_t> vertices;
+
+		IfcGeom::GeometryCache cache(cache_directory, 0);
+		IfcGeom::IncrementalManifest manifest;
+		manifest.read(manifest_path);
+
+		{
+			Settings settings;
+			IfcGeom::Iterator iterator(settings, &file, {}, 1);
+			iterator.set_geometry_cache(&cache);
+			iterator.set_incremental_manifest(&manifest);
+
+			if (iterator.initialize()) {
+				do {
+					auto elem = dynamic_cast<IfcGeom::TriangulationElement*>(iterator.get());
+					if (elem) {
+						vertices[elem->guid()] = elem->geometry().verts().size();
+					}
+				} while (iterator.next());
+			}
+		}
+
+		reused = manifest.reused();
+		recorded = manifest.recorded();
+		manifest.write(manifest_path);
+
+		return vertices;
+	}
+}
+
+int main() {
+	auto file = parse_model(model);
+	if (!check(file->good(), "the model is parsed")) {
+		return exit_status();
+	}
+
+	const auto directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	const std::string cache_directory = (directory / "cache").string();
+	const std::string manifest_path = (directory / "manifest").string();
+	boost::filesystem::create_directories(directory);
+
+	size_t reused, recorded;
+	auto first = convert(*file, cache_directory, manifest_path, reused, recorded);
+	check(first.size() == 2 && reused == 0 && recorded == 2, "the first run converts and records both products");
+
+	// The products are read from the cache without mapping their representation
+	auto second = convert(*file, cache_directory, manifest_path, reused, recorded);
+	check(reused == 2 && recorded == 2, "the second run reuses and records both products");
+	check(second == first, "the second run emits the triangulations of the first run");
+
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(directory, ec);
+
+	return exit_status();
+}
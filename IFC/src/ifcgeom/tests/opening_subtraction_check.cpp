@@ -0,0 +1,138 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Converts a wall with a row of openings through it with and without parallel *
+ * opening subtraction, which splits the single solid of the wall between its   *
+ * openings, and checks that both yield the volume of the wall without the      *
+ * openings.                                                                    *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/Iterator.h"
+#include "../../ifcparse/IfcGlobalId.h"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+using namespace ifcopenshell::geometry;
+
+namespace {
+	const int num_openings = 16;
+
+	// A wall of num_openings + 1 by 0.2 by 3 m with an opening of 0.5 by 1 m every meter
+	std::string generate_model() {
+		std::ostringstream oss;
+		oss <<
+			"ISO-10303-21;\n"
+			"HEADER;\n"
+			"FILE_DESCRIPTION((''),'2;1');\n"
+			"FILE_NAME('','',(''),(''),'','','');\n"
+			"FILE_SCHEMA(('IFC2X3'));\n"
+			"ENDSEC;\n"
+			"DATA;\n"
+			"#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+			"#2=IFCDIRECTION((0.,0.,1.));\n"
+			"#3=IFCDIRECTION((1.,0.,0.));\n"
+			"#4=IFCAXIS2PLACEMENT3D(#1,#2,#3);\n"
+			"#5=IFCGEOMETRICREPRESENTATIONCONTEXT($,'Model',3,1.E-05,#4,$);\n"
+			"#6=IFCSIUNIT(*,.LENGTHUNIT.,$,.METRE.);\n"
+			"#7=IFCUNITASSIGNMENT((#6));\n"
+			"#8=IFCPROJECT('0YvctVUKr0kugbFTf53O9L',$,'Project',$,$,$,$,(#5),#7);\n"
+			"#9=IFCLOCALPLACEMENT($,#4);\n"
+			"#10=IFCCARTESIANPOINT((" << (num_openings + 1) / 2. << ",0.));\n"
+			"#11=IFCAXIS2PLACEMENT2D(#10,$);\n"
+			"#12=IFCRECTANGLEPROFILEDEF(.AREA.,$,#11," << num_openings + 1 << ".,0.2);\n"
+			"#13=IFCEXTRUDEDAREASOLID(#12,#4,#2,3.);\n"
+			"#14=IFCSHAPEREPRESENTATION(#5,'Body','SweptSolid',(#13));\n"
+			"#15=IFCPRODUCTDEFINITIONSHAPE($,$,(#14));\n"
+			"#16=IFCWALL('1kTvXnbbzCWw8lcMd1dR4o',$,'Wall',$,$,#9,#15,$);\n"
+			"#17=IFCCARTESIANPOINT((0.,0.));\n"
+			"#18=IFCAXIS2PLACEMENT2D(#17,$);\n"
+			"#19=IFCRECTANGLEPROFILEDEF(.AREA.,$,#18,0.5,0.4);\n"
+			"#20=IFCCARTESIANPOINT((0.,0.,1.));\n"
+			"#21=IFCAXIS2PLACEMENT3D(#20,#2,#3);\n"
+			"#22=IFCEXTRUDEDAREASOLID(#19,#21,#2,1.);\n"
+			"#23=IFCSHAPEREPRESENTATION(#5,'Body','SweptSolid',(#22));\n"
+			"#24=IFCPRODUCTDEFINITIONSHAPE($,$,(#23));\n";
+
+		// The openings are placed relative to the wall, each with a placement, an opening and a voids relationship
+		for (int i = 0; i < num_openings; ++i) {
+			const int id = 100 + 5 * i;
+			oss <<
+				"#" << id << "=IFCCARTESIANPOINT((" << i + 1 << ".,0.,0.));\n"
+				"#" << id + 1 << "=IFCAXIS2PLACEMENT3D(#" << id << ",#2,#3);\n"
+				"#" << id + 2 << "=IFCLOCALPLACEMENT(#9,#" << id + 1 << ");\n"
+				"#" << id + 3 << "=IFCOPENINGELEMENT('" << (const std::string&) IfcParse::IfcGlobalId() << "',$,$,$,$,#" << id + 2 << ",#24,$);\n"
+				"#" << id + 4 << "=IFCRELVOIDSELEMENT('" << (const std::string&) IfcParse::IfcGlobalId() << "',$,$,$,#16,#" << id + 3 << ");\n";
+		}
+
+		oss <<
+			"ENDSEC;\n"
+			"END-ISO-10303-21;\n";
+		return oss.str();
+	}
+
+	// The volume enclosed by the triangles of the wall, -1 when it is not emitted
+	double wall_volume(IfcParse::IfcFile& file, int parallel_opening_subtraction) {
+		Settings settings;
+		settings.get<settings::ParallelOpeningSubtraction>().value = parallel_opening_subtraction;
+
+		// A single conversion thread leaves the other hardware threads to the opening subtraction
+		IfcGeom::Iterator iterator(settings, &file, {}, 1);
+		if (iterator.initialize()) {
+			do {
+				auto elem = dynamic_cast<IfcGeom::TriangulationElement*>(iterator.get());
+				if (elem && elem->name() == "Wall") {
+					const auto& verts = elem->geometry().verts();
+					const auto& faces = elem->geometry().faces();
+					double volume = 0.;
+					for (size_t i = 0; i + 2 < faces.size(); i += 3) {
+						const Eigen::Vector3d a(verts[3 * faces[i]], verts[3 * faces[i] + 1], verts[3 * faces[i] + 2]);
+						const Eigen::Vector3d b(verts[3 * faces[i + 1]], verts[3 * faces[i + 1] + 1], verts[3 * faces[i + 1] + 2]);
+						const Eigen::Vector3d c(verts[3 * faces[i + 2]], verts[3 * faces[i + 2] + 1], verts[3 * faces[i + 2] + 2]);
+						volume += a.dot(b.cross(c)) / 6.;
+					}
+					return volume;
+				}
+			} while (iterator.next());
+		}
+		return -1.;
+	}
+}
+
+int main() {
+	auto file = parse_model(generate_model());
+	if (!check(file->good(), "the model is parsed")) {
+		return exit_status();
+	}
+
+	const double expected = (num_openings + 1) * 0.2 * 3. - num_openings * 0.5 * 1. * 0.2;
+	const double serial = wall_volume(*file, 0);
+	const double parallel = wall_volume(*file, 1);
+
+	check(std::fabs(serial - expected) < 1.e-6, "the openings are subtracted from the wall on a single thread");
+	check(std::fabs(parallel - serial) < 1.e-6, "the openings subtracted in parallel yield the volume of a single thread");
+
+	return exit_status();
+}
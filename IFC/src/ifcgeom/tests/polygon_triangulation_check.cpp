@@ -0,0 +1,175 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Checks triangulate_polygon() on planar polygons with and without holes, in   *
+ * horizontal and vertical planes: a polygon of n vertices in total with h      *
+ * holes is triangulated into n + 2h - 2 triangles that are oriented around the *
+ * normal and cover the area of the polygon, and an outer boundary that is      *
+ * clockwise around the normal is rejected.                                     *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/polygon_triangulation.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using IfcGeom::util::polygon_normal;
+using IfcGeom::util::triangulate_polygon;
+
+namespace {
+	struct polygon {
+		std::vector<double> xyz;
+		std::vector<std::vector<int>> loops;
+
+		// Adds a loop of points in the plane spanned by the unit vectors u and v through origin
+		void add_loop(const std::vector<std::pair<double, double>>& uv, const Eigen::Vector3d& origin, const Eigen::Vector3d& u, const Eigen::Vector3d& v) {
+			loops.emplace_back();
+			for (auto& p : uv) {
+				const Eigen::Vector3d q = origin + p.first * u + p.second * v;
+				loops.back().push_back((int) xyz.size() / 3);
+				xyz.insert(xyz.end(), { q.x(), q.y(), q.z() });
+			}
+		}
+
+		size_t num_vertices() const {
+			size_t n = 0;
+			for (auto& l : loops) {
+				n += l.size();
+			}
+			return n;
+		}
+
+		// The area of the outer boundary minus the area of the holes
+		double area() const {
+			double a = polygon_normal(xyz, loops.front()).norm() / 2.;
+			for (auto it = loops.begin() + 1; it != loops.end(); ++it) {
+				a -= polygon_normal(xyz, *it).norm() / 2.;
+			}
+			return a;
+		}
+	};
+
+	std::vector<std::pair<double, double>> rectangle(double u0, double v0, double u1, double v1) {
+		return { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } };
+	}
+
+	// A comb of teeth teeth pointing along v, counter-clockwise
+	std::vector<std::pair<double, double>> comb(int teeth) {
+		std::vector<std::pair<double, double>> uv = { { 0., 0. }, { 2. * teeth - 1., 0. } };
+		for (int i = teeth - 1; i >= 0; --i) {
+			uv.push_back({ 2. * i + 1., 3. });
+			uv.push_back({ 2. * i, 3. });
+			if (i > 0) {
+				uv.push_back({ 2. * i, 1. });
+				uv.push_back({ 2. * i - 1., 1. });
+			}
+		}
+		return uv;
+	}
+
+	void check_triangulation(const polygon& p, const std::string& name) {
+		const Eigen::Vector3d normal = polygon_normal(p.xyz, p.loops.front());
+
+		std::vector<int> triangles;
+		if (!check(triangulate_polygon(p.xyz, p.loops, normal, triangles), name + " is triangulated")) {
+			return;
+		}
+
+		const size_t num_holes = p.loops.size() - 1;
+		check(triangles.size() == 3 * (p.num_vertices() + 2 * num_holes - 2), name + " has n + 2h - 2 triangles");
+
+		double area = 0.;
+		bool oriented = true;
+		for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+			const Eigen::Vector3d a = Eigen::Vector3d::Map(&p.xyz[3 * triangles[i]]);
+			const Eigen::Vector3d b = Eigen::Vector3d::Map(&p.xyz[3 * triangles[i + 1]]);
+			const Eigen::Vector3d c = Eigen::Vector3d::Map(&p.xyz[3 * triangles[i + 2]]);
+			const Eigen::Vector3d n = (b - a).cross(c - a);
+			oriented = oriented && n.dot(normal) > 0.;
+			area += n.norm() / 2.;
+		}
+		check(oriented, name + " has triangles oriented around the normal");
+		check(std::abs(area - p.area()) < 1.e-9 * p.area(), name + " has the area of the polygon");
+	}
+}
+
+int main() {
+	const Eigen::Vector3d origin(1., 2., 3.);
+	const Eigen::Vector3d x = Eigen::Vector3d::UnitX(), y = Eigen::Vector3d::UnitY(), z = Eigen::Vector3d::UnitZ();
+
+	{
+		polygon p;
+		p.add_loop(rectangle(0., 0., 4., 4.), origin, x, y);
+		check_triangulation(p, "a square");
+		p.add_loop(rectangle(1., 1., 3., 3.), origin, x, y);
+		check_triangulation(p, "a square with a hole");
+	}
+
+	{
+		// Holes are clockwise as IFC prescribes, and counter-clockwise
+		polygon p;
+		p.add_loop(rectangle(0., 0., 10., 4.), origin, x, y);
+		auto hole = rectangle(1., 1., 3., 3.);
+		p.add_loop({ hole.rbegin(), hole.rend() }, origin, x, y);
+		p.add_loop(rectangle(4., 1., 6., 3.), origin, x, y);
+		p.add_loop(rectangle(7., 1., 9., 2.), origin, x, y);
+		check_triangulation(p, "a rectangle with three holes");
+	}
+
+	{
+		polygon p;
+		p.add_loop(comb(6), origin, x, y);
+		check_triangulation(p, "a concave comb");
+	}
+
+	{
+		// Vertical faces, as the sides of walls, both facing the axes and facing away from them
+		polygon p;
+		p.add_loop(rectangle(0., 0., 5., 3.), origin, x, z);
+		p.add_loop(rectangle(1., 0.5, 2., 2.5), origin, x, z);
+		p.add_loop(rectangle(3., 1., 4., 2.), origin, x, z);
+		check_triangulation(p, "a wall side along X with a door and a window");
+
+		polygon q;
+		q.add_loop(rectangle(0., 0., 5., 3.), origin, z, y);
+		q.add_loop(rectangle(1., 1., 2., 2.), origin, z, y);
+		check_triangulation(q, "a wall side along Z with a window");
+
+		polygon r;
+		r.add_loop(comb(4), origin, -y, z);
+		check_triangulation(r, "a vertical concave comb");
+	}
+
+	{
+		polygon p;
+		auto outer = rectangle(0., 0., 4., 4.);
+		p.add_loop({ outer.rbegin(), outer.rend() }, origin, x, y);
+		std::vector<int> triangles = { 7 };
+		check(!triangulate_polygon(p.xyz, p.loops, z, triangles), "a clockwise outer boundary is rejected");
+		check(triangles == std::vector<int>{ 7 }, "the triangles are unchanged when the polygon is rejected");
+	}
+
+	return exit_status();
+}
@@ -0,0 +1,238 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Compares the wall time of converting a model on multiple threads with the    *
+ * representations scheduled in the order in which they are found in the file  *
+ * (no-cost-ordering) and with the ones with the highest estimated cost first,  *
+ * and checks that ordered-output emits the elements in the order of a          *
+ * conversion on a single thread. The model consists of many small extrusions,  *
+ * followed by a wall with many openings and a large faceted brep, so that the  *
+ * most expensive representations are found last. Takes a scale as the         *
+ * argument: 100 small extrusions, 10 openings and 120 brep faces per unit.     *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/Iterator.h"
+#include "../../ifcparse/IfcGlobalId.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace ifcopenshell::geometry;
+
+namespace {
+	// Writes the instances of the model in SPF, numbered from 1 in the order written
+	class model_writer {
+	public:
+		model_writer() : id_(0) {}
+
+		int add(const std::string& instance) {
+			data_ << "#" << ++id_ << "=" << instance << ";\n";
+			return id_;
+		}
+
+		std::string str() const {
+			return
+				"ISO-10303-21;\n"
+				"HEADER;\n"
+				"FILE_DESCRIPTION((''),'2;1');\n"
+				"FILE_NAME('','',(''),(''),'','','');\n"
+				"FILE_SCHEMA(('IFC2X3'));\n"
+				"ENDSEC;\n"
+				"DATA;\n" + data_.str() +
+				"ENDSEC;\n"
+				"END-ISO-10303-21;\n";
+		}
+
+	private:
+		std::ostringstream data_;
+		int id_;
+	};
+
+	std::string ref(int id) {
+		return "#" + std::to_string(id);
+	}
+
+	std::string guid() {
+		return "'" + (const std::string&) IfcParse::IfcGlobalId() + "'";
+	}
+
+	std::string point(double x, double y, double z) {
+		std::ostringstream oss;
+		oss << "IFCCARTESIANPOINT((" << x << "," << y << "," << z << "))";
+		return oss.str();
+	}
+
+	std::string generate_model(int scale) {
+		model_writer m;
+		const int origin = m.add("IFCCARTESIANPOINT((0.,0.,0.))");
+		const int z = m.add("IFCDIRECTION((0.,0.,1.))");
+		const int x = m.add("IFCDIRECTION((1.,0.,0.))");
+		const int axes = m.add("IFCAXIS2PLACEMENT3D(" + ref(origin) + "," + ref(z) + "," + ref(x) + ")");
+		const int context = m.add("IFCGEOMETRICREPRESENTATIONCONTEXT($,'Model',3,1.E-05," + ref(axes) + ",$)");
+		const int unit = m.add("IFCSIUNIT(*,.LENGTHUNIT.,$,.METRE.)");
+		const int units = m.add("IFCUNITASSIGNMENT((" + ref(unit) + "))");
+		m.add("IFCPROJECT(" + guid() + ",$,'Project',$,$,$,$,(" + ref(context) + ")," + ref(units) + ")");
+
+		// Places the local placement of a product at (px, py, 0), relative to relative_to if nonzero
+		auto placement = [&](double px, double py, int relative_to) {
+			const int p = m.add(point(px, py, 0.));
+			const int a = m.add("IFCAXIS2PLACEMENT3D(" + ref(p) + "," + ref(z) + "," + ref(x) + ")");
+			return m.add("IFCLOCALPLACEMENT(" + (relative_to ? ref(relative_to) : "$") + "," + ref(a) + ")");
+		};
+		// A representation of a single item
+		auto shape = [&](int item, const char* type) {
+			const int r = m.add("IFCSHAPEREPRESENTATION(" + ref(context) + ",'Body','" + type + "',(" + ref(item) + "))");
+			return m.add("IFCPRODUCTDEFINITIONSHAPE($,$,(" + ref(r) + "))");
+		};
+		// An extrusion of a width by thickness rectangle centered at (cx, cy, cz)
+		auto box = [&](double width, double thickness, double height, double cx, double cy, double cz) {
+			const int c = m.add("IFCCARTESIANPOINT((0.,0.))");
+			const int a2 = m.add("IFCAXIS2PLACEMENT2D(" + ref(c) + ",$)");
+			std::ostringstream profile;
+			profile << "IFCRECTANGLEPROFILEDEF(.AREA.,$," << ref(a2) << "," << width << "," << thickness << ")";
+			const int pr = m.add(profile.str());
+			const int p = m.add(point(cx, cy, cz - height / 2.));
+			const int a = m.add("IFCAXIS2PLACEMENT3D(" + ref(p) + "," + ref(z) + "," + ref(x) + ")");
+			std::ostringstream extrusion;
+			extrusion << "IFCEXTRUDEDAREASOLID(" << ref(pr) << "," << ref(a) << "," << ref(z) << "," << height << ")";
+			return m.add(extrusion.str());
+		};
+
+		// Small extrusions, each with its own representation
+		for (int i = 0; i < 100 * scale; ++i) {
+			const int pl = placement((i % 100) * 1., (i / 100) * 1. + 10., 0);
+			m.add("IFCBUILDINGELEMENTPROXY(" + guid() + ",$,$,$,$," + ref(pl) + "," + ref(shape(box(0.5, 0.5, 0.5, 0., 0., 0.25), "SweptSolid")) + ",$,$)");
+		}
+
+		// A wall with an opening through it every meter
+		const int num_openings = 10 * scale;
+		const int wall_placement = placement(0., 0., 0);
+		const int wall = m.add("IFCWALL(" + guid() + ",$,$,$,$," + ref(wall_placement) + "," + ref(shape(box(num_openings + 1., 0.2, 3., (num_openings + 1.) / 2., 0., 1.5), "SweptSolid")) + ",$)");
+		for (int i = 0; i < num_openings; ++i) {
+			const int pl = placement(i + 1., 0., wall_placement);
+			const int opening = m.add("IFCOPENINGELEMENT(" + guid() + ",$,$,$,$," + ref(pl) + "," + ref(shape(box(0.5, 0.4, 1., 0., 0., 1.5), "SweptSolid")) + ",$)");
+			m.add("IFCRELVOIDSELEMENT(" + guid() + ",$,$,$," + ref(wall) + "," + ref(opening) + ")");
+		}
+
+		// A cube of k by k square faces per side
+		const int k = (std::max)(1, (int) std::sqrt(20. * scale));
+		std::vector<std::string> faces;
+		for (int side = 0; side < 6; ++side) {
+			const int axis = side / 2;
+			const double level = side % 2 ? (double) k : 0.;
+			for (int i = 0; i < k; ++i) {
+				for (int j = 0; j < k; ++j) {
+					// Corners in the order (i, j), (i + 1, j), (i + 1, j + 1), (i, j + 1), reversed on the lower sides so that the faces point outward
+					const int corners[4][2] = { { i, j }, { i + 1, j }, { i + 1, j + 1 }, { i, j + 1 } };
+					std::string loop;
+					for (int c = 0; c < 4; ++c) {
+						const int* uv = corners[side % 2 ? c : 3 - c];
+						double xyz[3];
+						xyz[axis] = level;
+						xyz[(axis + 1) % 3] = uv[0];
+						xyz[(axis + 2) % 3] = uv[1];
+						loop += (c ? "," : "") + ref(m.add(point(xyz[0], xyz[1], xyz[2] - 2. * k)));
+					}
+					const int polyloop = m.add("IFCPOLYLOOP((" + loop + "))");
+					const int bound = m.add("IFCFACEOUTERBOUND(" + ref(polyloop) + ",.T.)");
+					faces.push_back(ref(m.add("IFCFACE((" + ref(bound) + "))")));
+				}
+			}
+		}
+		std::string face_list;
+		for (auto& f : faces) {
+			face_list += (face_list.empty() ? "" : ",") + f;
+		}
+		const int shell = m.add("IFCCLOSEDSHELL((" + face_list + "))");
+		const int brep = m.add("IFCFACETEDBREP(" + ref(shell) + ")");
+		m.add("IFCBUILDINGELEMENTPROXY(" + guid() + ",$,$,$,$," + ref(placement(0., 0., 0)) + "," + ref(shape(brep, "Brep")) + ",$,$)");
+
+		return m.str();
+	}
+
+	double seconds_since(const std::chrono::steady_clock::time_point& start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Converts file, returns the ids of the emitted elements in the order emitted
+	std::vector<int> convert(IfcParse::IfcFile& file, int num_threads, bool cost_ordered, bool ordered_output, double& seconds) {
+		std::vector<int> ids;
+
+		Settings settings;
+		settings.get<settings::NoCostOrdering>().value = !cost_ordered;
+		settings.get<settings::OrderedOutput>().value = ordered_output;
+
+		auto start = std::chrono::steady_clock::now();
+		{
+			IfcGeom::Iterator iterator(settings, &file, {}, num_threads);
+			if (iterator.initialize()) {
+				do {
+					ids.push_back(iterator.get()->id());
+				} while (iterator.next());
+			}
+		}
+		seconds = seconds_since(start);
+
+		return ids;
+	}
+}
+
+int main(int argc, char** argv) {
+	const int scale = argc > 1 ? std::atoi(argv[1]) : 20;
+	const int num_threads = (std::max)(2, (int) std::thread::hardware_concurrency());
+
+	auto file = parse_model(generate_model(scale));
+	if (!check(file->good(), "the model is parsed")) {
+		return exit_status();
+	}
+
+	double serial, discovery_order, cost_order, ordered;
+	const auto serial_ids = convert(*file, 1, true, false, serial);
+	const auto discovery_ids = convert(*file, num_threads, false, false, discovery_order);
+	const auto cost_ids = convert(*file, num_threads, true, false, cost_order);
+	const auto ordered_ids = convert(*file, num_threads, true, true, ordered);
+
+	std::cout << serial_ids.size() << " elements, " << num_threads << " threads" << std::endl;
+	std::cout << "1 thread            " << serial << "s" << std::endl;
+	std::cout << "discovery order     " << discovery_order << "s" << std::endl;
+	std::cout << "cost order          " << cost_order << "s" << std::endl;
+	std::cout << "cost order, ordered " << ordered << "s" << std::endl;
+
+	auto sorted = [](std::vector<int> ids) {
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	};
+	check(!serial_ids.empty(), "the model is converted");
+	check(sorted(discovery_ids) == sorted(serial_ids), "discovery order emits the elements of a single thread");
+	check(sorted(cost_ids) == sorted(serial_ids), "cost order emits the elements of a single thread");
+	check(ordered_ids == serial_ids, "ordered-output emits the elements in the order of a single thread");
+
+	return exit_status();
+}
@@ -0,0 +1,122 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Compares welding the vertices of a dense triangulation in a std::map keyed   *
+ * on (item, material, x, y, z), which is how Triangulation::addVertex() used   *
+ * to weld, with Triangulation::addVertex() and addVertices(). Every vertex is  *
+ * added twice, as the faces of a shape emit the nodes on their shared edges    *
+ * once per face. Takes the number of grid nodes per side as the argument.      *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/IfcGeomRepresentation.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <tuple>
+
+using IfcGeom::Representation::Triangulation;
+
+namespace {
+	double seconds_since(const std::chrono::steady_clock::time_point& start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv) {
+	const int nodes_per_side = argc > 1 ? std::atoi(argv[1]) : 700;
+	const int num_layers = 4;
+
+	// Four grids of nodes 1 cm apart, every node occurring twice in a row
+	std::vector<double> xyz;
+	xyz.reserve((size_t) num_layers * nodes_per_side * nodes_per_side * 6);
+	for (int k = 0; k < num_layers; ++k) {
+		for (int i = 0; i < nodes_per_side; ++i) {
+			for (int j = 0; j < nodes_per_side; ++j) {
+				for (int n = 0; n < 2; ++n) {
+					xyz.push_back(i * 0.01);
+					xyz.push_back(j * 0.01);
+					xyz.push_back(k * 0.5);
+				}
+			}
+		}
+	}
+	const size_t num_inputs = xyz.size() / 3;
+
+	ifcopenshell::geometry::Settings settings;
+	settings.get<ifcopenshell::geometry::settings::WeldVertices>().value = true;
+
+	auto start = std::chrono::steady_clock::now();
+	std::map<std::tuple<int, int, double, double, double>, int> welds;
+	std::vector<int> map_indices(num_inputs);
+	for (size_t i = 0; i < num_inputs; ++i) {
+		auto key = std::make_tuple(0, 0, xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]);
+		auto it = welds.find(key);
+		if (it == welds.end()) {
+			it = welds.insert({ key, (int) welds.size() }).first;
+		}
+		map_indices[i] = it->second;
+	}
+	const double map_time = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	std::unique_ptr<Triangulation> single(Triangulation::empty(settings));
+	std::vector<int> single_indices(num_inputs);
+	for (size_t i = 0; i < num_inputs; ++i) {
+		single_indices[i] = single->addVertex(0, 0, xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]);
+	}
+	const double single_time = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	std::unique_ptr<Triangulation> batch(Triangulation::empty(settings));
+	std::vector<int> batch_indices;
+	batch->addVertices(0, 0, xyz, batch_indices);
+	const double batch_time = seconds_since(start);
+
+	// Every other node moved by less than the tolerance
+	settings.get<ifcopenshell::geometry::settings::WeldTolerance>().value = 0.001;
+	std::vector<double> jittered = xyz;
+	for (size_t i = 0; i < jittered.size(); i += 6) {
+		jittered[i] += 0.0004;
+	}
+	start = std::chrono::steady_clock::now();
+	std::unique_ptr<Triangulation> tolerant(Triangulation::empty(settings));
+	std::vector<int> tolerant_indices;
+	tolerant->addVertices(0, 0, jittered, tolerant_indices);
+	const double tolerant_time = seconds_since(start);
+
+	std::cout << num_inputs << " vertices, " << welds.size() << " unique" << std::endl;
+	std::cout << "std::map            " << map_time << "s" << std::endl;
+	std::cout << "addVertex()         " << single_time << "s" << std::endl;
+	std::cout << "addVertices()       " << batch_time << "s" << std::endl;
+	std::cout << "addVertices() 1 mm  " << tolerant_time << "s" << std::endl;
+
+	check(single_indices == map_indices, "addVertex() welds like std::map");
+	check(batch_indices == map_indices, "addVertices() welds like std::map");
+	check(tolerant->verts().size() == welds.size() * 3, "addVertices() within 1 mm welds the moved nodes into the unique nodes");
+
+	return exit_status();
+}
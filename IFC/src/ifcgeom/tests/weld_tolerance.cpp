@@ -0,0 +1,117 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Checks welding vertices within the weld-tolerance setting. Vertices are      *
+ * hashed on a grid of cells twice the tolerance wide and a lookup visits the   *
+ * cell of the vertex and the nearest neighbouring cell along every axis, so    *
+ * the cases below place vertices on either side of cell boundaries.           *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "check.h"
+
+#include "../../ifcgeom/IfcGeomRepresentation.h"
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+
+using IfcGeom::Representation::Triangulation;
+
+namespace {
+	std::unique_ptr<Triangulation> triangulation(double tolerance) {
+		ifcopenshell::geometry::Settings settings;
+		settings.get<ifcopenshell::geometry::settings::WeldVertices>().value = true;
+		settings.get<ifcopenshell::geometry::settings::WeldTolerance>().value = tolerance;
+		return std::unique_ptr<Triangulation>(Triangulation::empty(settings));
+	}
+
+	// Whether the two vertices are welded into one when added to an empty triangulation
+	bool welded(double tolerance, double ax, double ay, double az, double bx, double by, double bz, int b_item_id = 0) {
+		auto t = triangulation(tolerance);
+		return t->addVertex(0, 0, ax, ay, az) == t->addVertex(b_item_id, 0, bx, by, bz);
+	}
+
+	double distance(const std::vector<double>& a, size_t i, const std::vector<double>& b, size_t j) {
+		const double dx = a[3 * i] - b[3 * j], dy = a[3 * i + 1] - b[3 * j + 1], dz = a[3 * i + 2] - b[3 * j + 2];
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+int main() {
+	const double tolerance = 0.001;
+
+	// Cells are 2 mm wide, the boundary between cell 0 and 1 is at x = 2 mm
+	check(welded(tolerance, 0.0015, 0., 0., 0.0016, 0., 0.), "within the tolerance in the same cell");
+	check(welded(tolerance, 0.0019, 0., 0., 0.0021, 0., 0.), "within the tolerance across the upper cell boundary");
+	check(welded(tolerance, 0.0021, 0., 0., 0.0019, 0., 0.), "within the tolerance across the lower cell boundary");
+	check(welded(tolerance, -0.0003, 0., 0., 0.0003, 0., 0.), "within the tolerance across zero");
+	check(welded(tolerance, 0.0018, 0.0018, 0.0018, 0.0022, 0.0022, 0.0022), "within the tolerance across the boundaries along all axes");
+	check(!welded(tolerance, 0.0015, 0., 0., 0.0026, 0., 0.), "beyond the tolerance in a neighbouring cell");
+	check(!welded(tolerance, 0.0015, 0.0015, 0.0015, 0.0022, 0.0022, 0.0022), "within the tolerance along every axis but beyond it in distance");
+	check(!welded(tolerance, 0.0015, 0., 0., 0.0016, 0., 0., 1), "within the tolerance of a different item");
+
+	// Without a tolerance only identical coordinates are welded
+	check(welded(0., 0., 1., 2., -0., 1., 2.), "negative zero with zero");
+	check(!welded(0., 1., 1., 2., std::nextafter(1., 2.), 1., 2.), "adjacent doubles without a tolerance");
+
+	// For random vertices on a grid with a spacing close to the tolerance, every
+	// vertex must be welded to a vertex within the tolerance, and a vertex must
+	// only be added when there is no earlier vertex within the tolerance.
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<int> grid(0, 20);
+	std::uniform_real_distribution<double> jitter(-0.0004, 0.0004);
+	std::vector<double> xyz;
+	for (int i = 0; i < 3000; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			xyz.push_back(grid(generator) * 0.0015 + jitter(generator));
+		}
+	}
+
+	auto t = triangulation(tolerance);
+	std::vector<int> indices;
+	t->addVertices(0, 0, xyz, indices);
+	const auto& verts = t->verts();
+
+	bool all_within_tolerance = true;
+	for (size_t i = 0; i < indices.size(); ++i) {
+		all_within_tolerance = all_within_tolerance && distance(xyz, i, verts, indices[i]) <= tolerance;
+	}
+	check(all_within_tolerance, "random vertices welded within the tolerance");
+
+	bool none_missed = true;
+	for (size_t i = 0; i < verts.size() / 3; ++i) {
+		for (size_t j = 0; j < i; ++j) {
+			none_missed = none_missed && distance(verts, i, verts, j) > tolerance;
+		}
+	}
+	check(none_missed, "no random vertex added while another is within the tolerance");
+
+	auto u = triangulation(tolerance);
+	bool same_as_single = true;
+	for (size_t i = 0; i < indices.size(); ++i) {
+		same_as_single = same_as_single && u->addVertex(0, 0, xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]) == indices[i];
+	}
+	check(same_as_single, "addVertices() welds like addVertex()");
+
+	return exit_status();
+}
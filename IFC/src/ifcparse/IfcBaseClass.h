@@ -104,8 +104,14 @@ public:
         , data_(std::move(data))
     {}
 
-    const IfcEntityInstanceData& data() const { return data_; }
-    IfcEntityInstanceData& data() { return data_; }
+    const IfcEntityInstanceData& data() const {
+        data_.ensure_parsed();
+        return data_;
+    }
+    IfcEntityInstanceData& data() {
+        data_.ensure_parsed();
+        return data_;
+    }
 
     virtual const IfcParse::declaration& declaration() const = 0;
 
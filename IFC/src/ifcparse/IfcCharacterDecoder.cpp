@@ -261,6 +261,17 @@ void IfcCharacterDecoder::skip() {
     char current_char;
     unsigned int hex_count = 0;
     while ((current_char = stream_->Peek()) != 0) {
+        if (parse_state == 0U && current_char != '\'' && current_char != '\\') {
+            // Outside of escape sequences, plain characters can be skipped at once
+            const unsigned int run = stream_->string_run_at(stream_->Tell());
+            if (run != 0U) {
+                stream_->Skip(run);
+                if (stream_->eof) {
+                    break;
+                }
+                continue;
+            }
+        }
         if (EXPECTS_CHARACTER(parse_state)) {
             parse_state = 0;
         } else if (current_char == '\'' && (parse_state == 0U)) {
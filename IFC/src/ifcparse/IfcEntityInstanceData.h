@@ -30,6 +30,12 @@
 #include <boost/logic/tribool.hpp>
 #include <boost/dynamic_bitset.hpp>
 
+#include <atomic>
+
+namespace IfcParse {
+    class IfcFile;
+}
+
 class EnumerationReference {
 private:
     const IfcParse::enumeration_type* enumeration_;
@@ -160,6 +166,15 @@ struct AttributeValue {
 };
 
 class IFC_PARSE_API IfcEntityInstanceData {
+  private:
+      friend class IfcParse::IfcFile;
+
+      // Set to the owning instance while its attributes have not been parsed
+      // yet, which is the case for files opened in lazy loading mode.
+      mutable std::atomic<IfcUtil::IfcBaseClass*> unparsed_{nullptr};
+
+      void parse_deferred_() const;
+
   public:
       storage_t storage_;
 
@@ -168,18 +183,28 @@ class IFC_PARSE_API IfcEntityInstanceData {
       {}
 
       IfcEntityInstanceData(IfcEntityInstanceData&& other) noexcept
-          : storage_(std::move(other.storage_))
+          : unparsed_(other.unparsed_.exchange(nullptr))
+          , storage_(std::move(other.storage_))
       {}
 
       IfcEntityInstanceData(const IfcEntityInstanceData& data);
 
       IfcEntityInstanceData& operator=(IfcEntityInstanceData&& other) {
           if (this != &other) {
+              unparsed_ = other.unparsed_.exchange(nullptr);
               storage_ = std::move(other.storage_);
           }
           return *this;
       }
 
+    /// Parses the attributes from the file when this is the data of an instance
+    /// of which the attributes have not been read yet
+    void ensure_parsed() const {
+        if (unparsed_.load(std::memory_order_acquire) != nullptr) {
+            parse_deferred_();
+        }
+    }
+
     AttributeValue get_attribute_value(size_t index) const;
 
     /*
@@ -190,10 +215,14 @@ class IFC_PARSE_API IfcEntityInstanceData {
     */
 
     size_t size() const {
+        ensure_parsed();
         return storage_.size();
     }
 
     void toString(std::ostream&, bool upper = false, const IfcParse::entity* ent = nullptr) const;
+
+    /// Appends the SPF representation of the attributes to out
+    void toString(std::string& out, bool upper = false, const IfcParse::entity* ent = nullptr) const;
 };
 
 #endif
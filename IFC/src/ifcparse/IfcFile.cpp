@@ -60,15 +60,15 @@ namespace {
         } else if (t.type == IfcParse::Token_BOOL) {
             fn(IfcParse::TokenFunc::asBool(t));
         } else if (t.type == IfcParse::Token_ENUMERATION) {
-            auto& s = IfcParse::TokenFunc::asStringRef(t);
+            auto s = IfcParse::TokenFunc::asStringView(t);
             if (decl && decl->as_enumeration_type()) {
                 try {
                     fn(EnumerationReference(decl->as_enumeration_type(), decl->as_enumeration_type()->lookup_enum_offset(s)));
                 } catch (IfcParse::IfcException& e) {
-                    Logger::Error("An enumeration literal '" + s + "' is not valid for type '" + decl->name() + "' at offset " + std::to_string(t.startPos));
+                    Logger::Error("An enumeration literal '" + std::string(s) + "' is not valid for type '" + decl->name() + "' at offset " + std::to_string(t.startPos));
                 }
             } else {
-                Logger::Error("An enumeration literal '" + s + "' is not expected at attribute index '" + std::to_string(attribute_id) + "' at offset " + std::to_string(t.startPos));
+                Logger::Error("An enumeration literal '" + std::string(s) + "' is not expected at attribute index '" + std::to_string(attribute_id) + "' at offset " + std::to_string(t.startPos));
             }
         } else if (t.type == IfcParse::Token_FLOAT) {
             fn(IfcParse::TokenFunc::asFloat(t));
@@ -77,7 +77,7 @@ namespace {
         } else if (t.type == IfcParse::Token_INT) {
             fn(IfcParse::TokenFunc::asInt(t));
         } else if (t.type == IfcParse::Token_STRING) {
-            fn(IfcParse::TokenFunc::asStringRef(t));
+            fn(std::string(IfcParse::TokenFunc::asStringView(t)));
         } else if (t.type == IfcParse::Token_OPERATOR && t.value_char == '*') {
             // This is only in place for the validator
             fn(Derived{});
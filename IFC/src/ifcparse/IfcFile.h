@@ -24,6 +24,7 @@
 #include "IfcParse.h"
 #include "IfcSchema.h"
 #include "IfcSpfHeader.h"
+#include "inverse_index.h"
 
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/random_access_index.hpp>
@@ -31,8 +32,13 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/variant.hpp>
+#include <functional>
+#include <atomic>
 #include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace IfcParse {
 
@@ -67,7 +73,7 @@ class IFC_PARSE_API file_open_status {
 };
 
 typedef boost::variant<int, IfcUtil::IfcBaseClass*> reference_or_simple_type;
-typedef std::list<std::pair<MutableAttributeValue, boost::variant<reference_or_simple_type, std::vector<reference_or_simple_type>, std::vector<std::vector<reference_or_simple_type>>>>> unresolved_references;
+typedef std::vector<std::pair<MutableAttributeValue, boost::variant<reference_or_simple_type, std::vector<reference_or_simple_type>, std::vector<std::vector<reference_or_simple_type>>>>> unresolved_references;
 
 struct parse_context {
     std::list<
@@ -153,7 +159,26 @@ class IFC_PARSE_API IfcFile {
     static bool guid_map() { return guid_map_; }
     static void guid_map(bool b) { guid_map_ = b; }
 
+    /// When enabled, the attribute storage of instances parsed from a file is
+    /// allocated from an arena owned by the file and released in one go when
+    /// the file is deleted. Instance data must then not outlive the file.
+    static bool arena_allocation_;
+    static bool arena_allocation() { return arena_allocation_; }
+    static void arena_allocation(bool b) { arena_allocation_ = b; }
+
+    /// When enabled, opening a file only records the name, type and offset of
+    /// every instance together with the references it makes. The attributes of
+    /// an instance are parsed on first access, which requires the file to keep
+    /// its stream open. A stream passed by pointer must outlive the file. The
+    /// scan is always serial, parse_threads is ignored in this mode.
+    static bool lazy_loading_;
+    static bool lazy_loading() { return lazy_loading_; }
+    static void lazy_loading(bool b) { lazy_loading_ = b; }
+
   private:
+    friend class ::IfcEntityInstanceData;
+    friend class IfcSnapshot;
+
     typedef std::map<uint32_t, IfcUtil::IfcBaseClass*> entity_entity_map_t;
 
     file_open_status good_ = file_open_status::SUCCESS;
@@ -169,20 +194,64 @@ class IFC_PARSE_API IfcFile {
     // entities_by_type_t bytype_;
     entities_by_type_t bytype_excl_;
     // entities_by_ref_t byref_;
-    entities_by_ref_t byref_excl_;
+    inverse_index byref_excl_;
     entity_by_guid_t byguid_;
     entity_entity_map_t entity_file_map_;
 
     unsigned int MaxId;
 
+    unsigned int parse_threads_ = 1;
+
+    // Set by the parallel parser on the chunks that follow a chunk with an
+    // error, which are discarded, so that these stop scanning early
+    std::atomic<bool> scan_cancelled_{false};
+
+    ::impl::arena arena_;
+
+    // Stream created by the file itself, only retained when opened in lazy loading mode
+    std::unique_ptr<IfcParse::IfcSpfStream> owned_stream_;
+
+    // Whether the instances were scanned without parsing their attributes
+    bool deferred_ = false;
+    // (name, offset of the entity type keyword) of the instances, sorted by name
+    std::vector<std::pair<unsigned int, unsigned int>> deferred_offsets_;
+    std::mutex deferred_mutex_;
+
     IfcSpfHeader _header;
 
     void setDefaultHeaderValues();
 
     void initialize_(IfcParse::IfcSpfStream* stream);
 
+    /// Tokenizes the instances from the current position of the lexer up to the end of the stream
+    void scan_(bool report_progress);
+
+    /// Splits the data section on instance boundaries and scans the chunks on separate
+    /// threads into temporary files, of which the entity maps are merged into this file.
+    void scan_parallel_();
+
+    /// Records the instances and their references from the current position of the
+    /// lexer up to the end of the stream without parsing the attribute values.
+    void scan_deferred_();
+
+    /// Parses the attributes of an instance scanned by scan_deferred_()
+    void parse_deferred_(IfcUtil::IfcBaseClass* instance, IfcEntityInstanceData& data);
+
+    /// Replaces the instance names in references_to_resolve by the instances they
+    /// refer to in the attribute storage returned for the referencing instance name,
+    /// references for which no storage is returned are skipped. For a complete
+    /// file the references are resolved on up to parse_threads threads.
+    void resolve_references_(const std::function<storage_t*(unsigned int)>& storage_of);
+
     void build_inverses_(IfcUtil::IfcBaseClass*);
 
+    /// Merges pending additions and removals into the flat inverse index. Only
+    /// called when the file is modified: lookups, which may run concurrently,
+    /// read the pending delta through inverse_index::for_each() instead.
+    void compact_inverses_if_needed_();
+
+    IfcUtil::IfcBaseClass* resolve_inverse_(const inverse_index::reference& ref);
+
     typedef boost::multi_index_container<
         int,
         boost::multi_index::indexed_by<
@@ -198,14 +267,16 @@ class IFC_PARSE_API IfcFile {
     IfcParse::IfcSpfLexer* tokens;
     IfcParse::IfcSpfStream* stream;
 
+    /// When parse_threads is larger than one, the DATA section is split into chunks
+    /// that are parsed concurrently. The resulting file is identical to the serial path.
 #ifdef USE_MMAP
-    IfcFile(const std::string& path, bool mmap = false);
+    IfcFile(const std::string& path, bool mmap = false, unsigned int parse_threads = 1);
 #else
-    IfcFile(const std::string& path);
+    IfcFile(const std::string& path, unsigned int parse_threads = 1);
 #endif
-    IfcFile(std::istream& stream, int length);
-    IfcFile(void* data, int length);
-    IfcFile(IfcParse::IfcSpfStream* stream);
+    IfcFile(std::istream& stream, int length, unsigned int parse_threads = 1);
+    IfcFile(void* data, int length, unsigned int parse_threads = 1);
+    IfcFile(IfcParse::IfcSpfStream* stream, unsigned int parse_threads = 1);
     IfcFile(const IfcParse::schema_definition* schema = IfcParse::schema_by_name("IFC4"));
 
     /// Deleting the file will also delete all new instances that were added to the file (via memory allocation)
@@ -327,6 +398,12 @@ class IFC_PARSE_API IfcFile {
 
     static std::string createTimestamp() ;
 
+    /// Writes the file in SPF to out, in the order of the instance names. The
+    /// instances are formatted in chunks on up to threads threads, 0 uses the
+    /// number of hardware threads, and each chunk is written to out at once.
+    /// Writing is serial unless more threads are requested.
+    void write(std::ostream& out, unsigned int threads = 1) const;
+
     void load(unsigned entity_instance_name, const IfcParse::entity* entity, parse_context&, int attribute_index = -1);
     void try_read_semicolon() const;
 
@@ -30,21 +30,38 @@
 #include "utils.h"
 
 #include <algorithm>
+#include <atomic>
 #include <boost/algorithm/string.hpp>
 #include <boost/circular_buffer.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/variant.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
+#include <charconv>
+#include <condition_variable>
 #include <ctime>
 #include <set>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
 #include <iomanip>
+#include <thread>
 
 #ifdef USE_MMAP
 #include <boost/filesystem/path.hpp>
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IFCPARSE_SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IFCPARSE_SCAN_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define PERMISSIVE_FLOAT
 
 using namespace IfcParse;
@@ -103,6 +120,76 @@ void init_locale() {
 
 #endif
 
+namespace {
+
+inline unsigned int count_trailing_zeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+// Returns the number of characters in [begin, end) before the first occurrence
+// of any of the characters Cs. Characters are classified 32 (AVX2) or 16 (SSE2)
+// at a time into a bitmask, the tail and other architectures use a scalar loop.
+template <char... Cs>
+unsigned int find_first_of(const char* begin, const char* end) {
+    const char* it = begin;
+#if defined(IFCPARSE_SCAN_AVX2)
+    while (end - it >= 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+        __m256i matches = _mm256_setzero_si256();
+        ((matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(Cs)))), ...);
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(matches);
+        if (mask != 0U) {
+            return (unsigned int)(it - begin) + count_trailing_zeros(mask);
+        }
+        it += 32;
+    }
+#elif defined(IFCPARSE_SCAN_SSE2)
+    while (end - it >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        __m128i matches = _mm_setzero_si128();
+        ((matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(Cs)))), ...);
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(matches);
+        if (mask != 0U) {
+            return (unsigned int)(it - begin) + count_trailing_zeros(mask);
+        }
+        it += 16;
+    }
+#endif
+    while (it != end && !((*it == Cs) || ...)) {
+        ++it;
+    }
+    return (unsigned int)(it - begin);
+}
+
+// Returns whether [begin, end) consists of 7-bit characters only, using the
+// sign bits of 16 characters at a time when SSE2 or AVX2 is available.
+inline bool is_ascii(const char* begin, const char* end) {
+    const char* it = begin;
+#if defined(IFCPARSE_SCAN_SSE2) || defined(IFCPARSE_SCAN_AVX2)
+    while (end - it >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        if (_mm_movemask_epi8(chunk) != 0) {
+            return false;
+        }
+        it += 16;
+    }
+#endif
+    for (; it != end; ++it) {
+        if (static_cast<unsigned char>(*it) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 //
 // Opens the file and gets the filesize
 //
@@ -199,11 +286,25 @@ IfcSpfStream::IfcSpfStream(void* data, int length)
     len_ = length;
 }
 
+IfcSpfStream::IfcSpfStream(const IfcSpfStream& other, unsigned int begin, unsigned int end)
+    : stream_(0),
+      buffer_(other.buffer_),
+      ptr_(begin),
+      len_(end),
+      owns_buffer_(false) {
+    eof = begin >= end;
+    size = end;
+    valid = other.valid;
+}
+
 IfcSpfStream::~IfcSpfStream() {
     Close();
 }
 
 void IfcSpfStream::Close() {
+    if (!owns_buffer_) {
+        return;
+    }
 #ifdef USE_MMAP
     if (mfs.is_open()) {
         mfs.close();
@@ -252,15 +353,28 @@ unsigned int IfcSpfStream::Tell() const {
 // Increments cursor and reads new chunk if necessary
 //
 void IfcSpfStream::Inc() {
-    if (++ptr_ == len_) {
-        eof = true;
-        return;
-    }
-    const char current = IfcSpfStream::Peek();
-    if (current == '\n' || current == '\r') {
-        // NB this is recursive. It might as well be a loop.
-        IfcSpfStream::Inc();
-    }
+    do {
+        if (++ptr_ == len_) {
+            eof = true;
+            return;
+        }
+    } while (buffer_[ptr_] == '\n' || buffer_[ptr_] == '\r');
+}
+
+//
+// Moves the cursor over a run of characters without line breaks
+//
+void IfcSpfStream::Skip(unsigned int n) {
+    ptr_ += n - 1;
+    Inc();
+}
+
+unsigned int IfcSpfStream::token_run_at(unsigned int offset) const {
+    return find_first_of<'(', ')', '=', ',', ';', '/', '\'', '\n', '\r'>(buffer_ + offset, buffer_ + len_);
+}
+
+unsigned int IfcSpfStream::string_run_at(unsigned int offset) const {
+    return find_first_of<'\'', '\\', '\n', '\r'>(buffer_ + offset, buffer_ + len_);
 }
 
 IfcSpfLexer::IfcSpfLexer(IfcParse::IfcSpfStream* stream_, IfcParse::IfcFile* file_) {
@@ -363,6 +477,13 @@ Token IfcSpfLexer::Next() {
         // If a string is encountered defer processing to the IfcCharacterDecoder
         if (character == '\'') {
             decoder_->skip();
+        } else if (!stream->eof) {
+            // Consume the remainder of the token up to the next delimiter at once
+            const unsigned int run = stream->token_run_at(stream->Tell());
+            if (run != 0U) {
+                stream->Skip(run);
+                len += run;
+            }
         }
     }
     Token t;
@@ -380,13 +501,11 @@ bool IfcSpfStream::is_eof_at(unsigned int local_ptr) const {
 }
 
 void IfcSpfStream::increment_at(unsigned int& local_ptr) {
-    if (++local_ptr == len_) {
-        return;
-    }
-    const char current = IfcSpfStream::peek_at(local_ptr);
-    if (current == '\n' || current == '\r') {
-        IfcSpfStream::increment_at(local_ptr);
-    }
+    do {
+        if (++local_ptr == len_) {
+            return;
+        }
+    } while (buffer_[local_ptr] == '\n' || buffer_[local_ptr] == '\r');
 }
 
 char IfcSpfStream::peek_at(unsigned int local_ptr) {
@@ -422,21 +541,64 @@ void IfcSpfLexer::TokenString(unsigned int offset, std::string& buffer) {
             break;
         }
         buffer.push_back(character);
+        if (!stream->is_eof_at(offset)) {
+            const unsigned int run = stream->token_run_at(offset);
+            if (run != 0U) {
+                const char* begin = stream->Buffer() + offset;
+                for (const char* it = begin; it != begin + run; ++it) {
+                    if (*it != ' ' && *it != '\t') {
+                        buffer.push_back(*it);
+                    }
+                }
+                offset += run - 1;
+                stream->increment_at(offset);
+            }
+        }
+    }
+}
+
+bool IfcSpfLexer::TokenView(unsigned int offset, std::string_view& view) const {
+    if (stream->is_eof_at(offset)) {
+        return false;
+    }
+    const char* buffer = stream->Buffer();
+    if (stream->peek_at(offset) == '\'') {
+        // Only strings without escape sequences, line breaks and 8-bit characters
+        // are identical to their decoded value. Anything else is left to the decoder.
+        if (IfcCharacterDecoder::mode != IfcCharacterDecoder::UTF8) {
+            return false;
+        }
+        const unsigned int begin = offset + 1;
+        const unsigned int end = begin + stream->string_run_at(begin);
+        if (end >= stream->End() || buffer[end] != '\'' ||
+            (end + 1 < stream->End() && buffer[end + 1] == '\'') ||
+            !is_ascii(buffer + begin, buffer + end)) {
+            return false;
+        }
+        view = std::string_view(buffer + offset, end + 1 - offset);
+        return true;
     }
+    const unsigned int end = offset + stream->token_run_at(offset);
+    if (end == offset ||
+        (end < stream->End() && (buffer[end] == '\'' || buffer[end] == '\n' || buffer[end] == '\r')) ||
+        find_first_of<' ', '\t'>(buffer + offset, buffer + end) != end - offset) {
+        return false;
+    }
+    view = std::string_view(buffer + offset, end - offset);
+    return true;
 }
 
 //Note: according to STEP standard, there may be newlines in tokens
 inline void RemoveTokenSeparators(IfcSpfStream* stream, unsigned start, unsigned end, std::string& oDestination) {
-    oDestination.clear();
-    for (unsigned i = start; i < end; i++) {
-        char character = stream->Read(i);
-        if (character == ' ' ||
-            character == '\r' ||
-            character == '\n' ||
-            character == '\t') {
-            continue;
-        }
-        oDestination += character;
+    const char* begin = stream->Buffer() + start;
+    oDestination.assign(begin, end - start);
+    if (find_first_of<' ', '\r', '\n', '\t'>(begin, begin + (end - start)) != end - start) {
+        oDestination.erase(std::remove_if(oDestination.begin(), oDestination.end(), [](char character) {
+            return character == ' ' ||
+                   character == '\r' ||
+                   character == '\n' ||
+                   character == '\t';
+        }), oDestination.end());
     }
 }
 
@@ -638,6 +800,20 @@ const std::string& TokenFunc::asStringRef(const Token& token) {
     return str;
 }
 
+std::string_view TokenFunc::asStringView(const Token& token) {
+    std::string_view view;
+    if (token.type != Token_NONE && token.lexer->TokenView(token.startPos, view)) {
+        if (isString(token) || isEnumeration(token) || isBinary(token)) {
+            if (view.size() < 2) {
+                return asStringRef(token);
+            }
+            view = view.substr(1, view.size() - 2);
+        }
+        return view;
+    }
+    return asStringRef(token);
+}
+
 std::string TokenFunc::asString(const Token& token) {
     if (isString(token) || isEnumeration(token) || isBinary(token)) {
         return asStringRef(token);
@@ -646,12 +822,12 @@ std::string TokenFunc::asString(const Token& token) {
 }
 
 boost::dynamic_bitset<> TokenFunc::asBinary(const Token& token) {
-    const std::string& str = asStringRef(token);
+    const std::string_view str = asStringView(token);
     if (str.empty()) {
         throw IfcException("Token is not a valid binary sequence");
     }
 
-    std::string::const_iterator it = str.begin();
+    std::string_view::const_iterator it = str.begin();
     int n = *it - '0';
     if ((n < 0 || n > 3) || (str.size() == 1 && n != 0)) {
         throw IfcException("Token is not a valid binary sequence");
@@ -662,7 +838,7 @@ boost::dynamic_bitset<> TokenFunc::asBinary(const Token& token) {
     boost::dynamic_bitset<> bitset(i);
 
     for (; it != str.end(); ++it) {
-        const std::string::value_type& c = *it;
+        const char& c = *it;
         int value = (c < 'A') ? (c - '0') : (c - 'A' + 10);
         for (unsigned j = 0; j < 4; ++j) {
             if (i-- == 0) {
@@ -711,20 +887,21 @@ void IfcParse::IfcFile::load(unsigned entity_instance_name, const IfcParse::enti
             load(entity_instance_name, entity, context.push(), attribute_index == -1 ? (int) attribute_index_within_data : attribute_index);
         } else {
             return_value++;
-            if (TokenFunc::isIdentifier(next) && entity) {
+            // The references of deferred instances are registered by scan_deferred_()
+            if (TokenFunc::isIdentifier(next) && entity && !deferred_) {
                 register_inverse(entity_instance_name, entity, next, attribute_index == -1 ? attribute_index_within_data : attribute_index);
             }
 
             if (TokenFunc::isKeyword(next)) {
                 try {
-                    const auto* decl = schema_->declaration_by_name(TokenFunc::asStringRef(next));
+                    const auto* decl = schema_->declaration_by_name(TokenFunc::asStringView(next));
                     parse_context ps;
                     tokens->Next();
                     load(0, nullptr, ps, -1);
                     auto* simple_type_instance = schema_->instantiate(decl, ps.construct(-1, references_to_resolve, decl, boost::none));
                     //@todo decide addEntity(((IfcUtil::IfcBaseClass*)*entity));
                     context.push(simple_type_instance);
-                    simple_type_instance->file_ = this;
+                    simple_type_instance->file_ = tokens->file;
                 } catch (IfcException& e) {
                     Logger::Message(Logger::LOG_ERROR, e.what());
                     // #4070 We didn't actually capture an aggregate entry, undo length increment.
@@ -746,7 +923,7 @@ IfcEntityInstanceData IfcParse::read(unsigned int i, IfcFile* f) {
     if (!TokenFunc::isKeyword(datatype)) {
         throw IfcException("Unexpected token while parsing entity");
     }
-    const IfcParse::declaration* ty = f->schema()->declaration_by_name(TokenFunc::asStringRef(datatype));
+    const IfcParse::declaration* ty = f->schema()->declaration_by_name(TokenFunc::asStringView(datatype));
     parse_context pc;
     f->tokens->Next();
     f->load(i, ty->as_entity(), pc, -1);
@@ -764,217 +941,226 @@ void IfcParse::IfcFile::try_read_semicolon() const {
 void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* from_entity, Token t, int attribute_index) {
     // Assume a check on token type has already been performed
     const auto* e = from_entity;
-    byref_excl_[{t.value_int, e->index_in_schema(), attribute_index}].push_back(id_from);
+    byref_excl_.append(t.value_int, e->index_in_schema(), attribute_index, id_from);
 }
 
 void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* from_entity, IfcUtil::IfcBaseClass* inst, int attribute_index) {
     const auto* e = from_entity;
-    byref_excl_[{inst->id(), e->index_in_schema(), attribute_index}].push_back(id_from);
+    byref_excl_.add(inst->id(), e->index_in_schema(), attribute_index, id_from);
+    compact_inverses_if_needed_();
 }
 
 void IfcParse::IfcFile::unregister_inverse(unsigned id_from, const IfcParse::entity* from_entity, IfcUtil::IfcBaseClass* inst, int attribute_index) {
-    std::vector<int>& ids = byref_excl_[{inst->id(), from_entity->index_in_schema(), attribute_index}];
-    std::vector<int>::iterator iter = std::find(ids.begin(), ids.end(), id_from);
-    if (iter == ids.end()) {
-        // @todo inverses also need to be populated when multiple instances are added to a new file.
-        // throw IfcParse::IfcException("Instance not found among inverses");
-    } else {
-        ids.erase(iter);
+    // @todo inverses also need to be populated when multiple instances are added to a new file,
+    // a reference that is not found is silently ignored.
+    compact_inverses_if_needed_();
+    byref_excl_.remove(inst->id(), from_entity->index_in_schema(), attribute_index, id_from);
+    compact_inverses_if_needed_();
+}
+
+void IfcParse::IfcFile::compact_inverses_if_needed_() {
+    if (byref_excl_.needs_compaction()) {
+        byref_excl_.compact([this](int id) -> IfcUtil::IfcBaseClass* {
+            auto it = byid_.find(id);
+            return it == byid_.end() ? nullptr : it->second;
+        });
+    }
+}
+
+IfcUtil::IfcBaseClass* IfcParse::IfcFile::resolve_inverse_(const inverse_index::reference& ref) {
+    // While a batch of deletions is processed the index can still refer to
+    // instances that have already been deleted, so these are looked up by name.
+    if (ref.instance != nullptr && batch_deletion_ids_.empty()) {
+        return ref.instance;
     }
+    return instance_by_id(ref.id);
 }
 
 namespace {
+    void format_instance(std::string& data, const IfcUtil::IfcBaseClass* inst, bool upper);
+
+    void format_int(std::string& data, int i) {
+        char buffer[16];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), i);
+        data.append(buffer, result.ptr);
+    }
+
+    // The REAL token definition from the IFC SPF standard does not necessarily match
+    // the output of the C++ ostream formatting operation.
+    // REAL = [ SIGN ] DIGIT { DIGIT } "." { DIGIT } [ "E" [ SIGN ] DIGIT { DIGIT } ] .
+    void format_double(std::string& data, const double& d) {
+#ifdef __cpp_lib_to_chars
+        // Same as the %.15g the stream would use, without its locale and allocations
+        char buffer[32];
+        const char* end = std::to_chars(buffer, buffer + sizeof(buffer), d, std::chars_format::general, std::numeric_limits<double>::digits10).ptr;
+        const std::string_view str(buffer, end - buffer);
+#else
+        std::ostringstream oss;
+        oss.imbue(std::locale::classic());
+        oss << std::setprecision(std::numeric_limits<double>::digits10) << d;
+        const std::string str = oss.str();
+#endif
+        auto e = str.find('e');
+        if (e == std::string::npos) {
+            e = str.find('E');
+        }
+        const auto mantissa = str.substr(0, e);
+        data.append(mantissa.data(), mantissa.size());
+        if (mantissa.find('.') == std::string::npos) {
+            data += '.';
+        }
+        if (e != std::string::npos) {
+            data += 'E';
+            data.append(str.data() + e + 1, str.size() - e - 1);
+        }
+    }
+
+    void format_binary(std::string& data, const boost::dynamic_bitset<>& b) {
+        static const char hex_digits[] = "0123456789ABCDEF";
+        data += '"';
+        unsigned c = (unsigned)b.size();
+        unsigned n = (4 - (c % 4)) & 3;
+        data += hex_digits[n];
+        for (unsigned i = 0; i < c + n;) {
+            unsigned accum = 0;
+            for (int j = 0; j < 4; ++j, ++i) {
+                unsigned bit = i < n ? 0 : b.test(c - i + n - 1) ? 1
+                    : 0;
+                accum |= bit << (3 - j);
+            }
+            data += hex_digits[accum];
+        }
+        data += '"';
+    }
+
+    void format_string(std::string& data, const std::string& s) {
+        // Strings that only consist of printable ASCII characters are the common
+        // case and are written as is, without converting to UTF-32 in the encoder.
+        bool plain = true;
+        for (char c : s) {
+            if (c < 0x20 || c > 0x7e) {
+                plain = false;
+                break;
+            }
+        }
+        if (!plain) {
+            data += static_cast<std::string>(IfcCharacterEncoder(s));
+            return;
+        }
+        data += '\'';
+        for (char c : s) {
+            data += c;
+            if (c == '\\' || c == '\'') {
+                data += c;
+            }
+        }
+        data += '\'';
+    }
+
     class StringBuilderVisitor : public boost::static_visitor<void> {
     private:
         StringBuilderVisitor(const StringBuilderVisitor&);            //N/A
         StringBuilderVisitor& operator=(const StringBuilderVisitor&); //N/A
 
-        std::ostream& data_;
+        std::string& data_;
+        bool upper_;
+
+        void serialize(const int& i) { format_int(data_, i); }
+        void serialize(const double& i) { format_double(data_, i); }
+        void serialize(const std::string& i) { format_string(data_, i); }
+        void serialize(const boost::dynamic_bitset<>& i) { format_binary(data_, i); }
+
         template <typename T>
         void serialize(const std::vector<T>& i) {
-            data_ << "(";
+            data_ += '(';
             for (typename std::vector<T>::const_iterator it = i.begin(); it != i.end(); ++it) {
                 if (it != i.begin()) {
-                    data_ << ",";
+                    data_ += ',';
                 }
-                data_ << *it;
-            }
-            data_ << ")";
-        }
-        // The REAL token definition from the IFC SPF standard does not necessarily match
-        // the output of the C++ ostream formatting operation.
-        // REAL = [ SIGN ] DIGIT { DIGIT } "." { DIGIT } [ "E" [ SIGN ] DIGIT { DIGIT } ] .
-        static std::string format_double(const double& d) {
-            std::ostringstream oss;
-            oss.imbue(std::locale::classic());
-            oss << std::setprecision(std::numeric_limits<double>::digits10) << d;
-            const std::string str = oss.str();
-            oss.str("");
-            std::string::size_type e = str.find('e');
-            if (e == std::string::npos) {
-                e = str.find('E');
-            }
-            const std::string mantissa = str.substr(0, e);
-            oss << mantissa;
-            if (mantissa.find('.') == std::string::npos) {
-                oss << ".";
-            }
-            if (e != std::string::npos) {
-                oss << "E";
-                oss << str.substr(e + 1);
-            }
-            return oss.str();
-        }
-
-        static std::string format_binary(const boost::dynamic_bitset<>& b) {
-            std::ostringstream oss;
-            oss.imbue(std::locale::classic());
-            oss.put('"');
-            oss << std::uppercase << std::hex << std::setw(1);
-            unsigned c = (unsigned)b.size();
-            unsigned n = (4 - (c % 4)) & 3;
-            oss << n;
-            for (unsigned i = 0; i < c + n;) {
-                unsigned accum = 0;
-                for (int j = 0; j < 4; ++j, ++i) {
-                    unsigned bit = i < n ? 0 : b.test(c - i + n - 1) ? 1
-                        : 0;
-                    accum |= bit << (3 - j);
-                }
-                oss << accum;
+                serialize(*it);
             }
-            oss.put('"');
-            return oss.str();
+            data_ += ')';
         }
 
-        bool upper_;
-
     public:
-        StringBuilderVisitor(std::ostream& stream, bool upper = false)
-            : data_(stream),
+        StringBuilderVisitor(std::string& data, bool upper = false)
+            : data_(data),
             upper_(upper) {}
-        void operator()(const Blank& /*i*/) { data_ << "$"; }
-        void operator()(const Derived& /*i*/) { data_ << "*"; }
-        void operator()(const int& i) { data_ << i; }
-        void operator()(const bool& i) { data_ << (i ? ".T." : ".F."); }
-        void operator()(const boost::logic::tribool& i) { data_ << (i ? ".T." : (boost::logic::indeterminate(i) ? ".U." : ".F.")); }
-        void operator()(const double& i) { data_ << format_double(i); }
-        void operator()(const boost::dynamic_bitset<>& i) { data_ << format_binary(i); }
+        void operator()(const Blank& /*i*/) { data_ += '$'; }
+        void operator()(const Derived& /*i*/) { data_ += '*'; }
+        void operator()(const int& i) { format_int(data_, i); }
+        void operator()(const bool& i) { data_ += (i ? ".T." : ".F."); }
+        void operator()(const boost::logic::tribool& i) { data_ += (i ? ".T." : (boost::logic::indeterminate(i) ? ".U." : ".F.")); }
+        void operator()(const double& i) { format_double(data_, i); }
+        void operator()(const boost::dynamic_bitset<>& i) { format_binary(data_, i); }
         void operator()(const std::string& i) {
-            std::string s = i;
             if (upper_) {
-                data_ << static_cast<std::string>(IfcCharacterEncoder(s));
+                format_string(data_, i);
             } else {
-                data_ << '\'' << s << '\'';
+                data_ += '\'';
+                data_ += i;
+                data_ += '\'';
             }
         }
-        void operator()(const std::vector<int>& i);
-        void operator()(const std::vector<double>& i);
-        void operator()(const std::vector<std::string>& i);
-        void operator()(const std::vector<boost::dynamic_bitset<>>& i);
+        void operator()(const std::vector<int>& i) { serialize(i); }
+        void operator()(const std::vector<double>& i) { serialize(i); }
+        void operator()(const std::vector<std::string>& i) { serialize(i); }
+        void operator()(const std::vector<boost::dynamic_bitset<>>& i) { serialize(i); }
         void operator()(const EnumerationReference& i) {
-            data_ << "." << i.value() << ".";
+            data_ += '.';
+            data_ += i.value();
+            data_ += '.';
         }
         void operator()(const IfcUtil::IfcBaseClass* const& i) {
             if (i->declaration().as_entity() == nullptr) {
-                i->toString(data_, upper_);
+                format_instance(data_, i, upper_);
             } else {
-                data_ << "#" << i->id();
+                data_ += '#';
+                format_int(data_, i->id());
             }
         }
         void operator()(const aggregate_of_instance::ptr& i) {
-            data_ << "(";
+            data_ += '(';
             for (aggregate_of_instance::it it = i->begin(); it != i->end(); ++it) {
                 if (it != i->begin()) {
-                    data_ << ",";
+                    data_ += ',';
                 }
                 (*this)(*it);
             }
-            data_ << ")";
+            data_ += ')';
         }
-        void operator()(const std::vector<std::vector<int>>& i);
-        void operator()(const std::vector<std::vector<double>>& i);
+        void operator()(const std::vector<std::vector<int>>& i) { serialize(i); }
+        void operator()(const std::vector<std::vector<double>>& i) { serialize(i); }
         void operator()(const aggregate_of_aggregate_of_instance::ptr& i) {
-            data_ << "(";
+            data_ += '(';
             for (aggregate_of_aggregate_of_instance::outer_it outer_it = i->begin(); outer_it != i->end(); ++outer_it) {
                 if (outer_it != i->begin()) {
-                    data_ << ",";
+                    data_ += ',';
                 }
-                data_ << "(";
+                data_ += '(';
                 for (aggregate_of_aggregate_of_instance::inner_it inner_it = outer_it->begin(); inner_it != outer_it->end(); ++inner_it) {
                     if (inner_it != outer_it->begin()) {
-                        data_ << ",";
+                        data_ += ',';
                     }
                     (*this)(*inner_it);
                 }
-                data_ << ")";
+                data_ += ')';
             }
-            data_ << ")";
+            data_ += ')';
         }
-        void operator()(const empty_aggregate_t& /*unused*/) const { data_ << "()"; }
-        void operator()(const empty_aggregate_of_aggregate_t& /*unused*/) const { data_ << "()"; }
+        void operator()(const empty_aggregate_t& /*unused*/) const { data_ += "()"; }
+        void operator()(const empty_aggregate_of_aggregate_t& /*unused*/) const { data_ += "()"; }
     };
 
-    template <>
-    void StringBuilderVisitor::serialize(const std::vector<std::string>& i) {
-        data_ << "(";
-        for (std::vector<std::string>::const_iterator it = i.begin(); it != i.end(); ++it) {
-            if (it != i.begin()) {
-                data_ << ",";
-            }
-            std::string encoder = IfcCharacterEncoder(*it);
-            data_ << encoder;
-        }
-        data_ << ")";
-    }
-
-    template <>
-    void StringBuilderVisitor::serialize(const std::vector<double>& i) {
-        data_ << "(";
-        for (std::vector<double>::const_iterator it = i.begin(); it != i.end(); ++it) {
-            if (it != i.begin()) {
-                data_ << ",";
-            }
-            data_ << format_double(*it);
-        }
-        data_ << ")";
-    }
-
-    template <>
-    void StringBuilderVisitor::serialize(const std::vector<boost::dynamic_bitset<>>& i) {
-        data_ << "(";
-        for (std::vector<boost::dynamic_bitset<>>::const_iterator it = i.begin(); it != i.end(); ++it) {
-            if (it != i.begin()) {
-                data_ << ",";
-            }
-            data_ << format_binary(*it);
-        }
-        data_ << ")";
-    }
-
-    void StringBuilderVisitor::operator()(const std::vector<int>& i) { serialize(i); }
-    void StringBuilderVisitor::operator()(const std::vector<double>& i) { serialize(i); }
-    void StringBuilderVisitor::operator()(const std::vector<std::string>& i) { serialize(i); }
-    void StringBuilderVisitor::operator()(const std::vector<boost::dynamic_bitset<>>& i) { serialize(i); }
-    void StringBuilderVisitor::operator()(const std::vector<std::vector<int>>& i) {
-        data_ << "(";
-        for (std::vector<std::vector<int>>::const_iterator it = i.begin(); it != i.end(); ++it) {
-            if (it != i.begin()) {
-                data_ << ",";
-            }
-            serialize(*it);
+    void format_instance(std::string& data, const IfcUtil::IfcBaseClass* inst, bool upper) {
+        const auto* ent = inst->declaration().as_entity();
+        if (ent != nullptr) {
+            data += '#';
+            format_int(data, inst->id());
+            data += '=';
         }
-        data_ << ")";
-    }
-    void StringBuilderVisitor::operator()(const std::vector<std::vector<double>>& i) {
-        data_ << "(";
-        for (std::vector<std::vector<double>>::const_iterator it = i.begin(); it != i.end(); ++it) {
-            if (it != i.begin()) {
-                data_ << ",";
-            }
-            serialize(*it);
-        }
-        data_ << ")";
+        data += upper ? inst->declaration().name_uc() : inst->declaration().name();
+        inst->data().toString(data, upper, ent);
     }
 }
 
@@ -982,28 +1168,32 @@ namespace {
 // Returns a string representation of the entity
 // Note that this initializes the entity if it is not initialized
 //
-void IfcEntityInstanceData::toString(std::ostream& ss, bool upper, const entity* decl) const {
-    ss.imbue(std::locale::classic());
-
-    ss << "(";
+void IfcEntityInstanceData::toString(std::string& data, bool upper, const entity* decl) const {
+    data += '(';
 
-    StringBuilderVisitor vis(ss, upper);
+    StringBuilderVisitor vis(data, upper);
 
     for (size_t i = 0; i < size(); ++i) {
         if (i != 0) {
-            ss << ",";
+            data += ',';
         }
         if (storage_.has<Blank>(i)) {
             if (decl != nullptr && decl->derived()[i]) {
-               ss << "*";
+                data += '*';
             } else {
-               ss << "$";
-	        }
+                data += '$';
+            }
         } else {
             storage_.apply_visitor(vis, i);
         }
     }
-    ss << ")";
+    data += ')';
+}
+
+void IfcEntityInstanceData::toString(std::ostream& ss, bool upper, const entity* decl) const {
+    std::string data;
+    toString(data, upper, decl);
+    ss << data;
 }
 
 unsigned IfcUtil::IfcBaseEntity::set_id(const boost::optional<unsigned>& i) {
@@ -1193,27 +1383,33 @@ void IfcUtil::IfcBaseClass::set_attribute_value(const std::string& s, const T& t
 // Creates the maps
 //
 #ifdef USE_MMAP
-IfcFile::IfcFile(const std::string& fn, bool mmap) {
-    initialize_(new IfcSpfStream(fn, mmap));
+IfcFile::IfcFile(const std::string& fn, bool mmap, unsigned int parse_threads)
+    : parse_threads_(parse_threads),
+      owned_stream_(new IfcSpfStream(fn, mmap)) {
+    initialize_(owned_stream_.get());
 }
 #else
-IfcFile::IfcFile(const std::string& path) {
-    IfcSpfStream s(path);
-    initialize_(&s);
+IfcFile::IfcFile(const std::string& path, unsigned int parse_threads)
+    : parse_threads_(parse_threads),
+      owned_stream_(new IfcSpfStream(path)) {
+    initialize_(owned_stream_.get());
 }
 #endif
 
-IfcFile::IfcFile(std::istream& stream, int length) {
-    IfcSpfStream s(stream, length);
-    initialize_(&s);
+IfcFile::IfcFile(std::istream& stream, int length, unsigned int parse_threads)
+    : parse_threads_(parse_threads),
+      owned_stream_(new IfcSpfStream(stream, length)) {
+    initialize_(owned_stream_.get());
 }
 
-IfcFile::IfcFile(void* data, int length) {
-    IfcSpfStream s(data, length);
-    initialize_(&s);
+IfcFile::IfcFile(void* data, int length, unsigned int parse_threads)
+    : parse_threads_(parse_threads),
+      owned_stream_(new IfcSpfStream(data, length)) {
+    initialize_(owned_stream_.get());
 }
 
-IfcFile::IfcFile(IfcParse::IfcSpfStream* s) {
+IfcFile::IfcFile(IfcParse::IfcSpfStream* s, unsigned int parse_threads)
+    : parse_threads_(parse_threads) {
     initialize_(s);
 }
 
@@ -1275,18 +1471,201 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
 
     ifcroot_type_ = schema_->declaration_by_name("IfcRoot");
 
+    Logger::Status("Scanning file...");
+
+    deferred_ = lazy_loading_;
+
+    if (deferred_) {
+        scan_deferred_();
+    } else if (parse_threads_ > 1) {
+        scan_parallel_();
+    } else {
+        scan_(true);
+    }
+
+    Logger::Status("\rDone scanning file   ");
+
+    if (!deferred_) {
+        // The lexer and stream are only retained to parse deferred instances
+        delete tokens;
+        tokens = nullptr;
+        owned_stream_.reset();
+        stream = nullptr;
+    }
+
+    compact_inverses_if_needed_();
+
+    if (good_ != file_open_status::SUCCESS) {
+        references_to_resolve.clear();
+        return;
+    }
+
+    {
+        PERF("file: resolving references");
+        resolve_references_([this](unsigned int name) -> storage_t* {
+            entity_by_id_t::const_iterator it = byid_.find(name);
+            return it == byid_.end() ? nullptr : &it->second->data().storage_;
+        });
+    }
+
+    Logger::Status("Done resolving references");
+}
+
+void IfcFile::resolve_references_(const std::function<storage_t*(unsigned int)>& storage_of) {
+    auto resolve_name = [this](int name, const MutableAttributeValue& attr) -> IfcUtil::IfcBaseClass* {
+        entity_by_id_t::const_iterator it = byid_.find(name);
+        if (it == byid_.end()) {
+            Logger::Error("Instance reference #" + std::to_string(name) + " used by instance #" + std::to_string(attr.name_) + " at attribute index " + std::to_string(attr.index_) + " not found");
+            return nullptr;
+        }
+        return it->second;
+    };
+
+    // Resolves the references in the range [begin, end) of references_to_resolve
+    // of the instance names for which include(name) holds
+    auto resolve = [&](size_t begin, size_t end, auto include) {
+        int storage_name = 0;
+        storage_t* storage = nullptr;
+        for (size_t i = begin; i < end; ++i) {
+            const auto& p = references_to_resolve[i];
+            const int ref = p.first.name_;
+            const auto refattr = p.first.index_;
+            if (!include(ref)) {
+                continue;
+            }
+            // Consecutive references mostly originate from the same instance
+            if (storage == nullptr || storage_name != ref) {
+                storage = storage_of(ref);
+                storage_name = ref;
+                if (storage == nullptr) {
+                    continue;
+                }
+            }
+            if (auto* v = boost::get<reference_or_simple_type>(&p.second)) {
+                if (auto* name = boost::get<int>(v)) {
+                    if (auto* inst = resolve_name(*name, p.first)) {
+                        storage->set(refattr, inst);
+                    }
+                } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(v)) {
+                    storage->set(refattr, *inst);
+                }
+            } else if (auto* v = boost::get<std::vector<reference_or_simple_type>>(&p.second)) {
+                auto instances = boost::make_shared<aggregate_of_instance>();
+                instances->reserve(v->size());
+                for (const auto& vi : *v) {
+                    if (auto* name = boost::get<int>(&vi)) {
+                        if (auto* inst = resolve_name(*name, p.first)) {
+                            instances->push(inst);
+                        }
+                    } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vi)) {
+                        instances->push(*inst);
+                    }
+                }
+                storage->set(refattr, instances);
+            } else if (auto* v = boost::get<std::vector<std::vector<reference_or_simple_type>>>(&p.second)) {
+                auto instances = boost::make_shared<aggregate_of_aggregate_of_instance>();
+                for (const auto& vi : *v) {
+                    std::vector<IfcUtil::IfcBaseClass*> inner;
+                    inner.reserve(vi.size());
+                    for (const auto& vii : vi) {
+                        if (auto* name = boost::get<int>(&vii)) {
+                            if (auto* inst = resolve_name(*name, p.first)) {
+                                inner.push_back(inst);
+                            }
+                        } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vii)) {
+                            inner.push_back(*inst);
+                        }
+                    }
+                    instances->push(inner);
+                }
+                storage->set(refattr, instances);
+            }
+        }
+    };
+
+    // Only worthwhile for the references of a complete file, not for the few
+    // references of an instance that is parsed on access.
+    static const size_t min_references_per_thread = 1 << 16;
+    const unsigned int num_threads = (unsigned int)(std::min)((size_t)parse_threads_, references_to_resolve.size() / min_references_per_thread);
+
+    auto all = [](int) { return true; };
+
+    if (num_threads <= 1) {
+        resolve(0, references_to_resolve.size(), all);
+    } else {
+        // An instance name that is defined more than once is resolved to the storage
+        // of its last definition for the references of every definition, which can
+        // end up in different ranges. The references of such names are resolved
+        // afterwards on this thread, in order, as the serial path would.
+        enum name_state : char { unseen, seen, duplicated };
+        std::vector<char> states((size_t) MaxId + 1, unseen);
+        bool has_duplicates = false;
+        for (size_t i = 0; i < references_to_resolve.size(); ++i) {
+            const int name = references_to_resolve[i].first.name_;
+            if (name < 0 || (i > 0 && references_to_resolve[i - 1].first.name_ == name)) {
+                continue;
+            }
+            if ((size_t) name >= states.size()) {
+                states.resize((size_t) name + 1, unseen);
+            }
+            if (states[name] == unseen) {
+                states[name] = seen;
+            } else {
+                states[name] = duplicated;
+                has_duplicates = true;
+            }
+        }
+        auto is_unique = [&states](int name) { return name < 0 || states[name] != duplicated; };
+        auto is_duplicated = [&states](int name) { return name >= 0 && states[name] == duplicated; };
+
+        // The references are split into contiguous ranges of about equal size,
+        // that each start where the referencing instance changes, so that the
+        // consecutive references of an instance are resolved by the same thread.
+        std::vector<size_t> bounds{ 0 };
+        for (unsigned int i = 1; i < num_threads; ++i) {
+            size_t bound = (std::max)(bounds.back(), references_to_resolve.size() * i / num_threads);
+            while (bound > 0 && bound < references_to_resolve.size() &&
+                references_to_resolve[bound].first.name_ == references_to_resolve[bound - 1].first.name_) {
+                ++bound;
+            }
+            bounds.push_back(bound);
+        }
+        bounds.push_back(references_to_resolve.size());
+
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (unsigned int i = 0; i < num_threads; ++i) {
+            if (bounds[i] < bounds[i + 1]) {
+                threads.emplace_back(resolve, bounds[i], bounds[i + 1], is_unique);
+            }
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        if (has_duplicates) {
+            resolve(0, references_to_resolve.size(), is_duplicated);
+        }
+    }
+
+    references_to_resolve.clear();
+    references_to_resolve.shrink_to_fit();
+}
+
+void IfcFile::scan_(bool report_progress) {
+    ::impl::arena_scope arena_scope(arena_allocation_ ? &arena_ : nullptr);
+
     boost::circular_buffer<Token> token_stream(3, Token());
 
     IfcUtil::IfcBaseClass* instance = nullptr;
 
     unsigned current_id = 0;
     int progress = 0;
-    Logger::Status("Scanning file...");
 
     int paren_stack_depth = 0;
     int attribute_index = -1;
 
-    while (!stream->eof) {
+    while (!stream->eof && !scan_cancelled_.load(std::memory_order_relaxed)) {
         if (token_stream[0].type == IfcParse::Token_IDENTIFIER &&
             token_stream[1].type == IfcParse::Token_OPERATOR &&
             token_stream[1].value_char == '=' &&
@@ -1296,7 +1675,7 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
             current_id = (unsigned)TokenFunc::asIdentifier(token_stream[0]);
             const IfcParse::declaration* entity_type;
             try {
-                entity_type = schema_->declaration_by_name(TokenFunc::asStringRef(token_stream[2]));
+                entity_type = schema_->declaration_by_name(TokenFunc::asStringView(token_stream[2]));
             } catch (const IfcException& ex) {
                 Logger::Message(Logger::LOG_ERROR, std::string(ex.what()) + " at offset " + std::to_string(token_stream[2].startPos));
                 goto advance;
@@ -1317,12 +1696,14 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
                 break;
             }
             instance = schema_->instantiate(entity_type, ps.construct(current_id, references_to_resolve, entity_type, boost::none));
-            instance->file_ = this;
+            // The lexer refers to the file that eventually owns the instances, for
+            // the chunks of the parallel parser this is not the file being scanned.
+            instance->file_ = tokens->file;
             instance->id_ = current_id;
 
             /// @todo Printing to stdout in a library class feels weird. Maybe move the progress prints to the client code?
             // Update the status after every 1000 instances parsed
-            if (((++progress) % 1000) == 0) {
+            if (report_progress && ((++progress) % 1000) == 0) {
                 std::stringstream ss;
                 ss << "\r#" << current_id;
                 Logger::Status(ss.str(), false);
@@ -1392,71 +1773,423 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
 
         token_stream.push_back(next_token);
     }
+}
 
-    Logger::Status("\rDone scanning file   ");
+namespace {
+// Returns the offset of the first instance definition (`#id=` at the start of a
+// line and preceded by the `;` terminating the previous instance) at or after
+// offset, or end when no such boundary exists. The data is scanned from position,
+// which is outside of any string, binary or comment, so that text in these that
+// looks like an instance definition is skipped. Position is advanced to the
+// returned offset, so that consecutive boundaries are found in a single pass.
+unsigned int find_instance_boundary(const char* data, unsigned int& position, unsigned int offset, unsigned int end) {
+    const unsigned int start = position;
+    unsigned int i = position;
+    while (i < end) {
+        i += find_first_of<'\'', '"', '/', '\n', '\r'>(data + i, data + end);
+        if (i == end) {
+            break;
+        }
+        const char character = data[i];
+        if (character == '\'') {
+            // Doubled apostrophes are handled as two consecutive strings, the
+            // character following a \S\ directive can be an apostrophe.
+            for (++i; i < end; ++i) {
+                i += find_first_of<'\'', '\\'>(data + i, data + end);
+                if (i == end || data[i] == '\'') {
+                    break;
+                }
+                if (i + 2 < end && data[i + 1] == 'S' && data[i + 2] == '\\') {
+                    i += 3;
+                } else if (i + 1 < end && data[i + 1] == '\\') {
+                    ++i;
+                }
+            }
+            i = (std::min)(i + 1, end);
+            continue;
+        }
+        if (character == '"') {
+            i += 1 + find_first_of<'"'>(data + i + 1, data + end);
+            i = (std::min)(i + 1, end);
+            continue;
+        }
+        if (character == '/') {
+            if (i + 1 < end && data[i + 1] == '*') {
+                static const char comment_terminator[] = "*/";
+                const char* comment_end = std::search(data + i + 2, data + end, comment_terminator, comment_terminator + 2);
+                i = (std::min)((unsigned int)(comment_end - data) + 2, end);
+            } else {
+                ++i;
+            }
+            continue;
+        }
+        if (i < offset) {
+            ++i;
+            continue;
+        }
+        unsigned int j = i + 1;
+        while (j < end && (data[j] == '\n' || data[j] == '\r' || data[j] == ' ' || data[j] == '\t')) {
+            ++j;
+        }
+        if (j == end || data[j] != '#') {
+            i = j;
+            continue;
+        }
+        unsigned int k = j + 1;
+        while (k < end && data[k] >= '0' && data[k] <= '9') {
+            ++k;
+        }
+        if (k == j + 1) {
+            i = j;
+            continue;
+        }
+        while (k < end && (data[k] == ' ' || data[k] == '\t')) {
+            ++k;
+        }
+        if (k == end || data[k] != '=') {
+            i = j;
+            continue;
+        }
+        unsigned int h = i;
+        while (h > start && (data[h] == '\n' || data[h] == '\r' || data[h] == ' ' || data[h] == '\t')) {
+            --h;
+        }
+        if (data[h] == ';') {
+            position = j;
+            return j;
+        }
+        i = j;
+    }
+    position = end;
+    return end;
+}
+} // namespace
 
-    delete tokens;
+void IfcFile::scan_parallel_() {
+    const unsigned int begin = stream->Tell();
+    const unsigned int end = stream->End();
 
-    if (good_ != file_open_status::SUCCESS) {
-        references_to_resolve.clear();
-        return;
+    std::vector<unsigned int> offsets = {begin};
+    unsigned int position = begin;
+    for (unsigned int i = 1; i < parse_threads_; ++i) {
+        const unsigned int approximate = begin + (unsigned int)((uint64_t)(end - begin) * i / parse_threads_);
+        const unsigned int offset = find_instance_boundary(stream->Buffer(), position, (std::max)(approximate, offsets.back()), end);
+        if (offset != end && offset != offsets.back()) {
+            offsets.push_back(offset);
+        }
     }
+    offsets.push_back(end);
 
-    for (const auto& p : references_to_resolve) {
-        const auto& ref = p.first.name_;
-        const auto& refattr = p.first.index_;
-        if (auto* v = boost::get<reference_or_simple_type>(&p.second)) {
-            if (auto* name = boost::get<int>(v)) {
-                entity_by_id_t::const_iterator it = byid_.find(*name);
-                if (it == byid_.end()) {
-                    Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
-                } else {
-                    byid_[p.first.name_]->data().storage_.set(p.first.index_, it->second);
+    const size_t num_chunks = offsets.size() - 1;
+
+    std::vector<std::unique_ptr<IfcSpfStream>> streams;
+    std::vector<std::unique_ptr<IfcFile>> chunks;
+    for (size_t i = 0; i < num_chunks; ++i) {
+        streams.emplace_back(new IfcSpfStream(*stream, offsets[i], offsets[i + 1]));
+        chunks.emplace_back(new IfcFile(schema_));
+        chunks.back()->stream = streams.back().get();
+        chunks.back()->tokens = new IfcSpfLexer(streams.back().get(), this);
+    }
+
+    // The serial parser stops at the first error, so an error in a chunk cancels
+    // the chunks that follow it. Their instances are not merged below.
+    std::vector<std::thread> threads;
+    threads.reserve(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        threads.emplace_back([&chunks, i, num_chunks]() {
+            auto& chunk = chunks[i];
+            try {
+                chunk->scan_(false);
+            } catch (const std::exception& e) {
+                chunk->good_ = file_open_status::INVALID_SYNTAX;
+                Logger::Error(e);
+            }
+            if (chunk->good_ != file_open_status::SUCCESS) {
+                for (size_t j = i + 1; j < num_chunks; ++j) {
+                    chunks[j]->scan_cancelled_ = true;
                 }
-            } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(v)) {
-                byid_[p.first.name_]->data().storage_.set(p.first.index_, *inst);
-            }
-        } else if (auto* v = boost::get<std::vector<reference_or_simple_type>>(&p.second)) {
-            aggregate_of_instance::ptr instances(new aggregate_of_instance);
-            instances->reserve(v->size());
-            for (const auto& vi : *v) {
-                if (auto* name = boost::get<int>(&vi)) {
-                    entity_by_id_t::const_iterator it = byid_.find(*name);
-                    if (it == byid_.end()) {
-                        Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    size_t num_instances = 0;
+    for (auto& chunk : chunks) {
+        num_instances += chunk->byid_.size();
+    }
+    byid_.reserve(num_instances);
+
+    // Chunks are merged in file order so that the type lists, inverses and references
+    // to resolve are in the same order as they would have been when parsed serially.
+    for (auto& chunk : chunks) {
+        delete chunk->tokens;
+        chunk->tokens = nullptr;
+
+        if (chunk->good_ != file_open_status::SUCCESS && good_ == file_open_status::SUCCESS) {
+            good_ = chunk->good_;
+        }
+
+        for (const auto& p : chunk->byid_) {
+            if (byid_.find(p.first) != byid_.end()) {
+                std::stringstream ss;
+                ss << "Overwriting instance with name #" << p.first;
+                Logger::Message(Logger::LOG_WARNING, ss.str());
+            }
+            byid_[p.first] = p.second;
+        }
+        // The instances are now owned by this file
+        chunk->byid_.clear();
+
+        for (const auto& p : chunk->bytype_excl_) {
+            auto& instances = bytype_excl_[p.first];
+            if (!instances) {
+                instances = p.second;
+            } else {
+                instances->push(p.second);
+            }
+        }
+
+        for (const auto& p : chunk->byguid_) {
+            if (byguid_.find(p.first) != byguid_.end()) {
+                std::stringstream ss;
+                ss << "Instance encountered with non-unique GlobalId " << p.first;
+                Logger::Message(Logger::LOG_WARNING, ss.str());
+            }
+            byguid_[p.first] = p.second;
+        }
+
+        byref_excl_.append(chunk->byref_excl_);
+
+        references_to_resolve.insert(references_to_resolve.end(), std::make_move_iterator(chunk->references_to_resolve.begin()), std::make_move_iterator(chunk->references_to_resolve.end()));
+        unresolved_references().swap(chunk->references_to_resolve);
+
+        arena_.splice(chunk->arena_);
+
+        MaxId = (std::max)(MaxId, chunk->MaxId);
+
+        if (chunk->good_ != file_open_status::SUCCESS) {
+            // The remaining chunks, and the instances they hold, are destroyed with chunks
+            break;
+        }
+    }
+}
+
+void IfcFile::scan_deferred_() {
+    const char* data = stream->Buffer();
+    const unsigned int end = stream->End();
+
+    int progress = 0;
+
+    while (!stream->eof) {
+        Token name_token;
+        Token equals_token;
+        Token keyword_token;
+        try {
+            name_token = tokens->Next();
+            if (name_token.type == Token_IDENTIFIER) {
+                equals_token = tokens->Next();
+                keyword_token = tokens->Next();
+            }
+        } catch (const IfcException& e) {
+            Logger::Message(Logger::LOG_ERROR, std::string(e.what()) + ". Parsing terminated");
+        }
+
+        if (name_token.type == Token_NONE) {
+            if (!stream->eof) {
+                good_ = file_open_status::INVALID_SYNTAX;
+            }
+            break;
+        }
+
+        if (name_token.type != Token_IDENTIFIER || !TokenFunc::isOperator(equals_token, '=') || !TokenFunc::isKeyword(keyword_token)) {
+            continue;
+        }
+
+        const unsigned int name = (unsigned int)TokenFunc::asIdentifier(name_token);
+
+        const IfcParse::entity* entity = nullptr;
+        try {
+            const IfcParse::declaration* entity_type = schema_->declaration_by_name(TokenFunc::asStringView(keyword_token));
+            entity = entity_type->as_entity();
+            if (entity == nullptr) {
+                Logger::Message(Logger::LOG_ERROR, "Non entity type " + entity_type->name() + " at offset " + std::to_string(keyword_token.startPos));
+            }
+        } catch (const IfcException& ex) {
+            Logger::Message(Logger::LOG_ERROR, std::string(ex.what()) + " at offset " + std::to_string(keyword_token.startPos));
+        }
+
+        const bool is_root = entity != nullptr && entity->is(*ifcroot_type_);
+        std::string guid;
+
+        // The attribute values are skipped over without tokenizing them, only the
+        // names of referenced instances are read to populate the inverse index.
+        unsigned int offset = stream->Tell();
+        int depth = 0;
+        int attribute_index = 0;
+        while (offset < end) {
+            offset += find_first_of<'(', ')', ',', ';', '#', '\'', '"', '/'>(data + offset, data + end);
+            if (offset == end) {
+                break;
+            }
+            const char character = data[offset];
+            if (character == ';') {
+                ++offset;
+                break;
+            }
+            if (character == '(') {
+                ++depth;
+                ++offset;
+            } else if (character == ')') {
+                --depth;
+                ++offset;
+            } else if (character == ',') {
+                if (depth == 1) {
+                    ++attribute_index;
+                }
+                ++offset;
+            } else if (character == '#') {
+                unsigned int referenced = 0;
+                bool has_digits = false;
+                for (++offset; offset < end; ++offset) {
+                    if (data[offset] >= '0' && data[offset] <= '9') {
+                        referenced = referenced * 10 + (unsigned int)(data[offset] - '0');
+                        has_digits = true;
+                    } else if (data[offset] != '\n' && data[offset] != '\r') {
+                        break;
+                    }
+                }
+                if (has_digits && depth > 0 && entity != nullptr) {
+                    byref_excl_.append((int)referenced, (short)entity->index_in_schema(), (short)attribute_index, (int)name);
+                }
+            } else if (character == '\'') {
+                const bool is_guid = is_root && depth == 1 && attribute_index == 0;
+                unsigned int string_end = offset + 1;
+                bool use_lexer = is_guid;
+                while (!use_lexer) {
+                    string_end += find_first_of<'\'', '\\'>(data + string_end, data + end);
+                    if (string_end == end) {
+                        break;
+                    }
+                    if (data[string_end] == '\\') {
+                        // Control directives can contain apostrophes, these are left to the lexer
+                        use_lexer = true;
+                    } else if (string_end + 1 < end && data[string_end + 1] == '\'') {
+                        string_end += 2;
                     } else {
-                        instances->push(it->second);
+                        ++string_end;
+                        break;
                     }
-                } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vi)) {
-                    instances->push(*inst);
                 }
-            }
-            byid_[p.first.name_]->data().storage_.set(p.first.index_, instances);
-        } else if (auto* v = boost::get<std::vector<std::vector<reference_or_simple_type>>>(&p.second)) {
-            aggregate_of_aggregate_of_instance::ptr instances(new aggregate_of_aggregate_of_instance);
-            for (const auto& vi : *v) {
-                std::vector<IfcUtil::IfcBaseClass*> inner;
-                for (const auto& vii : vi) {
-                    if (auto* name = boost::get<int>(&vii)) {
-                        entity_by_id_t::const_iterator it = byid_.find(*name);
-                        if (it == byid_.end()) {
-                            Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
-                        } else {
-                            inner.push_back(it->second);
-                        }
-                    } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vii)) {
-                        inner.push_back(*inst);
+                if (use_lexer) {
+                    stream->Seek(offset);
+                    Token string_token = tokens->Next();
+                    if (is_guid && TokenFunc::isString(string_token)) {
+                        guid = TokenFunc::asString(string_token);
                     }
+                    string_end = stream->eof ? end : stream->Tell();
                 }
-                instances->push(inner);
+                offset = string_end;
+            } else if (character == '"') {
+                offset += 1 + find_first_of<'"'>(data + offset + 1, data + end);
+                offset = (std::min)(offset + 1, end);
+            } else if (character == '/' && offset + 1 < end && data[offset + 1] == '*') {
+                static const char comment_terminator[] = "*/";
+                const char* comment_end = std::search(data + offset + 2, data + end, comment_terminator, comment_terminator + 2);
+                offset = (std::min)((unsigned int)(comment_end - data) + 2, end);
+            } else {
+                ++offset;
             }
-            byid_[p.first.name_]->data().storage_.set(p.first.index_, instances);
         }
+
+        if (offset < end) {
+            stream->Seek(offset);
+        } else {
+            stream->eof = true;
+        }
+
+        if (entity == nullptr) {
+            continue;
+        }
+
+        IfcUtil::IfcBaseClass* instance = schema_->instantiate(entity, IfcEntityInstanceData(storage_t()));
+        instance->file_ = this;
+        instance->id_ = name;
+        instance->data().unparsed_ = instance;
+        deferred_offsets_.emplace_back(name, keyword_token.startPos);
+
+        if (((++progress) % 1000) == 0) {
+            std::stringstream ss;
+            ss << "\r#" << name;
+            Logger::Status(ss.str(), false);
+        }
+
+        if (is_root && !guid.empty()) {
+            if (byguid_.find(guid) != byguid_.end()) {
+                std::stringstream ss;
+                ss << "Instance encountered with non-unique GlobalId " << guid;
+                Logger::Message(Logger::LOG_WARNING, ss.str());
+            }
+            byguid_[guid] = instance;
+        }
+
+        auto& instances = bytype_excl_[entity];
+        if (!instances) {
+            instances.reset(new aggregate_of_instance());
+        }
+        instances->push(instance);
+
+        if (byid_.find(name) != byid_.end()) {
+            std::stringstream ss;
+            ss << "Overwriting instance with name #" << name;
+            Logger::Message(Logger::LOG_WARNING, ss.str());
+        }
+        byid_[name] = instance;
+
+        MaxId = (std::max)(MaxId, name);
     }
 
-    Logger::Status("Done resolving references");
+    std::stable_sort(deferred_offsets_.begin(), deferred_offsets_.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+}
 
-    references_to_resolve.clear();
+void IfcFile::parse_deferred_(IfcUtil::IfcBaseClass* instance, IfcEntityInstanceData& data) {
+    std::lock_guard<std::mutex> lock(deferred_mutex_);
+
+    if (data.unparsed_.load(std::memory_order_relaxed) == nullptr) {
+        // Parsed by another thread while waiting for the lock
+        return;
+    }
+
+    const unsigned int name = instance->id();
+    auto range = std::equal_range(deferred_offsets_.begin(), deferred_offsets_.end(), std::make_pair(name, 0U), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    if (range.first == range.second) {
+        throw IfcException("Instance #" + std::to_string(name) + " not found in file");
+    }
+    // With duplicate names, the last definition is the one in the instance map
+    auto by_id = byid_.find(name);
+    auto it = (by_id != byid_.end() && by_id->second == instance) ? std::prev(range.second) : range.first;
+
+    ::impl::arena_scope arena_scope(arena_allocation_ ? &arena_ : nullptr);
+
+    try {
+        stream->Seek(it->second);
+        IfcEntityInstanceData parsed = IfcParse::read(name, this);
+        resolve_references_([&parsed](unsigned int) -> storage_t* {
+            return &parsed.storage_;
+        });
+        data.storage_ = std::move(parsed.storage_);
+    } catch (const IfcException& e) {
+        Logger::Error(e);
+        references_to_resolve.clear();
+        data.storage_ = storage_t(instance->declaration().as_entity()->attribute_count());
+    }
+
+    data.unparsed_.store(nullptr, std::memory_order_release);
 }
 
 void IfcFile::recalculate_id_counter() {
@@ -1837,6 +2570,7 @@ void IfcFile::removeEntity(IfcUtil::IfcBaseClass* entity) {
 }
 
 void IfcFile::process_deletion_() {
+    compact_inverses_if_needed_();
 
     for (const auto& id : batch_deletion_ids_.get<0>()) {
         auto* entity = instance_by_id(id);
@@ -1905,11 +2639,7 @@ void IfcFile::process_deletion_() {
         }
 
         if (!batch_mode_) {
-            byref_excl_.erase(
-                byref_excl_.lower_bound({id, -1, -1}),
-                byref_excl_.upper_bound({id, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()}));
-
-            // byref_excl_.erase(id);
+            byref_excl_.remove_references_to(id);
 
             // This is based on traversal which needs instances to still be contained in the map.
             // another option would be to keep byid intact for the remainder of this loop
@@ -1922,15 +2652,7 @@ void IfcFile::process_deletion_() {
                 const unsigned int name = entity_attribute->id();
                 // Do not update inverses for simple types (which have id()==0 in IfcOpenShell).
                 if (name != 0) {
-                    {
-                        auto lower = byref_excl_.lower_bound({name, -1, -1});
-                        auto upper = byref_excl_.upper_bound({name, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()});
-
-                        for (auto byref_it = lower; byref_it != upper; ++byref_it) {
-                            auto& ids = byref_it->second;
-                            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
-                        }
-                    }
+                    byref_excl_.remove_references_from(name, id);
                 }
             }
         }
@@ -1973,23 +2695,14 @@ void IfcFile::process_deletion_() {
     }
 
     if (batch_mode_) {
-        for (auto it = byref_excl_.begin(); it != byref_excl_.end();) {
-            bool do_delete = batch_deletion_ids_.get<1>().find(std::get<INSTANCE_ID>(it->first)) != batch_deletion_ids_.get<1>().end();
-            if (!do_delete) {
-                it->second.erase(std::remove_if(it->second.begin(), it->second.end(), [this](int x) {
-                                     return batch_deletion_ids_.get<1>().find(x) != batch_deletion_ids_.get<1>().end();
-                                 }),
-                                 it->second.end());
-                do_delete = it->second.empty();
-            }
-            if (do_delete) {
-                it = byref_excl_.erase(it);
-            } else {
-                ++it;
-            }
-        }
+        byref_excl_.remove_if([this](int referenced, int id) {
+            return batch_deletion_ids_.get<1>().find(referenced) != batch_deletion_ids_.get<1>().end() ||
+                   batch_deletion_ids_.get<1>().find(id) != batch_deletion_ids_.get<1>().end();
+        });
     }
 
+    compact_inverses_if_needed_();
+
     batch_deletion_ids_.clear();
 }
 
@@ -2038,14 +2751,10 @@ aggregate_of_instance::ptr IfcFile::instances_by_type_excl_subtypes(const std::s
 }
 
 aggregate_of_instance::ptr IfcFile::instances_by_reference(int t) {
-    auto lower = byref_excl_.lower_bound({ t, -1, -1 });
-    auto upper = byref_excl_.upper_bound({ t, std::numeric_limits<short>::max(), std::numeric_limits<short>::max() });
     aggregate_of_instance::ptr ret(new aggregate_of_instance);
-    for (auto it = lower; it != upper; ++it) {
-        for (auto& i : it->second) {
-            ret->push(instance_by_id(i));
-        }
-    }
+    byref_excl_.for_each(t, [this, &ret](const inverse_index::reference& ref) {
+        ret->push(resolve_inverse_(ref));
+    });
     return ret;
 }
 
@@ -2077,6 +2786,7 @@ IfcFile::~IfcFile() {
     for (auto* entity : entities_to_delete) {
         delete entity;
     }
+    delete tokens;
 }
 
 IfcFile::entity_by_id_t::const_iterator IfcFile::begin() const {
@@ -2095,32 +2805,132 @@ IfcFile::type_iterator IfcFile::types_end() const {
     return bytype_excl_.end();
 }
 
-namespace {
-struct id_instance_pair_sorter {
-    bool operator()(const IfcParse::IfcFile::entity_by_id_t::value_type& a, const IfcParse::IfcFile::entity_by_id_t::value_type& b) const {
-        return a.first < b.first;
+void IfcFile::write(std::ostream& out, unsigned int threads) const {
+    _header.write(out);
+
+    std::vector<const IfcUtil::IfcBaseClass*> sorted;
+    sorted.reserve(byid_.size());
+    for (const auto& p : byid_) {
+        if (p.second->declaration().as_entity() != nullptr) {
+            sorted.push_back(p.second);
+        }
     }
-};
-} // namespace
+    std::sort(sorted.begin(), sorted.end(), [](const IfcUtil::IfcBaseClass* a, const IfcUtil::IfcBaseClass* b) {
+        return a->id() < b->id();
+    });
 
-std::ostream& operator<<(std::ostream& out, const IfcParse::IfcFile& file) {
-    file.header().write(out);
+    // Instances are formatted in chunks that are written to the stream at once
+    static const size_t chunk_size = 4096;
+    const size_t num_chunks = (sorted.size() + chunk_size - 1) / chunk_size;
+
+    auto format_chunk = [&sorted](size_t chunk, std::string& data) {
+        const size_t end = (std::min)(sorted.size(), (chunk + 1) * chunk_size);
+        for (size_t i = chunk * chunk_size; i < end; ++i) {
+            format_instance(data, sorted[i], true);
+            data += ";\n";
+        }
+    };
 
-    typedef std::vector<std::pair<unsigned int, IfcUtil::IfcBaseClass*>> vector_t;
-    vector_t sorted(file.begin(), file.end());
-    std::sort(sorted.begin(), sorted.end(), id_instance_pair_sorter());
+    if (threads == 0) {
+        threads = (std::max)(std::thread::hardware_concurrency(), 1U);
+    }
+    if (threads > num_chunks) {
+        threads = (unsigned int)num_chunks;
+    }
 
-    for (vector_t::const_iterator it = sorted.begin(); it != sorted.end(); ++it) {
-        const IfcUtil::IfcBaseClass* e = it->second;
-        if (e->declaration().as_entity() != nullptr) {
-            e->toString(out, true);
-            out << ";" << std::endl;
+    if (threads <= 1) {
+        std::string data;
+        for (size_t i = 0; i < num_chunks; ++i) {
+            data.clear();
+            format_chunk(i, data);
+            out.write(data.data(), data.size());
+        }
+    } else {
+        // The threads format the chunks in a window of chunks ahead of the one
+        // that is written, so that at most a window of chunks is kept in memory.
+        const size_t window = 4 * (size_t)threads;
+        std::vector<std::string> formatted(num_chunks);
+        std::vector<bool> done(num_chunks, false);
+        std::atomic<size_t> next_chunk(0);
+        size_t num_written = 0;
+        bool failed = false;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable chunk_formatted, chunk_written;
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (unsigned int t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i; (i = next_chunk++) < num_chunks;) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        chunk_written.wait(lock, [&]() { return failed || i < num_written + window; });
+                        if (failed) {
+                            return;
+                        }
+                    }
+                    std::string data;
+                    try {
+                        format_chunk(i, data);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!failed) {
+                            failed = true;
+                            error = std::current_exception();
+                        }
+                        chunk_formatted.notify_all();
+                        chunk_written.notify_all();
+                        return;
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    formatted[i] = std::move(data);
+                    done[i] = true;
+                    chunk_formatted.notify_all();
+                }
+            });
+        }
+
+        for (size_t i = 0; i < num_chunks; ++i) {
+            std::string data;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunk_formatted.wait(lock, [&]() { return failed || done[i]; });
+                if (failed) {
+                    break;
+                }
+                data = std::move(formatted[i]);
+            }
+            try {
+                out.write(data.data(), data.size());
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            ++num_written;
+            chunk_written.notify_all();
+            if (failed) {
+                break;
+            }
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
         }
     }
 
-    out << "ENDSEC;" << std::endl;
-    out << "END-ISO-10303-21;" << std::endl;
+    out << "ENDSEC;\n";
+    out << "END-ISO-10303-21;\n";
+    out.flush();
+}
 
+std::ostream& operator<<(std::ostream& out, const IfcParse::IfcFile& file) {
+    file.write(out);
     return out;
 }
 
@@ -2143,40 +2953,15 @@ std::string IfcFile::createTimestamp() {
 std::vector<int> IfcFile::get_inverse_indices(int instance_id) {
     std::vector<int> return_value;
 
-    auto lower = byref_excl_.lower_bound({instance_id, -1, -1});
-    auto upper = byref_excl_.upper_bound({instance_id, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()});
-
-    // Mapping of instance id to attribute offset.
-    std::map<int, std::vector<int>> mapping;
-
-    for (auto it = lower; it != upper; ++it) {
-        for (auto& i : it->second) {
-            // We only take the tuple for the type that id=i actually is, in order not
-            // to count double. Because byref contains mappings for every supertype of id=i.
-            if (instance_by_id(i)->declaration().index_in_schema() == std::get<1>(it->first)) {
-                mapping[i].push_back(std::get<2>(it->first));
-            }
-        }
-    }
-
-    auto refs = instances_by_reference(instance_id);
-
-    for (const auto& ref : *refs) {
-        auto it = mapping.find(ref->id());
-        if (it == mapping.end() || it->second.empty()) {
+    // The references are visited in the same order as instances_by_reference()
+    // returns them, references are only registered for the type that the
+    // referring instance actually is.
+    byref_excl_.for_each(instance_id, [this, &return_value](const inverse_index::reference& ref) {
+        if (resolve_inverse_(ref)->declaration().index_in_schema() != ref.type) {
             throw IfcException("Internal error");
         }
-        return_value.push_back(it->second.front());
-        it->second.erase(it->second.begin());
-        if (it->second.empty()) {
-            mapping.erase(it);
-        }
-    }
-
-    // Test whether all mappings where indeed used.
-    if (!mapping.empty()) {
-        throw IfcException("Internal error");
-    }
+        return_value.push_back(ref.attribute);
+    });
 
     return return_value;
 }
@@ -2189,36 +2974,16 @@ aggregate_of_instance::ptr IfcFile::getInverse(int instance_id, const IfcParse::
     aggregate_of_instance::ptr return_value(new aggregate_of_instance);
 
     visit_subtypes(type->as_entity(), [this, attribute_index, instance_id, &return_value](const IfcParse::declaration* ent) {
-        if (attribute_index == -1) {
-            auto lower = byref_excl_.lower_bound({ instance_id, ent->index_in_schema(), -1 });
-            auto upper = byref_excl_.upper_bound({ instance_id, ent->index_in_schema(), std::numeric_limits<short>::max() });
-
-            for (auto it = lower; it != upper; ++it) {
-                for (auto& i : it->second) {
-                    return_value->push(instance_by_id(i));
-                }
-            }
-        } else {
-            auto it = byref_excl_.find({ instance_id, ent->index_in_schema(), attribute_index });
-            if (it != byref_excl_.end()) {
-                for (auto& i : it->second) {
-                    return_value->push(instance_by_id(i));
-                }
-            }
-        }
+        byref_excl_.for_each(instance_id, (short) ent->index_in_schema(), (short) attribute_index, [this, &return_value](const inverse_index::reference& ref) {
+            return_value->push(resolve_inverse_(ref));
+        });
     });
 
     return return_value;
 }
 
 size_t IfcFile::getTotalInverses(int instance_id) {
-    size_t n = 0;
-    auto lower = byref_excl_.lower_bound({ instance_id, -1, -1 });
-    auto upper = byref_excl_.upper_bound({ instance_id, std::numeric_limits<short>::max(), std::numeric_limits<short>::max() });
-    for (auto it = lower; it != upper; ++it) {
-        n += it->second.size();
-    }
-    return n;
+    return byref_excl_.count(instance_id);
 }
 
 void IfcFile::setDefaultHeaderValues() {
@@ -2318,11 +3083,13 @@ void IfcParse::IfcFile::build_inverses_(IfcUtil::IfcBaseClass* inst) {
         if (attr->declaration().as_entity() != nullptr) {
             unsigned entity_attribute_id = attr->id();
             const auto* decl = inst->declaration().as_entity();
-            byref_excl_[{entity_attribute_id, decl->index_in_schema(), idx}].push_back(inst->id());
+            byref_excl_.add(entity_attribute_id, decl->index_in_schema(), idx, inst->id());
         }
     };
 
     apply_individual_instance_visitor(&inst->data()).apply(fn);
+
+    compact_inverses_if_needed_();
 }
 
 void IfcParse::IfcFile::build_inverses() {
@@ -2334,27 +3101,23 @@ void IfcParse::IfcFile::build_inverses() {
 std::atomic_uint32_t IfcUtil::IfcBaseClass::counter_(0);
 
 bool IfcParse::IfcFile::guid_map_ = true;
+bool IfcParse::IfcFile::arena_allocation_ = false;
+bool IfcParse::IfcFile::lazy_loading_ = false;
 
 void IfcUtil::IfcBaseClass::unset_attribute_value(size_t index) {
+    data_.ensure_parsed();
     data_.storage_.set(index, Blank{});
 }
 
 void IfcUtil::IfcBaseClass::toString(std::ostream& out, bool upper) const
 {
-    const auto *ent = declaration().as_entity();
-    if (ent != nullptr) {
-        out << "#" << as<IfcUtil::IfcBaseEntity>()->id() << "=";
-    }
-    if (upper) {
-        out << declaration().name_uc();
-    } else {
-        out << declaration().name();
-    }
-    data().toString(out, upper, ent);
+    std::string data;
+    format_instance(data, this, upper);
+    out << data;
 }
 
 IfcEntityInstanceData::IfcEntityInstanceData(const IfcEntityInstanceData& data)
-    : storage_(data.storage_.size() )
+    : storage_(data.size())
 {
     for (size_t i = 0; i < data.storage_.size(); ++i) {
         data.storage_.apply_visitor([this, i](const auto& v) {
@@ -2387,9 +3150,17 @@ IfcEntityInstanceData::IfcEntityInstanceData(const IfcEntityInstanceData& data)
 
 AttributeValue IfcEntityInstanceData::get_attribute_value(size_t index) const
 {
+    ensure_parsed();
     return { &storage_, (uint8_t) index };
 }
 
+void IfcEntityInstanceData::parse_deferred_() const {
+    IfcUtil::IfcBaseClass* instance = unparsed_.load(std::memory_order_acquire);
+    if (instance != nullptr) {
+        instance->file_->parse_deferred_(instance, const_cast<IfcEntityInstanceData&>(*this));
+    }
+}
+
 
 template void IFC_PARSE_API IfcUtil::IfcBaseClass::set_attribute_value<Blank>(size_t index, const Blank& value);
 template void IFC_PARSE_API IfcUtil::IfcBaseClass::set_attribute_value<int>(size_t index, const int& value);
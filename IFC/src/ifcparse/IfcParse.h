@@ -40,6 +40,7 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #if defined(IFCOPENSHELL_BRANCH) && defined(IFCOPENSHELL_COMMIT)
@@ -130,6 +131,10 @@ class IFC_PARSE_API TokenFunc {
     static std::string asString(const Token& token);
     /// Returns the token as a string in internal buffer (for optimization purposes)
     static const std::string& asStringRef(const Token& token);
+    /// Returns the token as a view on the file buffer when it contains no escape sequences,
+    /// whitespace or line breaks, otherwise a view on the internal buffer of asStringRef().
+    /// In the latter case the view is only valid until the next token is converted.
+    static std::string_view asStringView(const Token& token);
     /// Returns the token as a string (without the dot or apostrophe)
     static boost::dynamic_bitset<> asBinary(const Token& token);
     /// Returns a string representation of the token (including the dot or apostrophe)
@@ -162,6 +167,9 @@ class IFC_PARSE_API IfcSpfLexer {
     Token Next();
     ~IfcSpfLexer();
     void TokenString(unsigned int offset, std::string& result);
+    /// Sets view to the token at offset as it appears in the stream buffer,
+    /// returns false when it needs to be decoded by TokenString() instead
+    bool TokenView(unsigned int offset, std::string_view& view) const;
 };
 
 IFC_PARSE_API IfcEntityInstanceData read(unsigned int index, IfcFile* file);
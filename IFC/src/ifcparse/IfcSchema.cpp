@@ -22,6 +22,7 @@
 #include "IfcBaseClass.h"
 
 #include <map>
+#include <numeric>
 
 #ifdef HAS_SCHEMA_2x3
 #include "Ifc2x3.h"
@@ -142,9 +143,67 @@ IfcParse::schema_definition::schema_definition(const std::string& name, const st
             entities_.push_back((**it).as_entity());
         }
     }
+    build_name_hash_();
     schemas[name_] = this;
 }
 
+void IfcParse::schema_definition::build_name_hash_() {
+    // Hash and displace: names are distributed over buckets of on average four
+    // by their hash. Then for every bucket, largest first, a seed is searched
+    // that maps all of its names to unoccupied slots in a table at most half full.
+    size_t num_slots = 1;
+    while (num_slots < declarations_.size() * 2) {
+        num_slots <<= 1;
+    }
+    size_t num_buckets = 1;
+    while (num_buckets * 4 < declarations_.size()) {
+        num_buckets <<= 1;
+    }
+
+    name_hash_seeds_.assign(num_buckets, 0);
+    declarations_by_hash_.assign(num_slots, nullptr);
+
+    std::vector<std::vector<std::pair<uint64_t, const declaration*>>> buckets(num_buckets);
+    for (const auto* decl : declarations_) {
+        const uint64_t hash = hash_name_(decl->name_uc());
+        buckets[hash & (num_buckets - 1)].emplace_back(hash, decl);
+    }
+
+    std::vector<size_t> order(num_buckets);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    std::vector<size_t> slots;
+    for (size_t bucket : order) {
+        if (buckets[bucket].empty()) {
+            break;
+        }
+        for (uint32_t seed = 0;; ++seed) {
+            if (seed == (1U << 24)) {
+                // Only to be expected for names that are not unique
+                throw IfcParse::IfcException("Unable to construct name lookup for schema '" + name_ + "'");
+            }
+            slots.clear();
+            for (const auto& hash_decl : buckets[bucket]) {
+                const size_t slot = hash_slot_(hash_decl.first, seed, num_slots);
+                if (declarations_by_hash_[slot] != nullptr || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (slots.size() == buckets[bucket].size()) {
+                for (size_t i = 0; i < slots.size(); ++i) {
+                    declarations_by_hash_[slots[i]] = buckets[bucket][i].second;
+                }
+                name_hash_seeds_[bucket] = seed;
+                break;
+            }
+        }
+    }
+}
+
 IfcParse::schema_definition::~schema_definition() {
     for (std::vector<const declaration*>::const_iterator it = declarations_.begin(); it != declarations_.end(); ++it) {
         delete *it;
@@ -25,8 +25,10 @@
 #include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <cctype>
+#include <cstdint>
 #include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Forward declarations
@@ -236,6 +238,18 @@ class IFC_PARSE_API enumeration_type : public declaration {
         throw IfcParse::IfcException("Unable to find keyword in schema: " + string);
     }
 
+#ifndef SWIG
+    size_t lookup_enum_offset(std::string_view string) const {
+        size_t index = 0;
+        for (auto it = enumeration_items_.begin(); it != enumeration_items_.end(); ++it, ++index) {
+            if (string == *it) {
+                return index;
+            }
+        }
+        throw IfcParse::IfcException("Unable to find keyword in schema: " + std::string(string));
+    }
+#endif
+
     virtual const enumeration_type* as_enumeration_type() const { return this; }
 };
 
@@ -455,12 +469,35 @@ class IFC_PARSE_API schema_definition {
     std::vector<const enumeration_type*> enumeration_types_;
     std::vector<const entity*> entities_;
 
-    class declaration_by_name_cmp {
-      public:
-        bool operator()(const declaration* decl, const std::string& name) {
-            return decl->name_uc() < name;
+    // Perfect hash of the case-folded declaration names, constructed by
+    // build_name_hash_(): the name hash selects a bucket, the bucket seed
+    // then maps every name in the bucket to its own slot.
+    std::vector<uint32_t> name_hash_seeds_;
+    std::vector<const declaration*> declarations_by_hash_;
+
+    static char to_upper_ascii_(char character) {
+        return (character >= 'a' && character <= 'z') ? (char)(character - 'a' + 'A') : character;
+    }
+
+    static uint64_t hash_name_(std::string_view name) {
+        // FNV-1a over the upper-cased name
+        uint64_t hash = 14695981039346656037ULL;
+        for (char character : name) {
+            hash ^= (unsigned char)to_upper_ascii_(character);
+            hash *= 1099511628211ULL;
         }
-    };
+        return hash;
+    }
+
+    static size_t hash_slot_(uint64_t hash, uint32_t seed, size_t num_slots) {
+        hash ^= seed * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        return (size_t)hash & (num_slots - 1);
+    }
+
+    void build_name_hash_();
 
     class declaration_by_index_sort {
       public:
@@ -471,30 +508,34 @@ class IFC_PARSE_API schema_definition {
 
     instance_factory* factory_;
 
-    std::string& temp_string_() const {
-        static my_thread_local std::string string;
-        return string;
-    }
-
   public:
     schema_definition(const std::string& name, const std::vector<const declaration*>& declarations, instance_factory* factory);
 
     ~schema_definition();
 
     const declaration* declaration_by_name(const std::string& name) const {
-        const std::string* name_ptr = &name;
-        if (std::any_of(name.begin(), name.end(), [](char character) { return std::islower(character); })) {
-            temp_string_() = name;
-            boost::to_upper(temp_string_());
-            name_ptr = &temp_string_();
-        }
-        std::vector<const declaration*>::const_iterator iter = std::lower_bound(declarations_.begin(), declarations_.end(), *name_ptr, declaration_by_name_cmp());
-        if (iter == declarations_.end() || (**iter).name_uc() != *name_ptr) {
-            throw IfcParse::IfcException("Entity with name '" + name + "' not found in schema '" + name_ + "'");
+        return declaration_by_name(std::string_view(name));
+    }
+
+#ifndef SWIG
+    /// Looks up a declaration by a name of arbitrary case, such as a keyword
+    /// token viewed directly in the file buffer, without copying it.
+    const declaration* declaration_by_name(std::string_view name) const {
+        const uint64_t hash = hash_name_(name);
+        const uint32_t seed = name_hash_seeds_[hash & (name_hash_seeds_.size() - 1)];
+        const declaration* decl = declarations_by_hash_[hash_slot_(hash, seed, declarations_by_hash_.size())];
+        if (decl == nullptr || decl->name_uc().size() != name.size() ||
+            !std::equal(name.begin(), name.end(), decl->name_uc().begin(), [](char lhs, char rhs) { return to_upper_ascii_(lhs) == rhs; })) {
+            throw IfcParse::IfcException("Entity with name '" + std::string(name) + "' not found in schema '" + name_ + "'");
         }
-        return *iter;
+        return decl;
     }
 
+    const declaration* declaration_by_name(const char* name) const {
+        return declaration_by_name(std::string_view(name));
+    }
+#endif
+
     const declaration* declaration_by_name(size_t name) const {
         return declarations_.at(name);
     }
@@ -0,0 +1,923 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "IfcSnapshot.h"
+
+#include "IfcBaseClass.h"
+#include "IfcException.h"
+#include "IfcFile.h"
+#include "IfcLogger.h"
+#include "IfcParse.h"
+#include "IfcSpfStream.h"
+#include "utils.h"
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#ifdef USE_MMAP
+#include <boost/iostreams/device/mapped_file.hpp>
+#ifdef _MSC_VER
+#include <boost/filesystem/path.hpp>
+#endif
+#endif
+
+// Initializes the "C" locale with which the lexer parses real numbers, defined in IfcParse.cpp
+void init_locale();
+
+using namespace IfcParse;
+
+namespace {
+
+// The tags of the attribute values are the variant indices of storage_t
+static_assert(std::is_same_v<storage_t, VariantArray<
+    Blank, Derived, int, bool, boost::logic::tribool, double, std::string, boost::dynamic_bitset<>, EnumerationReference, IfcUtil::IfcBaseClass*,
+    empty_aggregate_t, std::vector<int>, std::vector<double>, std::vector<std::string>, std::vector<boost::dynamic_bitset<>>, aggregate_of_instance::ptr,
+    empty_aggregate_of_aggregate_t, std::vector<std::vector<int>>, std::vector<std::vector<double>>, aggregate_of_aggregate_of_instance::ptr>>,
+    "The snapshot format needs to be updated along with storage_t");
+
+enum value_tag : uint8_t {
+    tag_blank,
+    tag_derived,
+    tag_int,
+    tag_bool,
+    tag_logical,
+    tag_double,
+    tag_string,
+    tag_binary,
+    tag_enumeration,
+    tag_instance,
+    tag_empty_aggregate,
+    tag_aggregate_of_int,
+    tag_aggregate_of_double,
+    tag_aggregate_of_string,
+    tag_aggregate_of_binary,
+    tag_aggregate_of_instance,
+    tag_empty_aggregate_of_aggregate,
+    tag_aggregate_of_aggregate_of_int,
+    tag_aggregate_of_aggregate_of_double,
+    tag_aggregate_of_aggregate_of_instance
+};
+
+const char snapshot_magic[8] = {'I', 'F', 'C', 'S', 'N', 'A', 'P', '1'};
+const uint32_t snapshot_version = 1;
+const uint32_t snapshot_byte_order = 0x01020304;
+
+// Index of a null instance reference
+const uint32_t null_index = std::numeric_limits<uint32_t>::max();
+
+struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t source_hash;
+    // Guards against a snapshot written by a library with other schema definitions
+    uint32_t num_declarations;
+    uint32_t max_id;
+};
+
+FILE* open_file(const std::string& path, bool write) {
+#ifdef _MSC_VER
+    return _wfopen(IfcUtil::path::from_utf8(path).c_str(), write ? L"wb" : L"rb");
+#else
+    return fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+}
+
+// Strings are stored as the offsets of their ends into a single blob
+struct string_column {
+    std::vector<uint64_t> ends;
+    std::string blob;
+
+    void push(const std::string& s) {
+        blob += s;
+        ends.push_back(blob.size());
+    }
+
+    void push(const boost::dynamic_bitset<>& bits) {
+        std::string s;
+        boost::to_string(bits, s);
+        push(s);
+    }
+};
+
+class snapshot_writer {
+  private:
+    FILE* file_;
+
+    void write_(const void* data, size_t size) {
+        if (size && fwrite(data, 1, size, file_) != size) {
+            throw IfcException("Unable to write snapshot");
+        }
+    }
+
+  public:
+    explicit snapshot_writer(FILE* file)
+        : file_(file) {}
+
+    void header(const snapshot_header& header) {
+        write_(&header, sizeof(header));
+    }
+
+    /// Writes the size in bytes followed by the data padded to a multiple of
+    /// eight bytes, so that all columns can be read in place when mapped.
+    void bytes(const void* data, size_t size) {
+        static const char padding[8] = {};
+        const uint64_t size64 = size;
+        write_(&size64, sizeof(size64));
+        write_(data, size);
+        write_(padding, (8 - size % 8) % 8);
+    }
+
+    template <typename T>
+    void column(const std::vector<T>& values) {
+        bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void column(const std::string& s) {
+        bytes(s.data(), s.size());
+    }
+
+    void column(const string_column& strings) {
+        column(strings.ends);
+        column(strings.blob);
+    }
+};
+
+// A bounds checked view on a column of the mapped snapshot that is read front to back
+template <typename T>
+class column_cursor {
+  private:
+    const T* begin_;
+    const T* ptr_;
+    const T* end_;
+
+  public:
+    column_cursor()
+        : begin_(nullptr), ptr_(nullptr), end_(nullptr) {}
+
+    column_cursor(const T* begin, size_t size)
+        : begin_(begin), ptr_(begin), end_(begin + size) {}
+
+    const T& next() {
+        if (ptr_ == end_) {
+            throw IfcException("Truncated snapshot column");
+        }
+        return *ptr_++;
+    }
+
+    size_t size() const { return end_ - begin_; }
+    size_t remaining() const { return end_ - ptr_; }
+    bool at_end() const { return ptr_ == end_; }
+    const T* begin() const { return begin_; }
+    const T& operator[](size_t i) const { return begin_[i]; }
+};
+
+class string_cursor {
+  private:
+    column_cursor<uint64_t> ends_;
+    const char* blob_;
+    size_t blob_size_;
+    uint64_t begin_ = 0;
+
+  public:
+    string_cursor()
+        : blob_(nullptr), blob_size_(0) {}
+
+    string_cursor(column_cursor<uint64_t> ends, column_cursor<char> blob)
+        : ends_(ends), blob_(blob.begin()), blob_size_(blob.size()) {}
+
+    std::string next() {
+        const uint64_t end = ends_.next();
+        if (end < begin_ || end > blob_size_) {
+            throw IfcException("Invalid snapshot string offset");
+        }
+        std::string s(blob_ + begin_, blob_ + end);
+        begin_ = end;
+        return s;
+    }
+
+    size_t remaining() const { return ends_.remaining(); }
+};
+
+class snapshot_reader {
+  private:
+    const char* ptr_;
+    const char* end_;
+
+  public:
+    snapshot_reader(const char* data, size_t size)
+        : ptr_(data), end_(data + size) {}
+
+    const snapshot_header* header() {
+        if ((size_t)(end_ - ptr_) < sizeof(snapshot_header)) {
+            return nullptr;
+        }
+        auto* header = reinterpret_cast<const snapshot_header*>(ptr_);
+        ptr_ += sizeof(snapshot_header);
+        return header;
+    }
+
+    template <typename T>
+    column_cursor<T> column() {
+        uint64_t size;
+        if (end_ - ptr_ < (ptrdiff_t)sizeof(size)) {
+            throw IfcException("Truncated snapshot");
+        }
+        memcpy(&size, ptr_, sizeof(size));
+        ptr_ += sizeof(size);
+        const uint64_t padded = size + (8 - size % 8) % 8;
+        if (size % sizeof(T) != 0 || padded > (uint64_t)(end_ - ptr_)) {
+            throw IfcException("Truncated snapshot");
+        }
+        column_cursor<T> cursor(reinterpret_cast<const T*>(ptr_), size / sizeof(T));
+        ptr_ += padded;
+        return cursor;
+    }
+
+    std::string string() {
+        auto c = column<char>();
+        return std::string(c.begin(), c.size());
+    }
+
+    string_cursor strings() {
+        auto ends = column<uint64_t>();
+        return string_cursor(ends, column<char>());
+    }
+};
+
+// Assigns instance indices to the instances of a file in the order in which
+// they are written and records their attribute values in the value columns.
+class instance_encoder {
+  private:
+    // The instances with a name, in the order of their names, are found by a
+    // binary search on their name. Only the remaining instances are hashed.
+    std::vector<uint32_t> names_;
+    std::vector<IfcUtil::IfcBaseClass*> instances_;
+    std::unordered_map<const IfcUtil::IfcBaseClass*, uint32_t> indices_;
+
+  public:
+    std::vector<uint32_t> types;
+    std::vector<uint8_t> sizes;
+    std::vector<uint8_t> tags;
+    std::vector<int32_t> ints;
+    std::vector<double> doubles;
+    std::vector<uint8_t> logicals;
+    string_column strings;
+    std::vector<uint32_t> enumeration_types;
+    std::vector<uint32_t> enumeration_values;
+    std::vector<uint32_t> references;
+    std::vector<uint32_t> lengths;
+
+    explicit instance_encoder(const IfcFile::entity_by_id_t& by_id) {
+        std::vector<std::pair<unsigned int, IfcUtil::IfcBaseClass*>> named(by_id.begin(), by_id.end());
+        std::sort(named.begin(), named.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        names_.reserve(named.size());
+        instances_.reserve(named.size());
+        for (const auto& p : named) {
+            names_.push_back(p.first);
+            instances_.push_back(p.second);
+        }
+    }
+
+    const std::vector<uint32_t>& names() const { return names_; }
+
+    // Returns the index of an instance that has already been added
+    bool find(const IfcUtil::IfcBaseClass* inst, uint32_t& index) const {
+        auto it = std::lower_bound(names_.begin(), names_.end(), inst->id());
+        if (it != names_.end() && *it == inst->id() && instances_[it - names_.begin()] == inst) {
+            index = (uint32_t)(it - names_.begin());
+            return true;
+        }
+        auto jt = indices_.find(inst);
+        if (jt == indices_.end()) {
+            return false;
+        }
+        index = jt->second;
+        return true;
+    }
+
+    uint32_t add(IfcUtil::IfcBaseClass* inst) {
+        if (inst == nullptr) {
+            return null_index;
+        }
+        uint32_t index;
+        if (find(inst, index)) {
+            return index;
+        }
+        index = (uint32_t)instances_.size();
+        instances_.push_back(inst);
+        indices_.insert({inst, index});
+        return index;
+    }
+
+    /// Encodes the instances added so far, instances referenced from their
+    /// attributes that have not been added yet are appended and encoded as well.
+    void encode() {
+        for (size_t i = 0; i < instances_.size(); ++i) {
+            const storage_t& storage = instances_[i]->data().storage_;
+            types.push_back((uint32_t)instances_[i]->declaration().index_in_schema());
+            sizes.push_back((uint8_t)storage.size());
+            for (size_t j = 0; j < (size_t)storage.size(); ++j) {
+                tags.push_back((uint8_t)storage.index(j));
+                storage.apply_visitor([this](const auto& v) {
+                    using U = std::decay_t<decltype(v)>;
+                    if constexpr (std::is_same_v<U, int>) {
+                        ints.push_back(v);
+                    } else if constexpr (std::is_same_v<U, bool>) {
+                        logicals.push_back(v ? 1 : 0);
+                    } else if constexpr (std::is_same_v<U, boost::logic::tribool>) {
+                        logicals.push_back(boost::logic::indeterminate(v) ? 2 : (v ? 1 : 0));
+                    } else if constexpr (std::is_same_v<U, double>) {
+                        doubles.push_back(v);
+                    } else if constexpr (std::is_same_v<U, std::string> || std::is_same_v<U, boost::dynamic_bitset<>>) {
+                        strings.push(v);
+                    } else if constexpr (std::is_same_v<U, EnumerationReference>) {
+                        enumeration_types.push_back((uint32_t)v.enumeration()->index_in_schema());
+                        enumeration_values.push_back((uint32_t)v.index());
+                    } else if constexpr (std::is_same_v<U, IfcUtil::IfcBaseClass*>) {
+                        references.push_back(add(v));
+                    } else if constexpr (std::is_same_v<U, std::vector<int>>) {
+                        lengths.push_back((uint32_t)v.size());
+                        ints.insert(ints.end(), v.begin(), v.end());
+                    } else if constexpr (std::is_same_v<U, std::vector<double>>) {
+                        lengths.push_back((uint32_t)v.size());
+                        doubles.insert(doubles.end(), v.begin(), v.end());
+                    } else if constexpr (std::is_same_v<U, std::vector<std::string>> || std::is_same_v<U, std::vector<boost::dynamic_bitset<>>>) {
+                        lengths.push_back((uint32_t)v.size());
+                        for (const auto& s : v) {
+                            strings.push(s);
+                        }
+                    } else if constexpr (std::is_same_v<U, aggregate_of_instance::ptr>) {
+                        lengths.push_back(v ? v->size() : 0);
+                        if (v) {
+                            for (auto* inst : *v) {
+                                references.push_back(add(inst));
+                            }
+                        }
+                    } else if constexpr (std::is_same_v<U, std::vector<std::vector<int>>> || std::is_same_v<U, std::vector<std::vector<double>>>) {
+                        lengths.push_back((uint32_t)v.size());
+                        for (const auto& inner : v) {
+                            lengths.push_back((uint32_t)inner.size());
+                            for (const auto& x : inner) {
+                                if constexpr (std::is_same_v<U, std::vector<std::vector<int>>>) {
+                                    ints.push_back(x);
+                                } else {
+                                    doubles.push_back(x);
+                                }
+                            }
+                        }
+                    } else if constexpr (std::is_same_v<U, aggregate_of_aggregate_of_instance::ptr>) {
+                        lengths.push_back(v ? (uint32_t)v->size() : 0);
+                        if (v) {
+                            for (const auto& inner : *v) {
+                                lengths.push_back((uint32_t)inner.size());
+                                for (auto* inst : inner) {
+                                    references.push_back(add(inst));
+                                }
+                            }
+                        }
+                    }
+                }, j);
+            }
+        }
+    }
+};
+
+} // namespace
+
+uint64_t IfcSnapshot::hash(const std::string& path) {
+    FILE* f = open_file(path, false);
+    if (f == nullptr) {
+        return 0;
+    }
+
+    // Four independent lanes over eight byte words, so that the hash is
+    // computed at about the speed with which the file can be read.
+    const uint64_t prime_1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t prime_2 = 0xC2B2AE3D27D4EB4FULL;
+    uint64_t lanes[4] = {prime_1 + prime_2, prime_2, 0, 0 - prime_1};
+    auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+
+    std::vector<uint64_t> chunk(1 << 17);
+    uint64_t total = 0;
+    size_t n;
+    while ((n = fread(chunk.data(), 1, chunk.size() * sizeof(uint64_t), f)) > 0) {
+        total += n;
+        if (n % 8) {
+            memset(reinterpret_cast<char*>(chunk.data()) + n, 0, 8 - n % 8);
+        }
+        const size_t words = (n + 7) / 8;
+        for (size_t i = 0; i < words; ++i) {
+            uint64_t& lane = lanes[i & 3];
+            lane = rotl(lane + chunk[i] * prime_2, 31) * prime_1;
+        }
+    }
+    fclose(f);
+
+    uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    h ^= total;
+    h ^= h >> 33;
+    h *= prime_2;
+    h ^= h >> 29;
+    return h;
+}
+
+void IfcSnapshot::write(IfcFile& file, const std::string& path, uint64_t source_hash) {
+    // Instances with a name first, in the order of their names, followed by
+    // the simple type instances registered with the file.
+    instance_encoder encoder(file.byid_);
+
+    std::vector<std::pair<uint32_t, IfcUtil::IfcBaseClass*>> by_identity(file.byidentity_.begin(), file.byidentity_.end());
+    std::sort(by_identity.begin(), by_identity.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<uint32_t> identities;
+    for (const auto& p : by_identity) {
+        identities.push_back(encoder.add(p.second));
+    }
+
+    // This appends the simple type instances that are only referenced from attributes
+    encoder.encode();
+
+    uint32_t index;
+
+    std::vector<uint32_t> type_keys, type_counts, type_members;
+    for (const auto& p : file.bytype_excl_) {
+        type_keys.push_back((uint32_t)p.first->index_in_schema());
+        size_t count = 0;
+        if (p.second) {
+            for (auto* inst : *p.second) {
+                if (encoder.find(inst, index)) {
+                    type_members.push_back(index);
+                    ++count;
+                }
+            }
+        }
+        type_counts.push_back((uint32_t)count);
+    }
+
+    string_column guid_keys;
+    std::vector<uint32_t> guid_instances;
+    for (const auto& p : file.byguid_) {
+        if (encoder.find(p.second, index)) {
+            guid_keys.push(p.first);
+            guid_instances.push_back(index);
+        }
+    }
+
+    std::vector<int32_t> inverse_keys, inverse_ids;
+    std::vector<uint32_t> inverse_counts;
+    std::vector<int16_t> inverse_types, inverse_attributes;
+    // Pending additions and removals are merged by for_each(), the index is not modified
+    for (int key : file.byref_excl_.referenced()) {
+        const size_t begin = inverse_ids.size();
+        file.byref_excl_.for_each(key, [&](const inverse_index::reference& ref) {
+            inverse_ids.push_back(ref.id);
+            inverse_types.push_back(ref.type);
+            inverse_attributes.push_back(ref.attribute);
+        });
+        inverse_keys.push_back(key);
+        inverse_counts.push_back((uint32_t)(inverse_ids.size() - begin));
+    }
+
+    std::ostringstream spf_header;
+    file.header().write(spf_header);
+
+    snapshot_header header;
+    memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.byte_order = snapshot_byte_order;
+    header.source_hash = source_hash;
+    header.num_declarations = (uint32_t)file.schema()->declarations().size();
+    header.max_id = file.getMaxId();
+
+    // Written to a temporary file first, so that a snapshot that is read is always complete
+    const std::string temp_path = path + ".tmp";
+    FILE* f = open_file(temp_path, true);
+    if (f == nullptr) {
+        throw IfcException("Unable to open snapshot '" + path + "' for writing");
+    }
+    try {
+        snapshot_writer w(f);
+        w.header(header);
+        w.column(file.schema()->name());
+        w.column(spf_header.str());
+
+        w.column(encoder.names());
+        w.column(encoder.types);
+        w.column(encoder.sizes);
+        w.column(encoder.tags);
+        w.column(encoder.ints);
+        w.column(encoder.doubles);
+        w.column(encoder.logicals);
+        w.column(encoder.strings);
+        w.column(encoder.enumeration_types);
+        w.column(encoder.enumeration_values);
+        w.column(encoder.references);
+        w.column(encoder.lengths);
+        w.column(identities);
+
+        w.column(type_keys);
+        w.column(type_counts);
+        w.column(type_members);
+
+        w.column(guid_keys);
+        w.column(guid_instances);
+
+        w.column(inverse_keys);
+        w.column(inverse_counts);
+        w.column(inverse_ids);
+        w.column(inverse_types);
+        w.column(inverse_attributes);
+    } catch (...) {
+        fclose(f);
+        IfcUtil::path::delete_file(temp_path);
+        throw;
+    }
+    if (fclose(f) != 0 || !IfcUtil::path::rename_file(temp_path, path)) {
+        IfcUtil::path::delete_file(temp_path);
+        throw IfcException("Unable to write snapshot '" + path + "'");
+    }
+}
+
+IfcFile* IfcSnapshot::read(const std::string& path, uint64_t source_hash) {
+#ifdef USE_MMAP
+    boost::iostreams::mapped_file_source mapped;
+    try {
+#ifdef _MSC_VER
+        mapped.open(boost::filesystem::wpath(IfcUtil::path::from_utf8(path)));
+#else
+        mapped.open(path);
+#endif
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+    if (!mapped.is_open()) {
+        return nullptr;
+    }
+    snapshot_reader reader(mapped.data(), mapped.size());
+#else
+    FILE* f = open_file(path, false);
+    if (f == nullptr) {
+        return nullptr;
+    }
+    fseek(f, 0, SEEK_END);
+    const size_t size = (size_t)ftell(f);
+    rewind(f);
+    // Eight byte words, for the columns to be aligned
+    std::vector<uint64_t> buffer((size + 7) / 8);
+    const size_t read_size = fread(buffer.data(), 1, size, f);
+    fclose(f);
+    if (read_size != size) {
+        return nullptr;
+    }
+    snapshot_reader reader(reinterpret_cast<const char*>(buffer.data()), size);
+#endif
+
+    const snapshot_header* header = reader.header();
+    if (header == nullptr ||
+        memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) != 0 ||
+        header->version != snapshot_version ||
+        header->byte_order != snapshot_byte_order) {
+        Logger::Warning("Ignoring invalid snapshot '" + path + "'");
+        return nullptr;
+    }
+    if (header->source_hash != source_hash) {
+        Logger::Notice("Snapshot '" + path + "' is out of date");
+        return nullptr;
+    }
+
+    std::unique_ptr<IfcFile> file;
+    std::vector<IfcUtil::IfcBaseClass*> instances;
+    size_t num_named = 0;
+
+    try {
+        const schema_definition* schema = schema_by_name(reader.string());
+        if (schema->declarations().size() != header->num_declarations) {
+            Logger::Warning("Ignoring snapshot '" + path + "' written for other schema definitions");
+            return nullptr;
+        }
+
+        file.reset(new IfcFile(schema));
+        file->MaxId = header->max_id;
+
+        {
+            // The header is stored as SPF and read by the regular header parser
+            init_locale();
+            const std::string spf_header = reader.string();
+            char* data = new char[spf_header.size()];
+            memcpy(data, spf_header.data(), spf_header.size());
+            IfcSpfStream stream(data, (int)spf_header.size());
+            file->stream = &stream;
+            file->tokens = new IfcSpfLexer(&stream, file.get());
+            file->header().file(file.get());
+            const bool header_read = file->header().tryRead();
+            delete file->tokens;
+            file->tokens = nullptr;
+            file->stream = nullptr;
+            if (!header_read) {
+                throw IfcException("Invalid header");
+            }
+        }
+
+        auto names = reader.column<uint32_t>();
+        auto types = reader.column<uint32_t>();
+        auto sizes = reader.column<uint8_t>();
+        auto tags = reader.column<uint8_t>();
+        auto ints = reader.column<int32_t>();
+        auto doubles = reader.column<double>();
+        auto logicals = reader.column<uint8_t>();
+        auto strings = reader.strings();
+        auto enumeration_types = reader.column<uint32_t>();
+        auto enumeration_values = reader.column<uint32_t>();
+        auto references = reader.column<uint32_t>();
+        auto lengths = reader.column<uint32_t>();
+        auto identities = reader.column<uint32_t>();
+
+        if (sizes.size() != types.size() || names.size() > types.size()) {
+            throw IfcException("Inconsistent instance columns");
+        }
+        num_named = names.size();
+
+        ::impl::arena_scope arena_scope(IfcFile::arena_allocation_ ? &file->arena_ : nullptr);
+
+        // All instances are created before their attributes are filled, as
+        // references can point forward.
+        instances.reserve(types.size());
+        file->byid_.reserve(num_named);
+        for (size_t i = 0; i < types.size(); ++i) {
+            const declaration* decl = schema->declaration_by_name((size_t)types[i]);
+            auto* inst = schema->instantiate(decl, IfcEntityInstanceData(storage_t(sizes[i])));
+            inst->file_ = file.get();
+            if (i < num_named) {
+                inst->id_ = names[i];
+                file->byid_[names[i]] = inst;
+            }
+            instances.push_back(inst);
+        }
+
+        auto instance = [&instances, &references]() -> IfcUtil::IfcBaseClass* {
+            const uint32_t index = references.next();
+            if (index == null_index) {
+                return nullptr;
+            }
+            if (index >= instances.size()) {
+                throw IfcException("Invalid snapshot instance reference");
+            }
+            return instances[index];
+        };
+
+        auto logical = [&logicals]() -> boost::logic::tribool {
+            const uint8_t v = logicals.next();
+            return v == 2 ? boost::logic::tribool(boost::logic::indeterminate) : boost::logic::tribool(v == 1);
+        };
+
+        // The length of an aggregate, which cannot exceed the values that remain in its column
+        auto length = [&lengths](size_t remaining) -> uint32_t {
+            const uint32_t n = lengths.next();
+            if (n > remaining) {
+                throw IfcException("Invalid snapshot aggregate length");
+            }
+            return n;
+        };
+
+        for (auto* inst : instances) {
+            storage_t& storage = inst->data().storage_;
+            for (size_t j = 0; j < (size_t)storage.size(); ++j) {
+                switch (tags.next()) {
+                case tag_blank:
+                    break;
+                case tag_derived:
+                    storage.set(j, Derived{});
+                    break;
+                case tag_int:
+                    storage.set(j, (int)ints.next());
+                    break;
+                case tag_bool:
+                    storage.set(j, logicals.next() == 1);
+                    break;
+                case tag_logical:
+                    storage.set(j, logical());
+                    break;
+                case tag_double:
+                    storage.set(j, doubles.next());
+                    break;
+                case tag_string:
+                    storage.set(j, strings.next());
+                    break;
+                case tag_binary:
+                    storage.set(j, boost::dynamic_bitset<>(strings.next()));
+                    break;
+                case tag_enumeration: {
+                    const auto* enumeration = schema->declaration_by_name((size_t)enumeration_types.next())->as_enumeration_type();
+                    const uint32_t value = enumeration_values.next();
+                    if (enumeration == nullptr || value >= enumeration->enumeration_items().size()) {
+                        throw IfcException("Invalid snapshot enumeration value");
+                    }
+                    storage.set(j, EnumerationReference(enumeration, value));
+                    break;
+                }
+                case tag_instance:
+                    storage.set(j, instance());
+                    break;
+                case tag_empty_aggregate:
+                    storage.set(j, empty_aggregate_t{});
+                    break;
+                case tag_aggregate_of_int: {
+                    std::vector<int> v(length(ints.remaining()));
+                    for (auto& x : v) {
+                        x = ints.next();
+                    }
+                    storage.set(j, std::move(v));
+                    break;
+                }
+                case tag_aggregate_of_double: {
+                    std::vector<double> v(length(doubles.remaining()));
+                    for (auto& x : v) {
+                        x = doubles.next();
+                    }
+                    storage.set(j, std::move(v));
+                    break;
+                }
+                case tag_aggregate_of_string: {
+                    std::vector<std::string> v(length(strings.remaining()));
+                    for (auto& x : v) {
+                        x = strings.next();
+                    }
+                    storage.set(j, std::move(v));
+                    break;
+                }
+                case tag_aggregate_of_binary: {
+                    std::vector<boost::dynamic_bitset<>> v(length(strings.remaining()));
+                    for (auto& x : v) {
+                        x = boost::dynamic_bitset<>(strings.next());
+                    }
+                    storage.set(j, std::move(v));
+                    break;
+                }
+                case tag_aggregate_of_instance: {
+                    const uint32_t n = length(references.remaining());
+                    aggregate_of_instance::ptr v(new aggregate_of_instance);
+                    v->reserve(n);
+                    for (uint32_t k = 0; k < n; ++k) {
+                        v->push(instance());
+                    }
+                    storage.set(j, v);
+                    break;
+                }
+                case tag_empty_aggregate_of_aggregate:
+                    storage.set(j, empty_aggregate_of_aggregate_t{});
+                    break;
+                case tag_aggregate_of_aggregate_of_int: {
+                    std::vector<std::vector<int>> v(length(lengths.remaining()));
+                    for (auto& inner : v) {
+                        inner.resize(length(ints.remaining()));
+                        for (auto& x : inner) {
+                            x = ints.next();
+                        }
+                    }
+                    storage.set(j, std::move(v));
+                    break;
+                }
+                case tag_aggregate_of_aggregate_of_double: {
+                    std::vector<std::vector<double>> v(length(lengths.remaining()));
+                    for (auto& inner : v) {
+                        inner.resize(length(doubles.remaining()));
+                        for (auto& x : inner) {
+                            x = doubles.next();
+                        }
+                    }
+                    storage.set(j, std::move(v));
+                    break;
+                }
+                case tag_aggregate_of_aggregate_of_instance: {
+                    const uint32_t n = length(lengths.remaining());
+                    aggregate_of_aggregate_of_instance::ptr v(new aggregate_of_aggregate_of_instance);
+                    for (uint32_t k = 0; k < n; ++k) {
+                        std::vector<IfcUtil::IfcBaseClass*> inner(length(references.remaining()));
+                        for (auto& x : inner) {
+                            x = instance();
+                        }
+                        v->push(inner);
+                    }
+                    storage.set(j, v);
+                    break;
+                }
+                default:
+                    throw IfcException("Invalid snapshot attribute tag");
+                }
+            }
+        }
+
+        if (!tags.at_end()) {
+            throw IfcException("Inconsistent attribute columns");
+        }
+
+        for (size_t i = 0; i < identities.size(); ++i) {
+            auto* inst = instances.at(identities[i]);
+            file->byidentity_[inst->identity()] = inst;
+        }
+
+        auto type_keys = reader.column<uint32_t>();
+        auto type_counts = reader.column<uint32_t>();
+        auto type_members = reader.column<uint32_t>();
+        for (size_t i = 0; i < type_keys.size(); ++i) {
+            const uint32_t n = type_counts.next();
+            if (n > type_members.remaining()) {
+                throw IfcException("Inconsistent type columns");
+            }
+            aggregate_of_instance::ptr members(new aggregate_of_instance);
+            members->reserve(n);
+            for (uint32_t k = 0; k < n; ++k) {
+                members->push(instances.at(type_members.next()));
+            }
+            file->bytype_excl_[schema->declaration_by_name((size_t)type_keys[i])] = members;
+        }
+
+        auto guid_keys = reader.strings();
+        auto guid_instances = reader.column<uint32_t>();
+        for (size_t i = 0; i < guid_instances.size(); ++i) {
+            file->byguid_[guid_keys.next()] = instances.at(guid_instances[i]);
+        }
+
+        // Appended in the order of the index, which compaction retains
+        auto inverse_keys = reader.column<int32_t>();
+        auto inverse_counts = reader.column<uint32_t>();
+        auto inverse_ids = reader.column<int32_t>();
+        auto inverse_types = reader.column<int16_t>();
+        auto inverse_attributes = reader.column<int16_t>();
+        if (inverse_types.size() != inverse_ids.size() || inverse_attributes.size() != inverse_ids.size()) {
+            throw IfcException("Inconsistent inverse columns");
+        }
+        for (size_t i = 0; i < inverse_keys.size(); ++i) {
+            const uint32_t n = inverse_counts.next();
+            for (uint32_t k = 0; k < n; ++k) {
+                file->byref_excl_.append(inverse_keys[i], inverse_types.next(), inverse_attributes.next(), inverse_ids.next());
+            }
+        }
+        file->compact_inverses_if_needed_();
+    } catch (const std::exception& e) {
+        Logger::Warning("Ignoring invalid snapshot '" + path + "': " + e.what());
+        // Instances without a name are not owned by the file
+        for (size_t i = num_named; file && i < instances.size(); ++i) {
+            if (file->byidentity_.find(instances[i]->identity()) == file->byidentity_.end()) {
+                delete instances[i];
+            }
+        }
+        return nullptr;
+    }
+
+    return file.release();
+}
+
+#ifdef USE_MMAP
+IfcFile* IfcSnapshot::open(const std::string& path, const std::string& snapshot_path, bool mmap, unsigned int parse_threads) {
+#else
+IfcFile* IfcSnapshot::open(const std::string& path, const std::string& snapshot_path, unsigned int parse_threads) {
+#endif
+    const uint64_t source_hash = hash(path);
+
+    if (IfcFile* file = read(snapshot_path, source_hash)) {
+        Logger::Status("Read snapshot '" + snapshot_path + "'");
+        return file;
+    }
+
+#ifdef USE_MMAP
+    IfcFile* file = new IfcFile(path, mmap, parse_threads);
+#else
+    IfcFile* file = new IfcFile(path, parse_threads);
+#endif
+
+    if (file->good()) {
+        try {
+            write(*file, snapshot_path, source_hash);
+            Logger::Status("Wrote snapshot '" + snapshot_path + "'");
+        } catch (const std::exception& e) {
+            Logger::Warning(e);
+        }
+    }
+
+    return file;
+}
@@ -0,0 +1,74 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/*********************************************************************************
+ *                                                                               *
+ * Stores a parsed file in a binary snapshot from which it can be                *
+ * reopened without tokenizing, parsing and resolving the SPF file again         *
+ *                                                                               *
+ ********************************************************************************/
+
+#ifndef IFCSNAPSHOT_H
+#define IFCSNAPSHOT_H
+
+#include "ifc_parse_api.h"
+
+#include <cstdint>
+#include <string>
+
+namespace IfcParse {
+
+class IfcFile;
+
+/// A snapshot stores the instances of a file column-wise: the names, types and
+/// attribute counts of all instances, the variant index of every attribute
+/// value and a column per primitive value type, in which references to other
+/// instances are stored as indices into the instance columns. The header, the
+/// instances by type, the GlobalId map and the inverse references are stored
+/// as well, so that reading a snapshot restores the file without a reparse.
+///
+/// A snapshot records the hash of the SPF file it was created from and is
+/// considered stale when the hash of the file no longer matches. Snapshots are
+/// tied to the byte order and the schema definitions of the library that
+/// wrote them and are not meant to be exchanged.
+class IFC_PARSE_API IfcSnapshot {
+  public:
+    /// Returns a hash of the contents of the file at path, 0 when it cannot be read
+    static uint64_t hash(const std::string& path);
+
+    /// Writes file to a snapshot at path. Throws an IfcException when the
+    /// snapshot cannot be written.
+    static void write(IfcFile& file, const std::string& path, uint64_t source_hash);
+
+    /// Reads the snapshot at path, returns null when there is no valid
+    /// snapshot at path for the source file with source_hash.
+    static IfcFile* read(const std::string& path, uint64_t source_hash);
+
+    /// Opens the SPF file at path from the snapshot at snapshot_path when it is
+    /// up to date. Otherwise the SPF file is parsed and the snapshot is written.
+#ifdef USE_MMAP
+    static IfcFile* open(const std::string& path, const std::string& snapshot_path, bool mmap = false, unsigned int parse_threads = 1);
+#else
+    static IfcFile* open(const std::string& path, const std::string& snapshot_path, unsigned int parse_threads = 1);
+#endif
+};
+
+} // namespace IfcParse
+
+#endif
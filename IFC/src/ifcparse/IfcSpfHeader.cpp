@@ -93,18 +93,22 @@ void IfcSpfHeader::read() {
 
     readTerminal(FILE_DESCRIPTION, NONE);
     delete file_description_;
+    // Reset first, the constructors throw on invalid input
+    file_description_ = nullptr;
     // readParen();
     file_description_ = new FileDescription(file_);
     readSemicolon();
 
     readTerminal(FILE_NAME, NONE);
     delete file_name_;
+    file_name_ = nullptr;
     // readParen();
     file_name_ = new FileName(file_);
     readSemicolon();
 
     readTerminal(FILE_SCHEMA, NONE);
     delete file_schema_;
+    file_schema_ = nullptr;
     // readParen();
     file_schema_ = new FileSchema(file_);
     readSemicolon();
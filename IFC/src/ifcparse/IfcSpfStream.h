@@ -48,6 +48,7 @@ class IFC_PARSE_API IfcSpfStream {
     const char* buffer_;
     unsigned int ptr_;
     unsigned int len_;
+    bool owns_buffer_ = true;
 
   public:
     bool valid;
@@ -60,6 +61,9 @@ class IFC_PARSE_API IfcSpfStream {
 #endif
     IfcSpfStream(std::istream& stream, int length);
     IfcSpfStream(void* data, int length);
+    /// Creates a non-owning view on the range [begin, end) of the buffer of
+    /// another stream, so that chunks can be read independently of each other
+    IfcSpfStream(const IfcSpfStream& other, unsigned int begin, unsigned int end);
     ~IfcSpfStream();
     /// Returns the character at the cursor
     char Peek();
@@ -67,15 +71,30 @@ class IFC_PARSE_API IfcSpfStream {
     char Read(unsigned int offset);
     /// Increment the file cursor and reads new page if necessary
     void Inc();
+    /// Moves the file cursor n characters ahead, the skipped range is
+    /// assumed not to contain line breaks.
+    void Skip(unsigned int n);
     void Close();
     /// Moves the file cursor to an arbitrary offset in the file
     void Seek(unsigned int offset);
     /// Returns the cursor position
     unsigned int Tell() const;
+    /// Returns the offset one past the last character of the stream
+    unsigned int End() const { return len_; }
+    /// Returns the underlying character buffer
+    const char* Buffer() const { return buffer_; }
 
     bool is_eof_at(unsigned int) const;
     void increment_at(unsigned int&);
     char peek_at(unsigned int);
+
+    /// Returns the length of the run of characters starting at offset that can
+    /// not end a token: anything but ()=,;/ apostrophes and line breaks.
+    unsigned int token_run_at(unsigned int) const;
+    /// Returns the length of the run of characters starting at offset that
+    /// need no decoding within a string: anything but apostrophes, backslashes
+    /// and line breaks.
+    unsigned int string_run_at(unsigned int) const;
 };
 } // namespace IfcParse
 
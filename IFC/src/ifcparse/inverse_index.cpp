@@ -0,0 +1,243 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+
+#include "inverse_index.h"
+
+#include <algorithm>
+#include <limits>
+
+using IfcParse::inverse_index;
+
+namespace {
+// The delta and the removed references are merged into the flat arrays when
+// they exceed a fraction of the flat arrays, to amortize the cost of merging.
+const size_t min_compaction_size = 1024;
+} // namespace
+
+std::pair<size_t, size_t> inverse_index::range_(int referenced) const {
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), referenced);
+    if (it == keys_.end() || *it != referenced) {
+        return {0, 0};
+    }
+    const size_t index = std::distance(keys_.begin(), it);
+    return {offsets_[index], offsets_[index + 1]};
+}
+
+inverse_index::key_t inverse_index::first_key_(int referenced) {
+    return {referenced, std::numeric_limits<short>::min(), std::numeric_limits<short>::min()};
+}
+
+inverse_index::key_t inverse_index::last_key_(int referenced) {
+    return {referenced, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()};
+}
+
+void inverse_index::append(inverse_index& other) {
+    if (appended_.empty()) {
+        appended_.swap(other.appended_);
+    } else {
+        appended_.insert(appended_.end(), other.appended_.begin(), other.appended_.end());
+        other.appended_.clear();
+        other.appended_.shrink_to_fit();
+    }
+}
+
+void inverse_index::add(int referenced, short type, short attribute, int id) {
+    delta_[{referenced, type, attribute}].push_back(id);
+    ++delta_size_;
+}
+
+void inverse_index::remove(int referenced, short type, short attribute, int id) {
+    auto range = range_(referenced);
+    for (size_t i = range.first; i < range.second; ++i) {
+        auto& ref = references_[i];
+        if (ref.id == id && ref.type == type && ref.attribute == attribute) {
+            ref = {nullptr, 0, type, attribute};
+            ++removed_;
+            return;
+        }
+    }
+    auto it = delta_.find({referenced, type, attribute});
+    if (it != delta_.end()) {
+        auto jt = std::find(it->second.begin(), it->second.end(), id);
+        if (jt != it->second.end()) {
+            it->second.erase(jt);
+            --delta_size_;
+            if (it->second.empty()) {
+                delta_.erase(it);
+            }
+        }
+    }
+}
+
+void inverse_index::remove_references_to(int referenced) {
+    auto range = range_(referenced);
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (references_[i].id != 0) {
+            references_[i].id = 0;
+            references_[i].instance = nullptr;
+            ++removed_;
+        }
+    }
+    auto begin = delta_.lower_bound(first_key_(referenced));
+    auto end = delta_.upper_bound(last_key_(referenced));
+    for (auto it = begin; it != end; ++it) {
+        delta_size_ -= it->second.size();
+    }
+    delta_.erase(begin, end);
+}
+
+void inverse_index::remove_references_from(int referenced, int id) {
+    auto range = range_(referenced);
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (references_[i].id == id) {
+            references_[i].id = 0;
+            references_[i].instance = nullptr;
+            ++removed_;
+        }
+    }
+    for (auto it = delta_.lower_bound(first_key_(referenced)); it != delta_.upper_bound(last_key_(referenced));) {
+        auto& ids = it->second;
+        const size_t size_before = ids.size();
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+        delta_size_ -= size_before - ids.size();
+        if (ids.empty()) {
+            it = delta_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void inverse_index::remove_if(const std::function<bool(int, int)>& pred) {
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        for (size_t j = offsets_[i]; j < offsets_[i + 1]; ++j) {
+            if (references_[j].id != 0 && pred(keys_[i], references_[j].id)) {
+                references_[j].id = 0;
+                references_[j].instance = nullptr;
+                ++removed_;
+            }
+        }
+    }
+    for (auto it = delta_.begin(); it != delta_.end();) {
+        const int referenced = std::get<0>(it->first);
+        const size_t size_before = it->second.size();
+        it->second.erase(std::remove_if(it->second.begin(), it->second.end(), [&pred, referenced](int id) {
+                             return pred(referenced, id);
+                         }),
+                         it->second.end());
+        delta_size_ -= size_before - it->second.size();
+        if (it->second.empty()) {
+            it = delta_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool inverse_index::needs_compaction() const {
+    return !appended_.empty() ||
+           delta_size_ > min_compaction_size + references_.size() / 8 ||
+           removed_ > min_compaction_size + references_.size() / 4;
+}
+
+void inverse_index::compact(const resolver_t& resolver) {
+    // Existing references go first, so that for equal keys the stable sort
+    // below retains the order of insertion.
+    std::vector<std::pair<int, reference>> entries;
+    entries.reserve(references_.size() - removed_ + appended_.size() + delta_size_);
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        for (size_t j = offsets_[i]; j < offsets_[i + 1]; ++j) {
+            if (references_[j].id != 0) {
+                entries.emplace_back(keys_[i], references_[j]);
+            }
+        }
+    }
+    entries.insert(entries.end(), appended_.begin(), appended_.end());
+    for (const auto& pair : delta_) {
+        for (int id : pair.second) {
+            entries.push_back({std::get<0>(pair.first), {nullptr, id, std::get<1>(pair.first), std::get<2>(pair.first)}});
+        }
+    }
+    clear();
+
+    std::stable_sort(entries.begin(), entries.end(), [](const std::pair<int, reference>& lhs, const std::pair<int, reference>& rhs) {
+        return std::make_tuple(lhs.first, lhs.second.type, lhs.second.attribute) < std::make_tuple(rhs.first, rhs.second.type, rhs.second.attribute);
+    });
+
+    references_.reserve(entries.size());
+    for (auto& entry : entries) {
+        if (keys_.empty() || keys_.back() != entry.first) {
+            keys_.push_back(entry.first);
+            offsets_.push_back(references_.size());
+        }
+        if (entry.second.instance == nullptr) {
+            entry.second.instance = resolver(entry.second.id);
+        }
+        references_.push_back(entry.second);
+    }
+    offsets_.push_back(references_.size());
+}
+
+size_t inverse_index::count(int referenced) const {
+    auto range = range_(referenced);
+    size_t n = 0;
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (references_[i].id != 0) {
+            ++n;
+        }
+    }
+    for (auto it = delta_.lower_bound(first_key_(referenced)); it != delta_.upper_bound(last_key_(referenced)); ++it) {
+        n += it->second.size();
+    }
+    return n;
+}
+
+std::vector<int> inverse_index::referenced() const {
+    std::vector<int> names;
+    names.reserve(keys_.size() + delta_.size());
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        for (size_t j = offsets_[i]; j < offsets_[i + 1]; ++j) {
+            if (references_[j].id != 0) {
+                names.push_back(keys_[i]);
+                break;
+            }
+        }
+    }
+    const size_t flat = names.size();
+    for (const auto& pair : delta_) {
+        if (names.size() == flat || names.back() != std::get<0>(pair.first)) {
+            names.push_back(std::get<0>(pair.first));
+        }
+    }
+    std::inplace_merge(names.begin(), names.begin() + flat, names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+void inverse_index::clear() {
+    keys_.clear();
+    offsets_.clear();
+    references_.clear();
+    removed_ = 0;
+    appended_.clear();
+    appended_.shrink_to_fit();
+    delta_.clear();
+    delta_size_ = 0;
+}
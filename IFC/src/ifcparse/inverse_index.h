@@ -0,0 +1,178 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+
+#ifndef INVERSE_INDEX_H
+#define INVERSE_INDEX_H
+
+#include "ifc_parse_api.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace IfcUtil {
+    class IfcBaseClass;
+}
+
+namespace IfcParse {
+
+/// Index of inverse references: for every referenced instance name the
+/// instances that refer to it, keyed by the schema index of the entity type
+/// of the referring instance and the index of the attribute that refers.
+///
+/// The bulk of the references is stored in compressed sparse row form: a
+/// sorted array of referenced names with offsets into a flat array of
+/// references, each range ordered by type, attribute and insertion. The
+/// references found while loading a file are appended unordered and sorted
+/// into the flat arrays in one go by compact(). References added afterwards
+/// go into a small ordered delta and removals mark the flat references as
+/// removed in place, until needs_compaction() signals to merge them again.
+class IFC_PARSE_API inverse_index {
+  public:
+    struct reference {
+        // The referring instance, resolved by compact(), or null when it was not found
+        IfcUtil::IfcBaseClass* instance;
+        // The name of the referring instance, 0 for removed references
+        int id;
+        short type;
+        short attribute;
+    };
+
+    typedef std::function<IfcUtil::IfcBaseClass*(int)> resolver_t;
+
+  private:
+    typedef std::tuple<int, short, short> key_t;
+
+    std::vector<int> keys_;
+    std::vector<size_t> offsets_;
+    std::vector<reference> references_;
+    size_t removed_ = 0;
+
+    std::vector<std::pair<int, reference>> appended_;
+
+    std::map<key_t, std::vector<int>> delta_;
+    size_t delta_size_ = 0;
+
+    std::pair<size_t, size_t> range_(int referenced) const;
+    static key_t first_key_(int referenced);
+    static key_t last_key_(int referenced);
+
+    // Visits the references with keys in [first, last] that share the referenced
+    // name of both. The subrange of the flat references is found by binary search.
+    template <typename Fn>
+    void for_each_between_(const key_t& first, const key_t& last, Fn& fn) const {
+        auto range = range_(std::get<0>(first));
+        auto less = [](const reference& ref, const std::pair<short, short>& k) {
+            return std::make_pair(ref.type, ref.attribute) < k;
+        };
+        auto greater = [](const std::pair<short, short>& k, const reference& ref) {
+            return k < std::make_pair(ref.type, ref.attribute);
+        };
+        auto it = std::lower_bound(references_.begin() + range.first, references_.begin() + range.second, std::make_pair(std::get<1>(first), std::get<2>(first)), less);
+        auto end = std::upper_bound(it, references_.begin() + range.second, std::make_pair(std::get<1>(last), std::get<2>(last)), greater);
+        auto jt = delta_.lower_bound(first);
+        auto jt_end = delta_.upper_bound(last);
+        while (it != end || jt != jt_end) {
+            if (jt == jt_end || (it != end && std::make_pair(it->type, it->attribute) <= std::make_pair(std::get<1>(jt->first), std::get<2>(jt->first)))) {
+                if (it->id != 0) {
+                    fn(*it);
+                }
+                ++it;
+            } else {
+                for (int id : jt->second) {
+                    fn(reference{nullptr, id, std::get<1>(jt->first), std::get<2>(jt->first)});
+                }
+                ++jt;
+            }
+        }
+    }
+
+  public:
+    /// Appends a reference found while loading a file, in the order of the file.
+    /// The reference is visible to lookups after the next compact().
+    void append(int referenced, short type, short attribute, int id) {
+        appended_.push_back({referenced, {nullptr, id, type, attribute}});
+    }
+
+    /// Appends the appended references of other, which is left empty
+    void append(inverse_index& other);
+
+    /// Adds a reference after loading
+    void add(int referenced, short type, short attribute, int id);
+
+    /// Removes the first reference from id to referenced at type and attribute
+    void remove(int referenced, short type, short attribute, int id);
+
+    /// Removes all references to referenced
+    void remove_references_to(int referenced);
+
+    /// Removes all references from id to referenced
+    void remove_references_from(int referenced, int id);
+
+    /// Removes all references for which pred(referenced, id) holds
+    void remove_if(const std::function<bool(int, int)>& pred);
+
+    /// Whether there are appended references, or the delta or the removed
+    /// references have grown large enough to be merged into the flat arrays
+    bool needs_compaction() const;
+
+    /// Sorts the appended references and the delta into the flat arrays, dropping
+    /// the removed references. Referring instances are resolved once using resolver.
+    void compact(const resolver_t& resolver);
+
+    /// Calls fn(const reference&) for all references to referenced in the order of
+    /// type, attribute and insertion. References from the delta are not resolved.
+    template <typename Fn>
+    void for_each(int referenced, Fn fn) const {
+        for_each_between_(first_key_(referenced), last_key_(referenced), fn);
+    }
+
+    /// Calls fn(const reference&) for the references to referenced from instances
+    /// of type, only at attribute unless attribute is -1, in the same order.
+    template <typename Fn>
+    void for_each(int referenced, short type, short attribute, Fn fn) const {
+        if (attribute == -1) {
+            for_each_between_(key_t{referenced, type, std::numeric_limits<short>::min()}, key_t{referenced, type, std::numeric_limits<short>::max()}, fn);
+        } else {
+            for_each_between_(key_t{referenced, type, attribute}, key_t{referenced, type, attribute}, fn);
+        }
+    }
+
+    /// Returns the number of references to referenced
+    size_t count(int referenced) const;
+
+    /// Returns the referenced names in the flat arrays in ascending order. After
+    /// compact() these are all names that are referenced.
+    const std::vector<int>& keys() const { return keys_; }
+
+    /// Returns the referenced names in the flat arrays and in the delta in
+    /// ascending order, without compacting.
+    std::vector<int> referenced() const;
+
+    void clear();
+};
+
+} // namespace IfcParse
+
+#endif
@@ -0,0 +1,265 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Compares the tokens per second of IfcSpfLexer::Next() with a reference loop  *
+ * that advances one character at a time with Peek() and Inc(), as the lexer   *
+ * did before it scanned runs of characters in bulk, on synthetic SPF data.     *
+ * Checks that both produce the same tokens.                                    *
+ *                                                                              *
+ * Usage: lexer_benchmark [number of instances] [repetitions]                   *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../../ifcparse/IfcParse.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Normally called when an IfcFile is initialized, needed to parse the real numbers of GeneralTokenPtr()
+void init_locale();
+
+using namespace IfcParse;
+
+namespace {
+// Generates a data section with points, loops and products, with the
+// strings, comments and line breaks that the bulk scans need to stop at.
+std::string synthetic_spf(int num_instances) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> coordinate(-1000., 1000.);
+    std::uniform_int_distribution<int> kind(0, 9);
+
+    std::string s =
+        "ISO-10303-21;\n"
+        "HEADER;\n"
+        "FILE_DESCRIPTION(('ViewDefinition [CoordinationView]'),'2;1');\n"
+        "FILE_NAME('synthetic.ifc','2024-01-01T00:00:00',(''),(''),'','','');\n"
+        "FILE_SCHEMA(('IFC2X3'));\n"
+        "ENDSEC;\n"
+        "DATA;\n";
+
+    char buffer[256];
+    for (int i = 1; i <= num_instances; ++i) {
+        const int k = kind(rng);
+        if (k < 6) {
+            snprintf(buffer, sizeof(buffer), "#%d=IFCCARTESIANPOINT((%.6f,%.6f,%.6f));\n", i, coordinate(rng), coordinate(rng), coordinate(rng));
+            s += buffer;
+        } else if (k < 8) {
+            snprintf(buffer, sizeof(buffer), "#%d=IFCPOLYLOOP((#%d,#%d,#%d,#%d));\n", i, 1 + i / 2, 1 + i / 3, 1 + i / 4, 1 + i / 5);
+            s += buffer;
+        } else if (k < 9) {
+            snprintf(buffer, sizeof(buffer),
+                "#%d=IFCWALLSTANDARDCASE('2O2Fr$t4X7Zf8NOew3FL%02d',#1,'Basic Wall:Interior - 138mm Partition (1-hr):%d',"
+                "'It''s a wall with an escaped \\X2\\00E4\\X0\\ character',$,#%d,#%d,'%d');\n",
+                i, i % 100, i, 1 + i / 2, 1 + i / 3, i);
+            s += buffer;
+        } else {
+            snprintf(buffer, sizeof(buffer), "/* instance %d */\n#%d=IFCPROPERTYSINGLEVALUE('Reference',$,\n  IFCIDENTIFIER('Basic Wall %d'),$);\n", i, i, i);
+            s += buffer;
+        }
+    }
+
+    s += "ENDSEC;\nEND-ISO-10303-21;\n";
+    return s;
+}
+
+bool is_delimiter(char c) {
+    return c == '(' || c == ')' || c == '=' || c == ',' || c == ';' || c == '/';
+}
+
+// The lexer before the bulk scans, one character at a time with Peek() and Inc()
+class reference_lexer {
+  private:
+    IfcSpfLexer* lexer_;
+    IfcSpfStream* stream_;
+
+    unsigned int skip_whitespace() {
+        unsigned int index = 0;
+        while (!stream_->eof) {
+            const char c = stream_->Peek();
+            if (c == ' ' || c == '\r' || c == '\n' || c == '\t') {
+                stream_->Inc();
+                ++index;
+            } else {
+                break;
+            }
+        }
+        return index;
+    }
+
+    unsigned int skip_comment() {
+        if (stream_->Peek() != '/') {
+            return 0;
+        }
+        stream_->Inc();
+        if (stream_->Peek() != '*') {
+            stream_->Seek(stream_->Tell() - 1);
+            return 0;
+        }
+        unsigned int index = 2;
+        char intermediate = 0;
+        while (!stream_->eof) {
+            const char c = stream_->Peek();
+            stream_->Inc();
+            ++index;
+            if (c == '/' && intermediate == '*') {
+                break;
+            }
+            intermediate = c;
+        }
+        return index;
+    }
+
+    // Skips the remainder of a string, escape sequences do not contain apostrophes
+    void skip_string() {
+        while (!stream_->eof) {
+            const char c = stream_->Peek();
+            stream_->Inc();
+            if (c == '\'') {
+                if (stream_->eof || stream_->Peek() != '\'') {
+                    return;
+                }
+                stream_->Inc();
+            }
+        }
+    }
+
+  public:
+    reference_lexer(IfcSpfLexer* lexer)
+        : lexer_(lexer)
+        , stream_(lexer->stream)
+    {}
+
+    Token next() {
+        if (stream_->eof) {
+            return NoneTokenPtr();
+        }
+
+        while (skip_whitespace() != 0U || skip_comment() != 0U) {
+        }
+
+        if (stream_->eof) {
+            return NoneTokenPtr();
+        }
+
+        const unsigned int pos = stream_->Tell();
+        char c = stream_->Peek();
+
+        if ((is_delimiter(c) && c != '/') || c == '$' || c == '*') {
+            stream_->Inc();
+            return OperatorTokenPtr(lexer_, pos, pos + 1);
+        }
+
+        int len = 0;
+        while (!stream_->eof) {
+            c = stream_->Peek();
+            if (len != 0 && is_delimiter(c)) {
+                break;
+            }
+            stream_->Inc();
+            len++;
+            if (c == '\'') {
+                skip_string();
+            }
+        }
+
+        return len != 0 ? GeneralTokenPtr(lexer_, pos, stream_->Tell()) : NoneTokenPtr();
+    }
+};
+
+template <typename Fn>
+double time_tokens(Fn&& next, std::vector<Token>& tokens) {
+    tokens.clear();
+    auto t0 = std::chrono::steady_clock::now();
+    for (;;) {
+        Token t = next();
+        if (t.type == Token_NONE) {
+            break;
+        }
+        tokens.push_back(t);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+bool same_tokens(const std::vector<Token>& a, const std::vector<Token>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].startPos != b[i].startPos || a[i].type != b[i].type) {
+            std::cerr << "Token " << i << " differs at offset " << a[i].startPos << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int num_instances = argc > 1 ? atoi(argv[1]) : 500000;
+    const int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+
+    const std::string spf = synthetic_spf(num_instances);
+
+    init_locale();
+
+    // The stream takes ownership of the data, the lexers read views on it
+    char* data = new char[spf.size()];
+    memcpy(data, spf.data(), spf.size());
+    IfcSpfStream stream(data, (int)spf.size());
+
+    std::vector<Token> reference_tokens, tokens;
+    double reference_time = 1e9, time = 1e9;
+
+    for (int i = 0; i < repetitions; ++i) {
+        {
+            IfcSpfStream view(stream, 0, stream.End());
+            IfcSpfLexer lexer(&view, nullptr);
+            reference_lexer reference(&lexer);
+            reference_time = std::min(reference_time, time_tokens([&reference]() { return reference.next(); }, reference_tokens));
+        }
+        {
+            IfcSpfStream view(stream, 0, stream.End());
+            IfcSpfLexer lexer(&view, nullptr);
+            time = std::min(time, time_tokens([&lexer]() { return lexer.Next(); }, tokens));
+        }
+    }
+
+    if (!same_tokens(reference_tokens, tokens)) {
+        std::cerr << "IfcSpfLexer::Next() and the reference loop produce different tokens" << std::endl;
+        return 1;
+    }
+
+    const double mb = spf.size() / 1024. / 1024.;
+    const double mtokens = tokens.size() / 1e6;
+
+    std::cout << spf.size() << " bytes, " << tokens.size() << " tokens, best of " << repetitions << std::endl;
+    std::cout << "Peek()/Inc() reference: " << mtokens / reference_time << " Mtokens/s, " << mb / reference_time << " MB/s" << std::endl;
+    std::cout << "IfcSpfLexer::Next():    " << mtokens / time << " Mtokens/s, " << mb / time << " MB/s" << std::endl;
+    std::cout << "Speedup: " << reference_time / time << "x" << std::endl;
+
+    return 0;
+}
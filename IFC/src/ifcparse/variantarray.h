@@ -27,16 +27,100 @@ variant - which is the maximum size of its constituents - is reduced.
 #ifndef VARIANTARRAY_H
 #define VARIANTARRAY_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
 #include <memory>
+#include <new>
 #include <tuple>
+#include <vector>
 
+#include "ifc_parse_api.h"
 #include "IfcException.h"
 
 namespace impl {
+    // A bump allocator that hands out memory from large chunks, which are only
+    // released together when the arena is destroyed. While an arena is current
+    // on a thread, see arena_scope, VariantArrays created on that thread take
+    // their storage and boxed values from it instead of from the heap.
+    class arena {
+    public:
+        static const std::size_t chunk_size = 1 << 20;
+
+        arena() = default;
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        void* allocate(std::size_t size, std::size_t alignment) {
+            std::size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+            if (chunks_.empty() || offset + size > capacity_) {
+                capacity_ = (std::max)(chunk_size, size);
+                chunks_.emplace_back(new char[capacity_]);
+                offset = 0;
+            }
+            offset_ = offset + size;
+            return chunks_.back().get() + offset;
+        }
+
+        // Takes ownership of the chunks of other, allocation continues in the
+        // current chunk of this arena.
+        void splice(arena& other) {
+            chunks_.insert(chunks_.begin(), std::make_move_iterator(other.chunks_.begin()), std::make_move_iterator(other.chunks_.end()));
+            other.chunks_.clear();
+            other.offset_ = other.capacity_ = 0;
+        }
+
+        static arena*& current() {
+            static my_thread_local arena* current_arena = nullptr;
+            return current_arena;
+        }
+
+    private:
+        std::vector<std::unique_ptr<char[]>> chunks_;
+        std::size_t offset_ = 0;
+        std::size_t capacity_ = 0;
+    };
+
+    // Makes an arena current on this thread for the lifetime of the scope
+    class arena_scope {
+    public:
+        arena_scope(arena* a)
+            : previous_(arena::current())
+        {
+            arena::current() = a;
+        }
+
+        ~arena_scope() {
+            arena::current() = previous_;
+        }
+
+        arena_scope(const arena_scope&) = delete;
+        arena_scope& operator=(const arena_scope&) = delete;
+
+    private:
+        arena* previous_;
+    };
+
+    // Deleter for boxed values that only runs the destructor when the value
+    // lives in an arena.
+    template <typename T>
+    struct arena_deleter {
+        bool in_arena = false;
+
+        void operator()(T* ptr) const {
+            if (in_arena) {
+                ptr->~T();
+            } else {
+                delete ptr;
+            }
+        }
+    };
+
     // Trait to detect unique_ptr
     template <typename...> struct is_unique_ptr : std::false_type {};
     template<class T, typename... Args>
@@ -86,7 +170,7 @@ namespace impl {
         using type = typename std::conditional<
             is_small_object<T>::value,
             T,
-            std::unique_ptr<T>
+            std::unique_ptr<T, arena_deleter<T>>
         >::type;
     };
 
@@ -130,20 +214,31 @@ class VariantArray {
 public:
     using TypesTuple = ::impl::MapTypes_t<Types...>;
 
-    VariantArray(size_t size)
-        : size_and_indices_(new uint8_t[size + 1])
-        , storage_(size ? new StorageType[size] : nullptr)
-    {
-        if (size) {
-            size_and_indices_[0] = (uint8_t)size;
-            memset(size_and_indices_ + 1, 0, sizeof(uint8_t) * size);
-            for (size_t i = 0; i < size; ++i) {
-                // type 0 needs to be default constructable
-                set(i, typename std::tuple_element<0, std::tuple<Types...>>::type{});
-            }
+    VariantArray(size_t size) {
+        // A single allocation holds the storage, followed by the size, the type
+        // indices and a flag whether the allocation belongs to an arena.
+        const std::size_t bytes = size * sizeof(StorageType) + size + 2;
+        ::impl::arena* arena = ::impl::arena::current();
+        uint8_t* block = static_cast<uint8_t*>(arena
+            ? arena->allocate(bytes, alignof(StorageType))
+            : ::operator new(bytes));
+        storage_ = size ? reinterpret_cast<StorageType*>(block) : nullptr;
+        size_and_indices_ = block + size * sizeof(StorageType);
+        size_and_indices_[0] = (uint8_t)size;
+        memset(size_and_indices_ + 1, 0, sizeof(uint8_t) * size);
+        size_and_indices_[size + 1] = arena != nullptr;
+        for (size_t i = 0; i < size; ++i) {
+            // type 0 needs to be default constructable
+            set(i, typename std::tuple_element<0, std::tuple<Types...>>::type{});
         }
     }
 
+    // An array without elements that does not allocate, as left behind by a move
+    VariantArray() noexcept
+        : size_and_indices_(nullptr)
+        , storage_(nullptr)
+    {}
+
     VariantArray(VariantArray&& other) noexcept
         : size_and_indices_(other.size_and_indices_)
         , storage_(other.storage_)
@@ -183,7 +278,11 @@ public:
         using V = typename std::tuple_element<::impl::TypeIndex_v<U, Types...>, ::impl::MapTypes_t<Types... >>::type;
         // std::wcout << "setting " << index << " to " << typeid(V).name() << " (" << ::impl::TypeIndex_v<U, Types...> << ")" << std::endl;
         if constexpr (::impl::is_unique_ptr<V>::value) {
-            new(&storage_[index]) V(new U(value));
+            if (::impl::arena* arena = ::impl::arena::current()) {
+                new(&storage_[index]) V(new(arena->allocate(sizeof(U), alignof(U))) U(std::forward<T>(value)), ::impl::arena_deleter<U>{true});
+            } else {
+                new(&storage_[index]) V(new U(std::forward<T>(value)));
+            }
         } else {
             new(&storage_[index]) U(std::forward<T>(value));
         }
@@ -255,11 +354,13 @@ private:
 
     void free_() {
         if (size_and_indices_) {
-            for (std::size_t i = 0; i < size_and_indices_[0]; ++i) {
+            const std::size_t size = size_and_indices_[0];
+            for (std::size_t i = 0; i < size; ++i) {
                 destroy_at_index(i);
             }
-            delete[] size_and_indices_;
-            delete[] storage_;
+            if (!size_and_indices_[size + 1]) {
+                ::operator delete(storage_ ? static_cast<void*>(storage_) : static_cast<void*>(size_and_indices_));
+            }
         }
     }
 